@@ -6,7 +6,11 @@ Class file for AD5253/AD5254 digital potentiometer Arduino library.
 #include <AD525x_Errors.h>
 #include <Arduino.h>
 
-uint8_t AD525x::initialize(uint8_t AD_addr) {
+AD525xBusMonitor AD525x::bus_monitor = NULL;
+void *AD525x::bus_monitor_context = NULL;
+TwoWire *AD525x::buses[AD525X_MAX_BUSES] = {&Wire};
+
+uint8_t AD525x::initialize(uint8_t AD_addr, TwoWire &wire) {
     /** Initialize the potentiometer - pass `(AD1<<1 | AD0)` to AD_addr to set the device address.
 
     Starts I2C communications with the specified device (specified via the `AD1` and `AD0` pins on
@@ -16,8 +20,14 @@ uint8_t AD525x::initialize(uint8_t AD_addr) {
     If an invalid address is specified, `err_code` is set to `EC_BAD_DEVICE_ADDR`. This can be
     queried via `get_err_code()`.
 
+    On boards with several I2C controllers, pass the controller the device is wired to, e.g.
+    `Wire1`. Up to `AD525X_MAX_BUSES` distinct controllers can be used; the device stores only a
+    3-bit index into a table shared by all objects. If the table is full, `err_code` is set to
+    `EC_NO_RESOURCES`.
+
     @param[in] AD_addr The two bit user-specified address of the device with which you are 
                        communicating. Should be (AD1<<1 | AD0). 
+    @param[in] wire    The I2C controller of the device. Defaults to `Wire`.
 
     @return Returns 0 on no error or the error code on error.
     */
@@ -29,9 +39,23 @@ uint8_t AD525x::initialize(uint8_t AD_addr) {
         return err_code;
     }
 
-    dev_addr = AD525x::base_I2C_addr | AD_addr;
+    uint8_t index = 0;
+    while (index < AD525X_MAX_BUSES && AD525x::buses[index] != NULL &&
+           AD525x::buses[index] != &wire) {
+        index++;
+    }
+
+    if (index == AD525X_MAX_BUSES) {
+        initialized = false;
+        err_code = EC_NO_RESOURCES;
+        return err_code;
+    }
+
+    AD525x::buses[index] = &wire;
+    bus = index;
+    addr = AD_addr;
 
-    Wire.begin();                               // Start I2C communications.
+    wire.begin();                               // Start I2C communications.
 
     initialized = true;
     return 0;
@@ -67,8 +91,15 @@ uint8_t AD525x::write_RDAC(uint8_t RDAC, uint8_t value) {
         return err_code;
     }
 
-    uint8_t instr_addr = AD525x::RDAC_register | RDAC;
+    uint8_t instr_addr = RDAC_instruction(RDAC);
     err_code = write_data(instr_addr, value);
+
+    if (err_code) {
+        wiper_known &= ~(1 << RDAC);        // Write may or may not have landed.
+    } else {
+        cache_wiper(RDAC, value);
+    }
+
     return err_code;
 }
 
@@ -91,26 +122,143 @@ uint8_t AD525x::read_RDAC(uint8_t RDAC) {
             - \c `EC_BAD_REGISTER`: Raised if the supplied RDAC register exceeds the maximum value 
                                    (3).
     */
+    return read_RDAC_result(RDAC).value;
+}
+
+AD525xResult AD525x::read_RDAC_result(uint8_t RDAC) {
+    /** Read the wiper setting from the specified RDAC register, returning value and error together.
+
+    Same as `read_RDAC()`, but the error code travels with the value, so no `get_err_code()` call
+    is needed and a 0 wiper is never confused with an error.
+
+    @param[in] RDAC     The address of one of the 4 RDAC registers (0-3).
+
+    @return Returns the wiper value and the error code. See `read_RDAC()` for the errors raised.
+    */
     if(!initialized) {
         err_code = EC_NOT_INITIALIZED;
-        return 0;
+        return {0, EC_NOT_INITIALIZED};
     }
 
     if(RDAC > AD525x::max_RDAC_register) {
         err_code = EC_BAD_REGISTER;
-        return 0;
+        return {0, EC_BAD_REGISTER};
     }
 
-    uint8_t instr_addr = AD525x::RDAC_register | RDAC;
+    uint8_t instr_addr = RDAC_instruction(RDAC);
 
-    uint8_t rv = read_data_byte(instr_addr);
-    if(get_err_code() != 0) {
-        return 0;       // Err code set in read_data already.
+    AD525xResult rv = read_data_byte(instr_addr);
+    if(rv.ok()) {
+        cache_wiper(RDAC, rv.value);
     }
 
     return rv;
 }
 
+uint8_t AD525x::move_RDAC(uint8_t RDAC, uint8_t value) {
+    /** Move the RDAC wiper to `value` using the cheapest bus transaction available.
+
+    If the current wiper value is known (from a previous write or read through this object), a move
+    to the same value costs no bus traffic at all, and a move of a single step is issued as an
+    increment/decrement command, which is one byte shorter than a full `write_RDAC()`. Any other move,
+    or a move from an unknown state, falls back to `write_RDAC()`.
+
+    @param[in] RDAC     The address of one of the 4 RDAC registers (0-3).
+    @param[in] value    The target wiper setting, in the span [0, `max_val`].
+
+    @return Returns 0 on no error, otherwise returns the error code raised by `write_RDAC()`,
+            `increment_RDAC()` or `decrement_RDAC()`.
+    */
+    if(!initialized) {  return (err_code = EC_NOT_INITIALIZED); }
+    if(RDAC > AD525x::max_RDAC_register) {  return (err_code = EC_BAD_REGISTER); }
+
+    if(wiper_known & (1 << RDAC)) {
+        uint8_t current = wiper[RDAC];
+
+        if(value == current) {  return (err_code = EC_NO_ERR); }
+        if(value == current + 1 && value <= this->get_max_val()) {  return increment_RDAC(RDAC); }
+        if(value + 1 == current) {  return decrement_RDAC(RDAC); }
+    }
+
+    return write_RDAC(RDAC, value);
+}
+
+uint8_t AD525x::read_RDAC_cached(uint8_t RDAC) {
+    /** Read the wiper setting from the cache, falling back to `read_RDAC()` if it is unknown.
+
+    Values written or read through this object are remembered, so this avoids a bus transaction
+    whenever the wiper has not been changed by something else (e.g. a restore from EEMEM, or another
+    bus master). Call `invalidate_cache()` if the device may have been changed behind this object's
+    back.
+
+    @param[in] RDAC     The address of one of the 4 RDAC registers (0-3).
+
+    @return Returns the wiper value or 0 on error. See `read_RDAC()`.
+    */
+    return read_RDAC_cached_result(RDAC).value;
+}
+
+AD525xResult AD525x::read_RDAC_cached_result(uint8_t RDAC) {
+    /** As `read_RDAC_cached()`, returning value and error together. A cached wiper costs only a
+    bit test and no bus transaction.
+
+    @param[in] RDAC     The address of one of the 4 RDAC registers (0-3).
+
+    @return Returns the wiper value and the error code. See `read_RDAC()` for the errors raised.
+    */
+    if(initialized && RDAC <= AD525x::max_RDAC_register && (wiper_known & (1 << RDAC))) {
+        err_code = EC_NO_ERR;
+        return {wiper[RDAC], EC_NO_ERR};
+    }
+
+    return read_RDAC_result(RDAC);
+}
+
+bool AD525x::is_cached(uint8_t RDAC) {
+    /** Check whether the wiper value of `RDAC` is known without a bus transaction.
+
+    @param[in] RDAC     The address of one of the 4 RDAC registers (0-3).
+
+    @return Returns true if `read_RDAC_cached()` would be served from the cache.
+    */
+    return RDAC <= AD525x::max_RDAC_register && (wiper_known & (1 << RDAC));
+}
+
+bool AD525x::peek_RDAC(uint8_t RDAC, uint8_t *value) {
+    /** Look up a cached wiper value with no side effects: unlike `read_RDAC_cached()`, this never
+    goes to the bus and leaves the error code alone, so planners can call it freely.
+
+    @param[in]  RDAC    The address of one of the 4 RDAC registers (0-3).
+    @param[out] value   Receives the cached wiper value, if there is one.
+
+    @return Returns true if the value is cached, false otherwise (`value` is then unchanged).
+    */
+    if (!initialized || !is_cached(RDAC)) { return false; }
+
+    *value = wiper[RDAC];
+    return true;
+}
+
+void AD525x::set_cached_RDAC(uint8_t RDAC, uint8_t value) {
+    /** Seed the cache with a wiper value known from elsewhere, without a bus transaction.
+
+    Intended for restoring state saved across a restart (see `AD525x_Journal.h`). A wrong value
+    here makes `move_RDAC()` pick the wrong command, so only use values that are known to be on
+    the device.
+
+    @param[in] RDAC     The address of one of the 4 RDAC registers (0-3).
+    @param[in] value    The wiper value the device is known to hold.
+    */
+    if (RDAC > AD525x::max_RDAC_register || value > this->get_max_val()) { return; }
+
+    cache_wiper(RDAC, value);
+}
+
+void AD525x::invalidate_cache() {
+    /** Forget all cached wiper values, forcing the next `read_RDAC_cached()` to go to the device. */
+    wiper_known = 0;
+}
+
 uint8_t AD525x::write_EEMEM(uint8_t reg, uint8_t value) {
     /**   Write to the EEMEM non-volatile memory register. 
 
@@ -133,14 +281,14 @@ uint8_t AD525x::write_EEMEM(uint8_t reg, uint8_t value) {
 
     if (!initialized) { return (err_code =  EC_NOT_INITIALIZED);  }     // Must be initialized
 
-    if (reg <= AD525x::max_RDAC_register && value < this->get_max_val()) {
+    if (reg <= AD525x::max_RDAC_register && value > this->get_max_val()) {
         // Fairly sure the max value only applies to the RDAC registers, not the EEMEM.
        return (err_code = EC_BAD_WIPER_SETTING);
     }
 
     if(reg > AD525x::max_EEMEM_register) {  return (err_code = EC_BAD_REGISTER); }
 
-    uint8_t instr_addr = AD525x::EEMEM_register | reg;
+    uint8_t instr_addr = EEMEM_instruction(reg);
 
     err_code = write_data(instr_addr, value);
     return err_code;
@@ -166,25 +314,30 @@ uint8_t AD525x::read_EEMEM(uint8_t reg) {
             - \c `EC_NOT_INITIALIZED`: Raised of the potentiometer object is not initialized.
             - \c `EC_BAD_REGISTER`: An invalid register address was provided.
     */
+    return read_EEMEM_result(reg).value;
+}
+
+AD525xResult AD525x::read_EEMEM_result(uint8_t reg) {
+    /** Read an EEMEM register, returning value and error together.
+
+    @param[in] reg The EEMEM register whose value you want to query [0-15].
 
+    @return Returns the register value and the error code. See `read_EEMEM()` for the errors
+            raised.
+    */
     if (!initialized) {
         err_code = EC_NOT_INITIALIZED;
-        return 0;
+        return {0, EC_NOT_INITIALIZED};
     }
 
     if (reg > AD525x::max_EEMEM_register) {
         err_code = EC_BAD_REGISTER;
-        return 0;
+        return {0, EC_BAD_REGISTER};
     }
 
-    uint8_t instr_addr = AD525x::EEMEM_register | reg;
+    uint8_t instr_addr = EEMEM_instruction(reg);
 
-    uint8_t rv = read_data_byte(instr_addr);
-    if (get_err_code() != 0) {
-        return 0;       // Err code set in read_data already.
-    }
-
-    return rv;
+    return read_data_byte(instr_addr);
 }
 
 float AD525x::read_tolerance(uint8_t RDAC) {
@@ -209,42 +362,49 @@ float AD525x::read_tolerance(uint8_t RDAC) {
             - \c `EC_NOT_INITIALIZED` Raised if the object has not been initialized.
             - \c `EC_BAD_REGISTER` Raised if an invalid register is passed to the function.
     */
+    return read_tolerance_result(RDAC).value;
+}
+
+AD525xToleranceResult AD525x::read_tolerance_result(uint8_t RDAC) {
+    /** Read the RAB tolerance in percent, returning value and error together.
+
+    @param[in] RDAC The RDAC register whose tolerance you would like to query.
 
+    @return Returns the tolerance and the error code. See `read_tolerance()` for the errors raised.
+    */
     if (!initialized) {
         err_code = EC_NOT_INITIALIZED;
-        return 0;
+        return {0, EC_NOT_INITIALIZED};
     }
 
     if (RDAC > AD525x::max_RDAC_register) {
         err_code = EC_BAD_REGISTER;
-        return 0;
+        return {0, EC_BAD_REGISTER};
     }
 
-    uint8_t sign_mask = 0x80;
-
     // Shift RDAC by 1, low bit is integer / decimal.
     uint8_t instr_addr = AD525x::Tolerance_register | (RDAC << 1);
     uint8_t instr_addr_int = instr_addr | AD525x::Tol_int;
     uint8_t instr_addr_dec = instr_addr | AD525x::Tol_dec;
 
     // 8-bit signed integer
-    int8_t tol_int_data = (int8_t)read_data_byte(instr_addr_int);
-    if(err_code) {
-        return 0;
+    AD525xResult tol_int = read_data_byte(instr_addr_int);
+    if(!tol_int.ok()) {
+        return {0, tol_int.err};
     }
 
     // Fractional portion - 8 bits - interpret as (value*2e-8)
-    uint8_t tol_dec_data = read_data_byte(instr_addr_dec);
-    if(err_code) {
-        return 0;
+    AD525xResult tol_dec = read_data_byte(instr_addr_dec);
+    if(!tol_dec.ok()) {
+        return {0, tol_dec.err};
     }
 
     // Convert to signed float - there may be a better way to do this, but this seems OK.
     float output;
-    output = float(tol_int_data);
+    output = float((int8_t)tol_int.value);
     
-    float frac_portion = float(tol_dec_data)/256.0 * ((output < 0)?-1:1);
-    return output + frac_portion;
+    float frac_portion = float(tol_dec.value)/256.0 * ((output < 0)?-1:1);
+    return {output + frac_portion, EC_NO_ERR};
 }
 
 //
@@ -280,6 +440,7 @@ uint8_t AD525x::restore_RDAC(uint8_t RDAC) {
     if (!initialized) { return (err_code = EC_NOT_INITIALIZED); }
     if (RDAC > AD525x::max_RDAC_register) { return (err_code = EC_BAD_REGISTER); }
 
+    wiper_known &= ~(1 << RDAC);
     return write_cmd(AD525x::CMD_Restore_RDAC | RDAC);
 }
 
@@ -292,6 +453,7 @@ uint8_t AD525x::restore_all_RDAC() {
     */
     if (!initialized) { return (err_code = EC_NOT_INITIALIZED); }
 
+    wiper_known = 0;
     return write_cmd(AD525x::CMD_Restore_All_RDAC);
 }
 
@@ -311,7 +473,7 @@ uint8_t AD525x::store_RDAC(uint8_t RDAC) {
     if (!initialized) { return (err_code = EC_NOT_INITIALIZED); }
     if (RDAC > AD525x::max_RDAC_register) { return (err_code = EC_BAD_REGISTER); }
 
-    return write_cmd(AD525x::CMD_Store_RDAC | RDAC);
+    return write_cmd(store_instruction(RDAC));
 }
 
 uint8_t AD525x::decrement_RDAC(uint8_t RDAC) {
@@ -331,7 +493,13 @@ uint8_t AD525x::decrement_RDAC(uint8_t RDAC) {
     if (!initialized) { return (err_code = EC_NOT_INITIALIZED); }
     if (RDAC > AD525x::max_RDAC_register) { return (err_code = EC_BAD_REGISTER); }
 
-    return write_cmd(AD525x::CMD_Dec_RDAC_step | RDAC);   
+    if (write_cmd(AD525x::CMD_Dec_RDAC_step | RDAC)) {
+        wiper_known &= ~(1 << RDAC);
+        return err_code;
+    }
+
+    step_cached_wiper(RDAC, false);
+    return err_code;
 }
 
 uint8_t AD525x::increment_RDAC(uint8_t RDAC) {
@@ -351,7 +519,13 @@ uint8_t AD525x::increment_RDAC(uint8_t RDAC) {
     if (!initialized) { return (err_code = EC_NOT_INITIALIZED); }
     if (RDAC > AD525x::max_RDAC_register) { return (err_code = EC_BAD_REGISTER); }
 
-    return write_cmd(AD525x::CMD_Inc_RDAC_step | RDAC);   
+    if (write_cmd(AD525x::CMD_Inc_RDAC_step | RDAC)) {
+        wiper_known &= ~(1 << RDAC);
+        return err_code;
+    }
+
+    step_cached_wiper(RDAC, true);
+    return err_code;
 }
 
 uint8_t AD525x::decrement_RDAC_6dB(uint8_t RDAC) {
@@ -371,7 +545,8 @@ uint8_t AD525x::decrement_RDAC_6dB(uint8_t RDAC) {
     if (!initialized) { return (err_code = EC_NOT_INITIALIZED); }
     if (RDAC > AD525x::max_RDAC_register) { return (err_code = EC_BAD_REGISTER); }
 
-    return write_cmd(AD525x::CMD_Dec_RDAC_6dB | RDAC);   
+    wiper_known &= ~(1 << RDAC);
+    return write_cmd(AD525x::CMD_Dec_RDAC_6dB | RDAC);
 }
 
 uint8_t AD525x::increment_RDAC_6dB(uint8_t RDAC) {
@@ -391,7 +566,8 @@ uint8_t AD525x::increment_RDAC_6dB(uint8_t RDAC) {
     if (!initialized) { return (err_code = EC_NOT_INITIALIZED); }
     if (RDAC > AD525x::max_RDAC_register) { return (err_code = EC_BAD_REGISTER); }
 
-    return write_cmd(AD525x::CMD_Inc_RDAC_6dB | RDAC);   
+    wiper_known &= ~(1 << RDAC);
+    return write_cmd(AD525x::CMD_Inc_RDAC_6dB | RDAC);
 }
 
 uint8_t AD525x::decrement_all_RDAC() {
@@ -405,7 +581,15 @@ uint8_t AD525x::decrement_all_RDAC() {
     */
     if (!initialized) { return (err_code = EC_NOT_INITIALIZED); }
 
-    return write_cmd(AD525x::CMD_Dec_All_RDAC_step);   
+    if (write_cmd(AD525x::CMD_Dec_All_RDAC_step)) {
+        wiper_known = 0;
+        return err_code;
+    }
+
+    for (uint8_t i = 0; i <= AD525x::max_RDAC_register; i++) {
+        step_cached_wiper(i, false);
+    }
+    return err_code;
 }
 
 uint8_t AD525x::increment_all_RDAC() {
@@ -419,7 +603,15 @@ uint8_t AD525x::increment_all_RDAC() {
     */
     if (!initialized) { return (err_code = EC_NOT_INITIALIZED); }
 
-    return write_cmd(AD525x::CMD_Inc_All_RDAC_step);   
+    if (write_cmd(AD525x::CMD_Inc_All_RDAC_step)) {
+        wiper_known = 0;
+        return err_code;
+    }
+
+    for (uint8_t i = 0; i <= AD525x::max_RDAC_register; i++) {
+        step_cached_wiper(i, true);
+    }
+    return err_code;
 }
 
 uint8_t AD525x::decrement_all_RDAC_6dB() {
@@ -434,7 +626,8 @@ uint8_t AD525x::decrement_all_RDAC_6dB() {
     */
     if (!initialized) { return (err_code = EC_NOT_INITIALIZED); }
 
-    return write_cmd(AD525x::CMD_Dec_All_RDAC_6dB);   
+    wiper_known = 0;
+    return write_cmd(AD525x::CMD_Dec_All_RDAC_6dB);
 }
 
 uint8_t AD525x::increment_all_RDAC_6dB() {
@@ -449,37 +642,54 @@ uint8_t AD525x::increment_all_RDAC_6dB() {
     */
     if (!initialized) { return (err_code = EC_NOT_INITIALIZED); }
 
-    return write_cmd(AD525x::CMD_Inc_All_RDAC_6dB);   
+    wiper_known = 0;
+    return write_cmd(AD525x::CMD_Inc_All_RDAC_6dB);
 }
 
-//
-// Getter function for maximum value - not implemented for AD525x
-//
-
-uint8_t AD5253::get_max_val() {
+uint8_t AD525x::get_max_val() {
     /** Retrieve the maximum value of the wiper.
 
     The AD5253 and AD5254 differ only in their maximum wiper value, [0, 64) for AD5253 and [0, 256) 
-    for AD5254. This function is an interface that should return the maximum wiper value when called
-    from the child class objects. See `AD525x::get_max_val()`.
+    for AD5254. The variant is recorded by the child class constructor.
 
-    @return Returns the value stored in `AD5253::max_val`. (63)
+    @return Returns 63 for an AD5253 or 255 for an AD5254.
     */
 
-    return AD5253::max_val;
+    return wide ? AD525x::max_val_AD5254 : AD525x::max_val_AD5253;
 }
 
-uint8_t AD5254::get_max_val() {
-    /** Retrieve the maximum value of the wiper.
+uint8_t AD525x::get_dev_addr() {
+    /** Retrieve the full 7-bit I2C address of the device, or 0 if not initialized. */
+    return initialized ? i2c_addr() : 0;
+}
 
-    The AD5253 and AD5254 differ only in their maximum wiper value, [0, 64) for AD5253 and [0, 256) 
-    for AD5254. This function is an interface that should return the maximum wiper value when called
-    from the child class objects. See `AD525x::get_max_val()`.
+TwoWire &AD525x::get_bus() {
+    /** Retrieve the I2C controller the device was initialized on (`Wire` before `initialize()`). */
+    return wire();
+}
 
-    @return Returns the value stored in `AD5254::max_val`. (255)
+void AD525x::set_bus_monitor(AD525xBusMonitor monitor, void *context) {
+    /** Install a function called after every I2C transaction of every AD525x object, e.g. to
+    track error rates (see `AD525x_BusTuner.h`). Pass NULL to remove it.
+
+    @param[in] monitor The function to call, or NULL.
+    @param[in] context Passed through to `monitor` unchanged.
     */
+    AD525x::bus_monitor = monitor;
+    AD525x::bus_monitor_context = context;
+}
+
+AD525xBusMonitor AD525x::get_bus_monitor(void **context) {
+    /** Retrieve the function installed by `set_bus_monitor()`, so that a new monitor can chain to
+    it and later restore it.
 
-    return AD5254::max_val;
+    @param[out] context If not NULL, receives the context passed to `set_bus_monitor()`.
+
+    @return Returns the installed function, or NULL if there is none.
+    */
+    if (context != NULL) { *context = AD525x::bus_monitor_context; }
+
+    return AD525x::bus_monitor;
 }
 
 //
@@ -516,11 +726,13 @@ uint8_t AD525x::write_cmd(uint8_t cmd_register) {
             - \c `EC_NACK_DATA`: Received NACK on transmit of data.
             - \c `EC_I2C_OTHER`: Other I2C error.
     */
-    Wire.beginTransmission(dev_addr);
-    Wire.write(cmd_register);
+    TwoWire &w = wire();
 
-    err_code = Wire.endTransmission();
-    return err_code;
+    w.beginTransmission(i2c_addr());
+    w.write(cmd_register);
+
+    err_code = w.endTransmission();
+    return monitor_bus(err_code, 1);
 
 }
 
@@ -541,14 +753,16 @@ uint8_t AD525x::write_data(uint8_t register_addr, uint8_t data) {
             - \c `EC_NACK_DATA`: Received NACK on transmit of data.
             - \c `EC_I2C_OTHER`: Other I2C error.
     */
-    Wire.beginTransmission(dev_addr);
-    Wire.write(register_addr);
-    Wire.write(data);
-    err_code = Wire.endTransmission();
-    return err_code;
+    TwoWire &w = wire();
+
+    w.beginTransmission(i2c_addr());
+    w.write(register_addr);
+    w.write(data);
+    err_code = w.endTransmission();
+    return monitor_bus(err_code, 2);
 }
 
-uint8_t * AD525x::read_data(uint8_t register_addr, uint8_t length) {
+uint8_t AD525x::read_data(uint8_t register_addr, uint8_t *buff, uint8_t length) {
     /** Reads data of length `length` from register  `register_addr`
     
     This is a private function, called by specific-use functions such as `read_RDAC()` and 
@@ -556,52 +770,55 @@ uint8_t * AD525x::read_data(uint8_t register_addr, uint8_t length) {
     `register_addr`.
 
     @param register_addr The address of the register to read from.
+    @param buff Caller-supplied buffer of at least `length` bytes, which receives the data.
     @param length The length of the data stored in the register.
 
-    @return On success, returns a pointer to an array of `uint8_t` unsigned bytes retrieved from the
-            register. The returned array has length `length`, which in most cases will be 1. On 
-            error, this function returns a `NULL` pointer and sets `err_code` (query 
-            `get_err_code()` to get the value of this variable) to one of the I2C errors:
+    @return Returns 0 on success, with `length` bytes (in most cases 1) stored in `buff`. On error,
+            this function returns and sets `err_code` (query `get_err_code()` to get the value of
+            this variable) to one of the I2C errors:
             - \c `EC_NO_ERR`: No error.
             - \c `EC_DATA_LONG`: Data too long to fit in transmit buffer
             - \c `EC_NACK_ADDR`: Received NACK on transmit of address.
             - \c `EC_NACK_DATA`: Received NACK on transmit of data.
             - \c `EC_I2C_OTHER`: Other I2C error.
     */
-    
-    uint8_t error = 0;
+    TwoWire &w = wire();
 
-    Wire.beginTransmission(dev_addr);
-    Wire.write(register_addr);
-    err_code = Wire.endTransmission();
+    w.beginTransmission(i2c_addr());
+    w.write(register_addr);
+    err_code = w.endTransmission();
     if(err_code > 0) {
-        return NULL;
+        return monitor_bus(err_code, 1);
     }
 
-    Wire.beginTransmission(dev_addr);
-    uint8_t n_bytes = Wire.requestFrom(dev_addr, length);
+    w.beginTransmission(i2c_addr());
+    uint8_t n_bytes = w.requestFrom(i2c_addr(), length);
 
     if(n_bytes != length) {
         err_code = EC_BAD_READ_SIZE;
-        return NULL;
+        return monitor_bus(err_code, 1);
     }
 
-    uint8_t buff[length];
-    if(Wire.available() == length) {
+    if(w.available() == length) {
         for(int i = 0; i < length; i++) {
-            buff[i] = Wire.read();
+            buff[i] = w.read();
         }
     }
 
-    err_code = Wire.endTransmission();
-    if(err_code > 0) {
-        return NULL;
+    err_code = w.endTransmission();
+    return monitor_bus(err_code, 1 + length);
+}
+
+uint8_t AD525x::monitor_bus(uint8_t err, uint8_t bytes) {
+    /** Report a finished transaction to the bus monitor, if one is set. Returns `err`. */
+    if (AD525x::bus_monitor != NULL) {
+        AD525x::bus_monitor(AD525x::bus_monitor_context, &wire(), err, bytes);
     }
 
-    return buff;
+    return err;
 }
 
-uint8_t AD525x::read_data_byte(uint8_t register_addr) {
+AD525xResult AD525x::read_data_byte(uint8_t register_addr) {
     /** Reads a single byte from the specified register. Convenience wrapper for `read_data()`.
 
     This reads a single byte from the register specified at `register_addr` via a call to
@@ -609,15 +826,100 @@ uint8_t AD525x::read_data_byte(uint8_t register_addr) {
 
     @param[in] register_addr The register address from which to read a single byte.
     
-    @return Returns the requested value. If there is an error, returns 0 and `err_code` (retrieved
-    via `get_err_code()`) is set to a non-zero value. This is a simple wrapper for `read_data()`, so
-    it raises only the errors raised by that function.
+    @return Returns the requested value and the error code, which is also stored in `err_code`.
+    On error, the value is 0. This is a simple wrapper for `read_data()`, so it raises only the
+    errors raised by that function.
+    */
+
+    uint8_t value = 0;
+    uint8_t err = read_data(register_addr, &value, 1);
+
+    return {err ? (uint8_t)0 : value, err};
+}
+
+void AD525x::cache_wiper(uint8_t RDAC, uint8_t value) {
+    /** Record `value` as the known wiper setting of `RDAC`. */
+    wiper[RDAC] = value;
+    wiper_known |= (1 << RDAC);
+}
+
+void AD525x::step_cached_wiper(uint8_t RDAC, bool up) {
+    /** Apply a single increment/decrement to the cached wiper of `RDAC`, saturating at the ends of
+    the range as the device does. Unknown wipers stay unknown. */
+    if (!(wiper_known & (1 << RDAC))) { return; }
+
+    if (up && wiper[RDAC] < this->get_max_val()) {
+        wiper[RDAC]++;
+    } else if (!up && wiper[RDAC] > 0) {
+        wiper[RDAC]--;
+    }
+}
+
+//
+// AD525xBusyTable
+//
+AD525xBusyTable::AD525xBusyTable(AD525xBusySlot *slots, uint8_t n_slots) :
+    slots(slots), n_slots(n_slots), high_water(0) {
+    /** Create an empty table over `n_slots` entries of `slots`, which must outlive it. */
+    for (uint8_t i = 0; i < n_slots; i++) {
+        slots[i].pot = NULL;
+    }
+}
+
+bool AD525xBusyTable::busy_until(AD525x *pot, uint32_t now, uint32_t *until) {
+    /** True if `pot` is still programming EEMEM at `now`, with the end of programming stored in
+    `until` if it is not NULL. Expired entries are released. */
+    for (uint8_t i = 0; i < n_slots; i++) {
+        if (slots[i].pot == NULL) { continue; }
+
+        if ((int32_t)(now - slots[i].until) >= 0) {
+            slots[i].pot = NULL;
+        } else if (slots[i].pot == pot) {
+            if (until != NULL) { *until = slots[i].until; }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool AD525xBusyTable::set_busy(AD525x *pot, uint32_t until) {
+    /** Mark `pot` as programming EEMEM until `until`. Never blocks, so it may be called from an
+    interrupt.
+
+    @return Returns false if every slot is taken by another device. The caller must then keep the
+            device from being addressed early some other way, e.g. by waiting out the time.
     */
+    uint8_t used = 0;
+    int8_t slot = -1;
 
-    uint8_t *rv = read_data(register_addr, 1);
-    if(rv == NULL) {
-        return 0;       // Err code set in read_data already.
+    for (uint8_t i = 0; i < n_slots; i++) {
+        if (slots[i].pot == pot) { slot = i; }
+        if (slots[i].pot != NULL) { used++; }
     }
 
-    return rv[0];
-}
\ No newline at end of file
+    // Take a free slot only if the device has none, so it is never tracked twice.
+    for (uint8_t i = 0; slot < 0 && i < n_slots; i++) {
+        if (slots[i].pot == NULL) { slot = i; }
+    }
+
+    if (slot < 0 || slots[slot].pot == NULL) { used++; }
+    if (used > high_water) { high_water = used; }
+
+    if (slot < 0) { return false; }
+
+    slots[slot].pot = pot;
+    slots[slot].until = until;
+    return true;
+}
+
+uint8_t AD525xBusyTable::get_high_water() {
+    /** Retrieve the most devices programming EEMEM at once. A value above the number of slots
+    means `set_busy()` found the table full. */
+    return high_water;
+}
+
+void AD525xBusyTable::reset_high_water() {
+    /** Clear the high-water mark. */
+    high_water = 0;
+}
@@ -9,23 +9,73 @@ Header file for AD5253/AD5254 digital potentiometer Arduino library.
 #include <Wire.h>
 #include <cstdint>
 
+/** @{ */
+// Priority classes shared by the companion libraries that queue or rate-limit bus traffic.
+#define AD525X_PRIO_CRITICAL 0  /*!< Safety or urgent traffic. Never delayed by lower classes. */
+#define AD525X_PRIO_NORMAL 1    /*!< Ordinary wiper updates. */
+#define AD525X_PRIO_BULK 2      /*!< Background work such as EEMEM backups. */
+#define AD525X_NUM_PRIO 3       /*!< Number of priority classes. */
+/**@}*/
+
+#ifndef AD525X_MAX_BUSES
+#define AD525X_MAX_BUSES 4          /*!< Distinct `TwoWire` controllers in use, at most 8. */
+#endif
+
+#if AD525X_MAX_BUSES > 8
+#error "AD525X_MAX_BUSES must fit the 3-bit bus index of AD525x"
+#endif
+
+#define AD525X_EEMEM_WRITE_MS 26    /*!< Worst-case EEMEM programming time after `write_EEMEM()` or
+                                         `store_RDAC()`, during which the device is busy. */
+
+/** Called after every I2C transaction of every AD525x object, with the bus used, the error code
+(0 on success) and the number of register and data bytes transferred. See
+`AD525x::set_bus_monitor()`. */
+typedef void (*AD525xBusMonitor)(void *context, TwoWire *bus, uint8_t err, uint8_t bytes);
+
+/** Value and error code of one read. Two bytes, trivially copyable, returned in registers. */
+struct AD525xResult {
+    uint8_t value;          /*!< The value read, or 0 on error. */
+    uint8_t err;            /*!< Error code (see `AD525x_Errors.h`), 0 on no error. */
+
+    bool ok(void) const { return err == 0; }
+};
+
+/** As `AD525xResult`, for `read_tolerance_result()`. */
+struct AD525xToleranceResult {
+    float value;            /*!< Tolerance in percent, or 0 on error. */
+    uint8_t err;            /*!< Error code (see `AD525x_Errors.h`), 0 on no error. */
+
+    bool ok(void) const { return err == 0; }
+};
 
 
 class AD525x {
 // This is a parent class - use AD5253 or AD5254 as necessary.
 public:
-    AD525x() : initialized(false), dev_addr(0), err_code(0) {};
- 
-    uint8_t initialize(uint8_t AD_addr);
+    uint8_t initialize(uint8_t AD_addr, TwoWire &wire = Wire);
 
     uint8_t write_RDAC(uint8_t RDAC, uint8_t value);
     uint8_t read_RDAC(uint8_t RDAC);
 
+    uint8_t move_RDAC(uint8_t RDAC, uint8_t value);
+    uint8_t read_RDAC_cached(uint8_t RDAC);
+    bool is_cached(uint8_t RDAC);
+    bool peek_RDAC(uint8_t RDAC, uint8_t *value);
+    void set_cached_RDAC(uint8_t RDAC, uint8_t value);
+    void invalidate_cache(void);
+
     uint8_t write_EEMEM(uint8_t reg, uint8_t value);
     uint8_t read_EEMEM(uint8_t reg);
 
     float read_tolerance(uint8_t RDAC);
 
+    // Reads returning value and error together
+    AD525xResult read_RDAC_result(uint8_t RDAC);
+    AD525xResult read_RDAC_cached_result(uint8_t RDAC);
+    AD525xResult read_EEMEM_result(uint8_t reg);
+    AD525xToleranceResult read_tolerance_result(uint8_t RDAC);
+
     // Device commands
     uint8_t reset_device(void);
 
@@ -43,33 +93,66 @@ public:
     uint8_t decrement_all_RDAC_6dB(void);
     uint8_t increment_all_RDAC_6dB(void);
 
-    // For class inheritance
-    virtual uint8_t get_max_val(void) = 0;      // Make this an abstract class.
+    uint8_t get_max_val(void);
+    uint8_t get_dev_addr(void);
+    TwoWire &get_bus(void);
+
+    static void set_bus_monitor(AD525xBusMonitor monitor, void *context = NULL);
+    static AD525xBusMonitor get_bus_monitor(void **context = NULL);
+
+    // Instruction bytes, for drivers that run the transfers themselves (see `AD525x_Async.h`).
+    static uint8_t RDAC_instruction(uint8_t RDAC) { return AD525x::RDAC_register | RDAC; }
+    static uint8_t EEMEM_instruction(uint8_t reg) { return AD525x::EEMEM_register | reg; }
+    static uint8_t store_instruction(uint8_t RDAC) { return AD525x::CMD_Store_RDAC | RDAC; }
 
     // Error handling
     uint8_t get_err_code(void);
     char *get_error_text(void);
 
 protected:
-    uint8_t max_val;        
+    // Only the AD5253 and AD5254 classes can be instantiated.
+    AD525x(bool wide) :
+        addr(0), initialized(false), wide(wide), err_code(0), wiper_known(0), bus(0) {};
 
 private:
     uint8_t write_cmd(uint8_t cmd_register);
 
     uint8_t write_data(uint8_t register_addr, uint8_t data);
-    uint8_t *read_data(uint8_t register_addr, uint8_t length);
-    uint8_t read_data_byte(uint8_t register_addr);
-
-    uint8_t dev_addr;       /*!< The full 7-bit address of the specified device. */
-    uint8_t err_code;       /*!< Used for error detection. Access via get_err_code() and 
-                                 get_error_text() */
-    
-    bool initialized;
+    uint8_t read_data(uint8_t register_addr, uint8_t *buff, uint8_t length);
+    AD525xResult read_data_byte(uint8_t register_addr);
+
+    void cache_wiper(uint8_t RDAC, uint8_t value);
+    void step_cached_wiper(uint8_t RDAC, bool up);
+
+    uint8_t i2c_addr(void) { return AD525x::base_I2C_addr | addr; }
+    TwoWire &wire(void) { return *AD525x::buses[bus]; }
+    uint8_t monitor_bus(uint8_t err, uint8_t bytes);
+
+    static TwoWire *buses[AD525X_MAX_BUSES];    /*!< Controllers in use; `bus` indexes this, and
+                                                     entry 0 is always `Wire`. */
+    static AD525xBusMonitor bus_monitor;    /*!< Shared by all objects, so it costs no per-object
+                                                 memory. */
+    static void *bus_monitor_context;
+
+    // Packed device descriptor: two bytes instead of a vptr and four separately padded fields, so
+    // an object is 6 bytes and arrays of hundreds of devices stay compact.
+    uint16_t addr : 2;          /*!< The `AD1 AD0` bits of the address. See `i2c_addr()`. */
+    uint16_t initialized : 1;
+    uint16_t wide : 1;          /*!< 8-bit wipers (AD5254) rather than 6-bit (AD5253). */
+    uint16_t err_code : 5;      /*!< Used for error detection. Access via get_err_code() and
+                                     get_error_text() */
+    uint16_t wiper_known : 4;   /*!< Bit mask of the entries in `wiper` that match the device. */
+    uint16_t bus : 3;           /*!< Index of the device's controller in `buses`. */
+
+    uint8_t wiper[4];           /*!< Last known wiper value of each RDAC. */
 
     static const uint8_t max_RDAC_register = 3;     /*!< The maximum valid RDAC address. */
     static const uint8_t max_EEMEM_register = 15;   /*!< The maximum valid EEMEM address.*/
 
     static const uint8_t max_AD_addr = 3;           /*!< The maximum valid AD_addr address. */
+
+    static const uint8_t max_val_AD5253 = 63;       /*!< Maximum wiper value of the AD5253. */
+    static const uint8_t max_val_AD5254 = 255;      /*!< Maximum wiper value of the AD5254. */
     
     // Addresses relevant to these devices.
     static const uint8_t base_I2C_addr = 0x2C;    /*!< Base address of these devices. Full address is 
@@ -109,16 +192,37 @@ private:
 
 class AD5253 : public AD525x {
 public:
-    uint8_t get_max_val(void);
-private:
-    static const uint8_t max_val = 63;          /*!< Maximum wiper value. 63 for AD5253 */
+    AD5253() : AD525x(false) {};
 };
 
 class AD5254 : public AD525x {
 public:
-    uint8_t get_max_val(void);
+    AD5254() : AD525x(true) {};
+};
+
+/** One entry of an `AD525xBusyTable`. */
+struct AD525xBusySlot {
+    AD525x *pot;                /*!< Device programming EEMEM, or NULL if the slot is free. */
+    uint32_t until;             /*!< Timestamp at which programming is complete. */
+};
+
+class AD525xBusyTable {
+// Devices that are programming EEMEM and must not be addressed until a timestamp. Shared by the
+// queues that work around programming time (AD525xScheduler, AD525xAsyncBus, AD525xCoScheduler);
+// each owns the slot array and picks the clock, so timestamps may be `micros()` or `millis()`.
+public:
+    AD525xBusyTable(AD525xBusySlot *slots, uint8_t n_slots);
+
+    bool busy_until(AD525x *pot, uint32_t now, uint32_t *until = NULL);
+    bool set_busy(AD525x *pot, uint32_t until);
+
+    uint8_t get_high_water(void);
+    void reset_high_water(void);
+
 private:
-    static const uint8_t max_val = 255;         /*!< Maximum wiper value. 255 for AD5254 */
+    AD525xBusySlot *slots;
+    uint8_t n_slots;
+    uint8_t high_water;         /*!< Most slots wanted at once, above `n_slots` after overflow. */
 };
 
 #endif
\ No newline at end of file
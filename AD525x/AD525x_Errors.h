@@ -14,5 +14,8 @@ Error code header for `AD525x.h` and `AD525x_ErrorStrings.h`.
 #define EC_BAD_READ_SIZE 7      /*!< Invalid number of bytes read from register. */
 #define EC_BAD_DEVICE_ADDR 8    /*!< Bad device address - device address must be in [0, 3]. */
 #define EC_NOT_INITIALIZED 9    /*!< Communication has not been initialized. */
+#define EC_NO_RESOURCES 10      /*!< No free queue or table slot for the request. */
+#define EC_BAD_CHECKSUM 11      /*!< Data read back failed its checksum. */
+#define EC_STORAGE 12           /*!< Host file or socket could not be opened, read or written. */
 
 #endif
\ No newline at end of file
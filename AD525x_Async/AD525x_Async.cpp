@@ -0,0 +1,457 @@
+/** @file
+Class file for non-blocking AD525x transactions: operations are queued, handed one at a time to
+a transport (interrupt-, DMA- or Wire-driven) and complete in the background.
+*/
+
+#include <AD525x_Async.h>
+#include <AD525x_Errors.h>
+#include <Arduino.h>
+
+AD525xAsyncBus::AD525xAsyncBus(AD525xTransferStart start, void *context, TwoWire &wire) :
+    start(start), context(context), wire(&wire), count(0), active(-1), starting(false),
+    restart(false), done_head(0), done_count(0), busy(busy_slots, AD525X_ASYNC_MAX_BUSY),
+    hold_until(0), hold(false), high_water(0), completed(0), err_code(0) {
+    /** Create a queue that drives its transfers through a transport.
+
+    A transport is a start function and its context. Interrupt- or DMA-capable controllers (SAMD
+    SERCOM, STM32 HAL `_IT`/`_DMA` calls, the ESP-IDF asynchronous I2C master) start the transfer
+    in `start` and call `complete()` from their completion callback. `AD525xWireTransport`,
+    `AD525xSimTransport` and, on STM32, `AD525xHalTransport` are provided.
+
+    @param[in] start   Starts one transfer. See `AD525xTransferStart`.
+    @param[in] context Passed to `start` unchanged, e.g. the transport object.
+    @param[in] wire    The controller the transport drives. Only devices initialized on it are
+                       accepted.
+    */
+}
+
+uint8_t AD525xAsyncBus::write_RDAC(AD525x &pot, uint8_t RDAC, uint8_t value,
+                                   volatile uint8_t *status) {
+    /** Queue a wiper write and return at once. The transfer starts as soon as the bus is free.
+
+    @param[in]  pot    An initialized device on this bus.
+    @param[in]  RDAC   Wiper 0-3.
+    @param[in]  value  Wiper value, at most `pot.get_max_val()`.
+    @param[out] status If not NULL, set to `AD525X_ASYNC_PENDING` now and to the error code of the
+                       transfer when it completes. It may be written from an interrupt.
+
+    @return Returns 0 if queued, `EC_NOT_INITIALIZED`, `EC_BAD_REGISTER` or `EC_BAD_WIPER_SETTING`
+            for a bad request, `EC_BAD_DEVICE_ADDR` if `pot` is on another controller, or
+            `EC_NO_RESOURCES` if the queue is full.
+    */
+    if (RDAC > 3) { return (err_code = EC_BAD_REGISTER); }
+    if (value > pot.get_max_val()) { return (err_code = EC_BAD_WIPER_SETTING); }
+
+    return enqueue(pot, op_write_RDAC, RDAC, value, NULL, status);
+}
+
+uint8_t AD525xAsyncBus::read_RDAC(AD525x &pot, uint8_t RDAC, uint8_t *result,
+                                  volatile uint8_t *status) {
+    /** Queue a wiper read. `result` is written when the transfer completes without error. See
+    `write_RDAC()`. */
+    if (RDAC > 3) { return (err_code = EC_BAD_REGISTER); }
+
+    return enqueue(pot, op_read_RDAC, RDAC, 0, result, status);
+}
+
+uint8_t AD525xAsyncBus::write_EEMEM(AD525x &pot, uint8_t reg, uint8_t value,
+                                    volatile uint8_t *status) {
+    /** Queue an EEMEM write. Later operations for the same device wait out its programming time;
+    other devices keep using the bus. See `write_RDAC()`. */
+    if (reg > 15) { return (err_code = EC_BAD_REGISTER); }
+
+    return enqueue(pot, op_write_EEMEM, reg, value, NULL, status);
+}
+
+uint8_t AD525xAsyncBus::read_EEMEM(AD525x &pot, uint8_t reg, uint8_t *result,
+                                   volatile uint8_t *status) {
+    /** Queue an EEMEM read. See `read_RDAC()`. */
+    if (reg > 15) { return (err_code = EC_BAD_REGISTER); }
+
+    return enqueue(pot, op_read_EEMEM, reg, 0, result, status);
+}
+
+uint8_t AD525xAsyncBus::store_RDAC(AD525x &pot, uint8_t RDAC, volatile uint8_t *status) {
+    /** Queue a store of the wiper of `RDAC` to its EEMEM register. See `write_EEMEM()`. */
+    if (RDAC > 3) { return (err_code = EC_BAD_REGISTER); }
+
+    return enqueue(pot, op_store_RDAC, RDAC, 0, NULL, status);
+}
+
+void AD525xAsyncBus::complete(uint8_t err) {
+    /** Transport callback: the transfer in flight finished with I2C error `err` (0 on success).
+
+    Posts the result and starts the next transfer, without blocking, so it is safe to call from
+    the controller's interrupt handler. The device's wiper cache is not touched here, since the main
+    loop may be using the same `AD525x` object; the update is recorded and applied by the next
+    `service()`.
+
+    The transfer is reported to the bus monitor (see `AD525x::set_bus_monitor()`) as a blocking
+    one would be. With an interrupt-driven transport the monitor so runs in interrupt context.
+    */
+    int8_t i = active;
+    if (i < 0) { return; }
+
+    Op op = queue[i];
+
+    void *monitor_context;
+    AD525xBusMonitor monitor = AD525x::get_bus_monitor(&monitor_context);
+    if (monitor != NULL) { monitor(monitor_context, wire, err, xfer.tx_len + xfer.rx_len); }
+
+    if (op.type == op_write_RDAC || op.type == op_read_RDAC) {
+        // `enqueue()` counts these against the queue, so there is always room.
+        Done &d = done[(done_head + done_count) % AD525X_ASYNC_QUEUE_LEN];
+        d.pot = op.pot;
+        d.type = op.type;
+        d.reg = op.reg;
+        d.value = (op.type == op_read_RDAC) ? rx : op.value;
+        d.err = err;
+        done_count = done_count + 1;
+    } else if (!err && (op.type == op_write_EEMEM || op.type == op_store_RDAC)) {
+        set_busy(op.pot, millis());
+    }
+
+    if (!err && op.result != NULL) { *op.result = rx; }
+
+    for (uint8_t k = i + 1; k < count; k++) {
+        queue[k - 1] = queue[k];
+    }
+    count = count - 1;
+    completed++;
+    err_code = err;
+    active = -1;
+
+    if (op.status != NULL) { *op.status = err; }
+
+    start_next();
+}
+
+void AD525xAsyncBus::service() {
+    /** Apply the wiper cache updates of completed transfers, and restart the queue after
+    operations were held back by EEMEM programming. Call this regularly, e.g. from `loop()`, and
+    not from an interrupt. */
+    while (done_count > 0) {
+        Done &d = done[done_head];      // `complete()` only appends behind the pending entries.
+
+        if (d.type == op_write_RDAC && d.err) {
+            d.pot->invalidate_cache();  // The write may or may not have landed.
+        } else if (!d.err) {
+            d.pot->set_cached_RDAC(d.reg, d.value);
+        }
+
+        noInterrupts();
+        done_head = (done_head + 1) % AD525X_ASYNC_QUEUE_LEN;
+        done_count = done_count - 1;
+        interrupts();
+    }
+
+    if (active < 0 && count > 0) { start_next(); }
+}
+
+bool AD525xAsyncBus::idle() {
+    /** True if nothing is queued or in flight, and every cache update has been applied. */
+    return count == 0 && done_count == 0;
+}
+
+uint8_t AD525xAsyncBus::get_queued() {
+    /** Retrieve the number of operations queued, including the one in flight. */
+    return count;
+}
+
+uint8_t AD525xAsyncBus::get_high_water() {
+    /** Retrieve the deepest the queue has been. */
+    return high_water;
+}
+
+uint32_t AD525xAsyncBus::get_completed() {
+    /** Retrieve the number of transfers completed, successfully or not. */
+    return completed;
+}
+
+uint8_t AD525xAsyncBus::get_err_code() {
+    /** Retrieve the error code of the last submission or completion. See `AD525x_Errors.h`. */
+    return err_code;
+}
+
+//
+// Private functions
+//
+uint8_t AD525xAsyncBus::enqueue(AD525x &pot, uint8_t type, uint8_t reg, uint8_t value,
+                                uint8_t *result, volatile uint8_t *status) {
+    /** Append an operation and start it if the bus is idle. */
+    if (pot.get_dev_addr() == 0) { return (err_code = EC_NOT_INITIALIZED); }
+    if (&pot.get_bus() != wire) { return (err_code = EC_BAD_DEVICE_ADDR); }
+
+    if (status != NULL) { *status = AD525X_ASYNC_PENDING; }
+
+    noInterrupts();                     // `complete()` may shift the queue from an interrupt.
+    if (count + done_count >= AD525X_ASYNC_QUEUE_LEN) {
+        interrupts();
+        if (status != NULL) { *status = EC_NO_RESOURCES; }
+        return (err_code = EC_NO_RESOURCES);
+    }
+
+    Op &op = queue[count];
+    op.pot = &pot;
+    op.type = type;
+    op.reg = reg;
+    op.value = value;
+    op.result = result;
+    op.status = status;
+
+    count = count + 1;
+    if (count > high_water) { high_water = count; }
+
+    bool kick = active < 0;
+    interrupts();
+
+    if (kick) { start_next(); }
+
+    return (err_code = EC_NO_ERR);
+}
+
+void AD525xAsyncBus::start_next() {
+    /** Start the first queued operation whose device is not programming EEMEM.
+
+    A transport may complete synchronously, calling `complete()` and so this function again from
+    inside `start`. The nested call only raises `restart`, and the outer call loops, so the chain
+    never recurses deeper than one level.
+    */
+    if (__atomic_exchange_n(&starting, true, __ATOMIC_ACQ_REL)) {
+        __atomic_store_n(&restart, true, __ATOMIC_RELEASE);
+        return;
+    }
+
+    do {
+        __atomic_store_n(&restart, false, __ATOMIC_RELEASE);
+
+        uint32_t now = millis();
+        int8_t pick = -1;
+
+        if (hold && (int32_t)(now - hold_until) >= 0) { hold = false; }
+
+        for (uint8_t i = 0; !hold && active < 0 && i < count; i++) {
+            if (!busy.busy_until(queue[i].pot, now)) {
+                pick = i;
+                break;
+            }
+        }
+
+        if (pick >= 0) {
+            Op &op = queue[pick];
+
+            xfer.addr = op.pot->get_dev_addr();
+            xfer.rx = &rx;
+            xfer.rx_len = 0;
+            xfer.tx_len = 1;
+
+            switch (op.type) {
+                case op_write_RDAC:
+                    xfer.tx[0] = AD525x::RDAC_instruction(op.reg);
+                    xfer.tx[1] = op.value;
+                    xfer.tx_len = 2;
+                    break;
+                case op_read_RDAC:
+                    xfer.tx[0] = AD525x::RDAC_instruction(op.reg);
+                    xfer.rx_len = 1;
+                    break;
+                case op_write_EEMEM:
+                    xfer.tx[0] = AD525x::EEMEM_instruction(op.reg);
+                    xfer.tx[1] = op.value;
+                    xfer.tx_len = 2;
+                    break;
+                case op_read_EEMEM:
+                    xfer.tx[0] = AD525x::EEMEM_instruction(op.reg);
+                    xfer.rx_len = 1;
+                    break;
+                case op_store_RDAC:
+                    xfer.tx[0] = AD525x::store_instruction(op.reg);
+                    break;
+            }
+
+            active = pick;
+            start(context, *this, xfer);
+        }
+
+        __atomic_store_n(&starting, false, __ATOMIC_RELEASE);
+    } while (__atomic_load_n(&restart, __ATOMIC_ACQUIRE) &&
+             !__atomic_exchange_n(&starting, true, __ATOMIC_ACQ_REL));
+}
+
+void AD525xAsyncBus::set_busy(AD525x *pot, uint32_t now) {
+    /** Mark `pot` as programming EEMEM for the next `AD525X_EEMEM_WRITE_MS`. If every slot is in
+    use, hold the whole queue for that time instead, so no device is addressed early. Never
+    blocks: this runs in the completion interrupt. */
+    uint32_t until = now + AD525X_EEMEM_WRITE_MS + 1;
+
+    if (!busy.set_busy(pot, until)) {
+        hold = true;
+        hold_until = until;
+    }
+}
+
+//
+// Blocking Wire transport
+//
+AD525xWireTransport::AD525xWireTransport(TwoWire &wire) : wire(&wire) {
+    /** Create a transport on `wire`. The controller must already be started, e.g. by
+    `AD525x::initialize()`. */
+}
+
+void AD525xWireTransport::start(void *context, AD525xAsyncBus &bus, AD525xTransfer &xfer) {
+    /** `AD525xTransferStart` for an `AD525xWireTransport` passed as `context`. */
+    bus.complete(((AD525xWireTransport *)context)->execute(xfer));
+}
+
+uint8_t AD525xWireTransport::execute(AD525xTransfer &xfer) {
+    /** Carry out `xfer` on the controller, blocking, and return the I2C error code. */
+    wire->beginTransmission(xfer.addr);
+    wire->write(xfer.tx, xfer.tx_len);
+
+    uint8_t err = wire->endTransmission();
+    if (err || xfer.rx_len == 0) { return err; }
+
+    if (wire->requestFrom(xfer.addr, xfer.rx_len) != xfer.rx_len) { return EC_BAD_READ_SIZE; }
+
+    for (uint8_t i = 0; i < xfer.rx_len; i++) {
+        xfer.rx[i] = wire->read();
+    }
+
+    return EC_NO_ERR;
+}
+
+//
+// Simulated completion transport
+//
+AD525xSimTransport::AD525xSimTransport(uint32_t clock_hz, TwoWire &wire) :
+    wire(wire), clock_hz(clock_hz), bus(NULL), xfer(NULL), due(0), total_us(0) {
+    /** Create a simulated transport with an SCL rate of `clock_hz`, executing on `wire`. */
+}
+
+void AD525xSimTransport::start(void *context, AD525xAsyncBus &bus, AD525xTransfer &xfer) {
+    /** `AD525xTransferStart` for an `AD525xSimTransport` passed as `context`. */
+    AD525xSimTransport *t = (AD525xSimTransport *)context;
+    uint32_t us = wire_us(xfer, t->clock_hz);
+
+    t->bus = &bus;
+    t->xfer = &xfer;
+    t->due = micros() + us;
+    t->total_us += us;
+}
+
+void AD525xSimTransport::poll() {
+    /** Complete the transfer in flight if its wire time has elapsed. Call this as often as an
+    interrupt could fire, e.g. between chunks of the work being measured. */
+    if (bus == NULL || (int32_t)(micros() - due) < 0) { return; }
+
+    AD525xAsyncBus *b = bus;
+    bus = NULL;                         // `complete()` may start the next transfer at once.
+    b->complete(wire.execute(*xfer));
+}
+
+uint32_t AD525xSimTransport::wire_us(const AD525xTransfer &xfer, uint32_t clock_hz) {
+    /** Bus time of `xfer` at `clock_hz`: 9 clocks per byte including the address byte and the
+    acknowledge, plus about 2 for each start/stop, rounded up to whole microseconds. */
+    uint32_t clocks = 9UL * (1 + xfer.tx_len) + 2;
+    if (xfer.rx_len) { clocks += 9UL * (1 + xfer.rx_len) + 2; }
+
+    return (clocks * 1000000UL + clock_hz - 1) / clock_hz;
+}
+
+uint32_t AD525xSimTransport::get_wire_us() {
+    /** Retrieve the total simulated bus time of all transfers started. */
+    return total_us;
+}
+
+#if AD525X_HAS_HAL_TRANSPORT
+//
+// STM32 HAL interrupt/DMA transport
+//
+AD525xHalTransport *AD525xHalTransport::active[AD525X_MAX_BUSES];
+
+AD525xHalTransport::AD525xHalTransport(I2C_HandleTypeDef &hi2c, bool dma) :
+    hi2c(&hi2c), dma(dma), bus(NULL), saved_tx(NULL), saved_rx(NULL), saved_error(NULL) {
+    /** Create a transport on an initialized HAL handle, e.g. `Wire.getHandle()` on the STM32
+    core. With `dma`, the handle's DMA channels must be linked and their interrupts enabled. */
+}
+
+void AD525xHalTransport::start(void *context, AD525xAsyncBus &bus, AD525xTransfer &xfer) {
+    /** `AD525xTransferStart` for an `AD525xHalTransport` passed as `context`. Returns as soon as
+    the HAL has accepted the transfer. */
+    AD525xHalTransport *t = (AD525xHalTransport *)context;
+    I2C_HandleTypeDef *h = t->hi2c;
+    uint16_t addr = (uint16_t)xfer.addr << 1;
+
+    for (uint8_t i = 0; i < AD525X_MAX_BUSES; i++) {
+        if (active[i] == NULL) {
+            active[i] = t;
+            break;
+        }
+    }
+
+    t->bus = &bus;
+    t->saved_tx = h->MasterTxCpltCallback;
+    t->saved_rx = h->MemRxCpltCallback;
+    t->saved_error = h->ErrorCallback;
+    h->MasterTxCpltCallback = on_complete;
+    h->MemRxCpltCallback = on_complete;
+    h->ErrorCallback = on_error;
+
+    HAL_StatusTypeDef status;
+    if (xfer.rx_len == 0) {
+        status = t->dma ? HAL_I2C_Master_Transmit_DMA(h, addr, xfer.tx, xfer.tx_len)
+                        : HAL_I2C_Master_Transmit_IT(h, addr, xfer.tx, xfer.tx_len);
+    } else {
+        // Register byte, repeated start, then the read.
+        status = t->dma ? HAL_I2C_Mem_Read_DMA(h, addr, xfer.tx[0], I2C_MEMADD_SIZE_8BIT, xfer.rx,
+                                               xfer.rx_len)
+                        : HAL_I2C_Mem_Read_IT(h, addr, xfer.tx[0], I2C_MEMADD_SIZE_8BIT, xfer.rx,
+                                              xfer.rx_len);
+    }
+
+    if (status != HAL_OK) { t->finish(EC_I2C_OTHER); }     // Busy or misconfigured handle.
+}
+
+//
+// Private functions
+//
+void AD525xHalTransport::on_complete(I2C_HandleTypeDef *hi2c) {
+    /** HAL transmit and memory-read completion callback. */
+    AD525xHalTransport *t = find(hi2c);
+    if (t != NULL) { t->finish(EC_NO_ERR); }
+}
+
+void AD525xHalTransport::on_error(I2C_HandleTypeDef *hi2c) {
+    /** HAL error callback. An acknowledge failure is reported as an address NACK, as `Wire` would
+    for a missing device; anything else as `EC_I2C_OTHER`. */
+    AD525xHalTransport *t = find(hi2c);
+    if (t == NULL) { return; }
+
+    t->finish((HAL_I2C_GetError(hi2c) & HAL_I2C_ERROR_AF) ? EC_NACK_ADDR : EC_I2C_OTHER);
+}
+
+AD525xHalTransport *AD525xHalTransport::find(I2C_HandleTypeDef *hi2c) {
+    /** The transport with a transfer in flight on `hi2c`, or NULL. */
+    for (uint8_t i = 0; i < AD525X_MAX_BUSES; i++) {
+        if (active[i] != NULL && active[i]->hi2c == hi2c) { return active[i]; }
+    }
+
+    return NULL;
+}
+
+void AD525xHalTransport::finish(uint8_t err) {
+    /** Give the handle its callbacks back and report `err` to the bus, which may start the next
+    transfer from here. */
+    hi2c->MasterTxCpltCallback = saved_tx;
+    hi2c->MemRxCpltCallback = saved_rx;
+    hi2c->ErrorCallback = saved_error;
+
+    for (uint8_t i = 0; i < AD525X_MAX_BUSES; i++) {
+        if (active[i] == this) { active[i] = NULL; }
+    }
+
+    AD525xAsyncBus *b = bus;
+    bus = NULL;
+    b->complete(err);
+}
+#endif
@@ -0,0 +1,188 @@
+/** @file
+Header file for non-blocking AD525x transactions: operations are queued, handed one at a time to
+a transport (interrupt-, DMA- or Wire-driven) and complete in the background.
+*/
+#ifndef AD525X_ASYNC_H
+#define AD525X_ASYNC_H
+
+#include <AD525x.h>
+#include <Wire.h>
+#include <cstdint>
+
+// STM32 HAL interrupt/DMA transport, when the core builds the HAL with per-handle callbacks.
+#if defined(HAL_I2C_MODULE_ENABLED) && defined(USE_HAL_I2C_REGISTER_CALLBACKS) && \
+    USE_HAL_I2C_REGISTER_CALLBACKS
+#define AD525X_HAS_HAL_TRANSPORT 1
+#endif
+
+#ifndef AD525X_ASYNC_QUEUE_LEN
+#define AD525X_ASYNC_QUEUE_LEN 8    /*!< Queued operations per bus. */
+#endif
+
+#ifndef AD525X_ASYNC_MAX_BUSY
+#define AD525X_ASYNC_MAX_BUSY 4     /*!< Devices that can be programming EEMEM at the same time. */
+#endif
+
+#define AD525X_ASYNC_PENDING 0xFF   /*!< Status value of an operation that has not completed. */
+
+/** One I2C transaction, as handed to a transport: write `tx_len` bytes, then, if `rx_len` is not
+0, read `rx_len` bytes into `rx` with a repeated start or a new transaction. */
+struct AD525xTransfer {
+    uint8_t addr;           /*!< 7-bit device address. */
+    uint8_t tx[2];          /*!< Register or command byte, then the data byte of a write. */
+    uint8_t tx_len;
+    uint8_t *rx;            /*!< Destination of the read phase. */
+    uint8_t rx_len;         /*!< 0 for a plain write. */
+};
+
+class AD525xAsyncBus;
+
+/** Start `xfer` on the controller and return at once. When the hardware is done, the transport
+calls `bus.complete()` with the I2C error code, from its interrupt handler, DMA callback or a
+poll. `xfer` stays valid until then. */
+typedef void (*AD525xTransferStart)(void *context, AD525xAsyncBus &bus, AD525xTransfer &xfer);
+
+class AD525xAsyncBus {
+public:
+    AD525xAsyncBus(AD525xTransferStart start, void *context, TwoWire &wire = Wire);
+
+    uint8_t write_RDAC(AD525x &pot, uint8_t RDAC, uint8_t value, volatile uint8_t *status = NULL);
+    uint8_t read_RDAC(AD525x &pot, uint8_t RDAC, uint8_t *result, volatile uint8_t *status = NULL);
+    uint8_t write_EEMEM(AD525x &pot, uint8_t reg, uint8_t value, volatile uint8_t *status = NULL);
+    uint8_t read_EEMEM(AD525x &pot, uint8_t reg, uint8_t *result, volatile uint8_t *status = NULL);
+    uint8_t store_RDAC(AD525x &pot, uint8_t RDAC, volatile uint8_t *status = NULL);
+
+    void complete(uint8_t err);
+    void service(void);
+
+    bool idle(void);
+    uint8_t get_queued(void);
+    uint8_t get_high_water(void);
+    uint32_t get_completed(void);
+    uint8_t get_err_code(void);
+
+private:
+    struct Op {
+        AD525x *pot;
+        uint8_t type;               /*!< One of the `op_*` constants. */
+        uint8_t reg;                /*!< RDAC or EEMEM register. */
+        uint8_t value;              /*!< Data for writes. */
+        uint8_t *result;            /*!< Destination for reads, may be NULL. */
+        volatile uint8_t *status;   /*!< Completion slot, may be NULL. */
+    };
+
+    struct Done {
+        AD525x *pot;
+        uint8_t type;               /*!< `op_write_RDAC` or `op_read_RDAC`. */
+        uint8_t reg;
+        uint8_t value;              /*!< Value written or read. */
+        uint8_t err;
+    };
+
+    uint8_t enqueue(AD525x &pot, uint8_t type, uint8_t reg, uint8_t value, uint8_t *result,
+                    volatile uint8_t *status);
+    void start_next(void);
+    void set_busy(AD525x *pot, uint32_t now);
+
+    static const uint8_t op_write_RDAC = 0;
+    static const uint8_t op_read_RDAC = 1;
+    static const uint8_t op_write_EEMEM = 2;
+    static const uint8_t op_read_EEMEM = 3;
+    static const uint8_t op_store_RDAC = 4;
+
+    AD525xTransferStart start;
+    void *context;
+    TwoWire *wire;                  /*!< Controller of the transport; devices must be on it. */
+
+    Op queue[AD525X_ASYNC_QUEUE_LEN];
+    volatile uint8_t count;
+    volatile int8_t active;         /*!< Index of the operation on the wire, or -1. */
+    volatile bool starting;         /*!< Inside `start_next()`; a nested completion only flags. */
+    volatile bool restart;
+
+    AD525xTransfer xfer;            /*!< The transfer of the active operation. */
+    uint8_t rx;
+
+    Done done[AD525X_ASYNC_QUEUE_LEN];  /*!< Completed wiper operations whose cache update waits
+                                             for `service()`. They count against the queue. */
+    volatile uint8_t done_head;
+    volatile uint8_t done_count;
+
+    AD525xBusySlot busy_slots[AD525X_ASYNC_MAX_BUSY];
+    AD525xBusyTable busy;           /*!< Devices programming EEMEM, in `millis()`. */
+    uint32_t hold_until;            /*!< All devices wait until then if `busy` overflowed. */
+    bool hold;
+
+    uint8_t high_water;
+    uint32_t completed;
+    uint8_t err_code;
+};
+
+/** Transport that runs each transfer at once on a `TwoWire` controller, blocking. Use it where no
+interrupt-driven driver exists; the queue then behaves like `AD525xScheduler`. */
+class AD525xWireTransport {
+public:
+    AD525xWireTransport(TwoWire &wire = Wire);
+
+    static void start(void *context, AD525xAsyncBus &bus, AD525xTransfer &xfer);
+    uint8_t execute(AD525xTransfer &xfer);
+
+private:
+    TwoWire *wire;
+};
+
+/** Host test transport: each transfer is carried out on a `TwoWire` (e.g. a simulator), but it
+completes only once its wire time at `clock_hz` has elapsed, from `poll()`, as an interrupt
+would. Code built on `AD525xAsyncBus` can so be tested, and its CPU time measured, off-target. */
+class AD525xSimTransport {
+public:
+    AD525xSimTransport(uint32_t clock_hz = 100000UL, TwoWire &wire = Wire);
+
+    static void start(void *context, AD525xAsyncBus &bus, AD525xTransfer &xfer);
+    void poll(void);
+
+    static uint32_t wire_us(const AD525xTransfer &xfer, uint32_t clock_hz);
+    uint32_t get_wire_us(void);
+
+private:
+    AD525xWireTransport wire;
+    uint32_t clock_hz;
+
+    AD525xAsyncBus *bus;            /*!< Bus with a transfer in flight, or NULL. */
+    AD525xTransfer *xfer;
+    uint32_t due;                   /*!< `micros()` at which the transfer in flight completes. */
+    uint32_t total_us;              /*!< Simulated wire time of all transfers. */
+};
+
+#if AD525X_HAS_HAL_TRANSPORT
+/** STM32 HAL transport: writes start with `HAL_I2C_Master_Transmit_IT()` and reads with
+`HAL_I2C_Mem_Read_IT()` (or the `_DMA` variants), and the HAL completion and error callbacks of
+the handle call `complete()`. Requires `USE_HAL_I2C_REGISTER_CALLBACKS`. The callbacks the handle
+had are put back after each transfer, so the core's `Wire` driver keeps working in between. */
+class AD525xHalTransport {
+public:
+    AD525xHalTransport(I2C_HandleTypeDef &hi2c, bool dma = false);
+
+    static void start(void *context, AD525xAsyncBus &bus, AD525xTransfer &xfer);
+
+private:
+    static void on_complete(I2C_HandleTypeDef *hi2c);
+    static void on_error(I2C_HandleTypeDef *hi2c);
+    static AD525xHalTransport *find(I2C_HandleTypeDef *hi2c);
+
+    void finish(uint8_t err);
+
+    static AD525xHalTransport *active[AD525X_MAX_BUSES];    /*!< Transports with a transfer in
+                                                                 flight. */
+
+    I2C_HandleTypeDef *hi2c;
+    bool dma;
+    AD525xAsyncBus *bus;            /*!< Bus with a transfer in flight, or NULL. */
+
+    pI2C_CallbackTypeDef saved_tx;  /*!< Callbacks of the handle before the transfer. */
+    pI2C_CallbackTypeDef saved_rx;
+    pI2C_CallbackTypeDef saved_error;
+};
+#endif
+
+#endif
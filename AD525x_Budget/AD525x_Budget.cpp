@@ -0,0 +1,356 @@
+/** @file
+Class file for token-bucket bandwidth budgets per AD525x device and per priority class.
+*/
+
+#include <AD525x_Budget.h>
+#include <AD525x_Errors.h>
+#include <Arduino.h>
+
+//
+// AD525xTokenBucket
+//
+void AD525xTokenBucket::configure(uint32_t rate, uint32_t burst) {
+    /** Set the refill rate (units per second) and capacity. A `rate` of 0 removes the limit.
+    The bucket starts full. */
+    this->rate = rate;
+    this->burst = burst;
+    tokens = burst;
+    last_us = micros();
+    last_ms = millis();
+}
+
+void AD525xTokenBucket::refill(uint32_t now_us) {
+    /** Credit the tokens earned since the last refill, up to the bucket capacity.
+
+    `micros()` wraps every 71 minutes. A full bucket earns nothing, so its timestamp is kept
+    current; a bucket left in debt and not refilled for half an hour is credited from `millis()`
+    instead, which does not wrap for 49 days. */
+    if (rate == 0) { return; }
+
+    uint32_t now_ms = millis();
+    uint64_t add;
+
+    if (now_ms - last_ms >= AD525X_BUDGET_IDLE_MS) {
+        add = (uint64_t)(now_ms - last_ms) * rate / 1000;
+        last_us = now_us;
+    } else {
+        add = (uint64_t)(now_us - last_us) * rate / 1000000;
+
+        if (add == 0) { return; }
+
+        // Only advance by the time actually converted to tokens, so fractions are not lost.
+        last_us += add * 1000000 / rate;
+    }
+    last_ms = now_ms;
+
+    if ((int64_t)tokens + (int64_t)add >= (int64_t)burst) {
+        tokens = burst;
+        last_us = now_us;       // Full: time passing earns nothing.
+    } else {
+        tokens += add;
+    }
+}
+
+bool AD525xTokenBucket::available(uint32_t cost) {
+    /** True if `cost` units can be spent without going into debt. */
+    return rate == 0 || tokens >= (int32_t)cost;
+}
+
+void AD525xTokenBucket::take(uint32_t cost) {
+    /** Spend `cost` units. Spending more than is available leaves the bucket in debt, which must
+    be repaid before lower priority traffic can use it again. */
+    if (rate == 0) { return; }
+
+    tokens -= cost;
+}
+
+uint32_t AD525xTokenBucket::wait_us(uint32_t cost) {
+    /** Time in microseconds until `cost` units are available, counted from the last refill. */
+    if (available(cost)) { return 0; }
+
+    return (uint32_t)((((int64_t)cost - tokens) * 1000000L + rate - 1) / rate);
+}
+
+//
+// AD525xRateLimiter
+//
+AD525xRateLimiter::AD525xRateLimiter(uint8_t unit, uint32_t bus_hz) :
+    n_devices(0), next_device(0), unit(unit), bus_hz(bus_hz), deferred(0), coalesced(0),
+    dropped(0), err_code(0) {
+    /** Create a rate limiter with no budgets configured (everything passes straight through).
+
+    @param[in] unit   `AD525xRateLimiter::unit_bytes` or `AD525xRateLimiter::unit_us`.
+    @param[in] bus_hz The SCL frequency, used to convert bytes to wire time.
+    */
+}
+
+uint8_t AD525xRateLimiter::set_device_budget(AD525x &pot, uint32_t rate, uint32_t burst) {
+    /** Limit the traffic sent to `pot` to `rate` units per second with bursts of `burst` units.
+
+    @return Returns 0 on no error, or `EC_NO_RESOURCES` if `AD525X_BUDGET_MAX_DEVICES` devices are
+            already tracked.
+    */
+    Device *dev = find_device(pot);
+    if (dev == NULL) { return (err_code = EC_NO_RESOURCES); }
+
+    dev->bucket.configure(rate, burst);
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xRateLimiter::set_class_budget(uint8_t prio, uint32_t rate, uint32_t burst) {
+    /** Limit the combined traffic of priority class `prio`, across all devices.
+
+    Critical traffic is never delayed, but it is charged against its budgets, so a burst of
+    critical writes pushes lower classes back.
+
+    @return Returns 0 on no error, or `EC_BAD_REGISTER` if `prio` is not a valid class.
+    */
+    if (prio >= AD525X_NUM_PRIO) { return (err_code = EC_BAD_REGISTER); }
+
+    class_bucket[prio].configure(rate, burst);
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xRateLimiter::submit_RDAC(AD525x &pot, uint8_t RDAC, uint8_t value, uint8_t prio) {
+    /** Submit a wiper update, sending it now if the budgets allow and queueing it otherwise.
+
+    The update is charged what `AD525x::move_RDAC()` actually puts on the wire, so a move to the
+    cached value is free and a single step costs one byte less than a full write. Only wiper
+    updates go through here; to put EEMEM and read traffic under the same budgets, queue it on an
+    `AD525xScheduler` given this limiter with `AD525xScheduler::set_budget()`.
+
+    `AD525X_PRIO_CRITICAL` requests are always sent immediately. Other requests are sent if both
+    the device and class budget have tokens left; otherwise they are parked in a single slot per
+    RDAC, and a newer value for the same RDAC replaces the parked one. Parked requests are sent by
+    `service()`.
+
+    @param[in] pot   The target device.
+    @param[in] RDAC  The RDAC to move [0-3].
+    @param[in] value The wiper value.
+    @param[in] prio  One of the `AD525X_PRIO_*` classes.
+
+    @return Returns 0 if the update was sent or queued, otherwise the error code from
+            `AD525x::move_RDAC()`, `EC_BAD_REGISTER` for an invalid RDAC or class, or
+            `EC_NO_RESOURCES` if the device table is full.
+    */
+    if (RDAC > 3 || prio >= AD525X_NUM_PRIO) { return (err_code = EC_BAD_REGISTER); }
+
+    Device *dev = find_device(pot);
+    if (dev == NULL) { return (err_code = EC_NO_RESOURCES); }
+
+    uint8_t bit = 1 << RDAC;
+    uint32_t now = micros();
+    uint32_t c = cost(move_bytes(pot, RDAC, value));
+
+    dev->bucket.refill(now);
+    class_bucket[prio].refill(now);
+
+    if (prio == AD525X_PRIO_CRITICAL) {
+        dev->pending_mask &= ~bit;      // Superseded by this write.
+        return send(*dev, RDAC, value, prio, c);
+    }
+
+    if (dev->pending_mask & bit) {
+        dev->pending_value[RDAC] = value;
+        if (prio < dev->pending_prio[RDAC]) { dev->pending_prio[RDAC] = prio; }
+        coalesced++;
+        return (err_code = EC_NO_ERR);
+    }
+
+    if (dev->bucket.available(c) && class_bucket[prio].available(c)) {
+        return send(*dev, RDAC, value, prio, c);
+    }
+
+    dev->pending_mask |= bit;
+    dev->pending_value[RDAC] = value;
+    dev->pending_prio[RDAC] = prio;
+    deferred++;
+
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xRateLimiter::service() {
+    /** Send queued updates as budgets allow. Call this regularly, e.g. from `loop()`.
+
+    Devices are visited round-robin so one device with a large backlog cannot starve the others,
+    and within a pass higher priority classes are sent first.
+
+    @return Returns 0 on no error, otherwise the error code of the last failed write. A failed
+            update is dropped and counted in `get_dropped()` rather than sent, and charged, again
+            on every call; submit it again to retry.
+    */
+    uint8_t rv = EC_NO_ERR;
+    uint32_t now = micros();
+
+    for (uint8_t p = 0; p < AD525X_NUM_PRIO; p++) {
+        class_bucket[p].refill(now);
+    }
+
+    for (uint8_t p = 0; p < AD525X_NUM_PRIO; p++) {
+        for (uint8_t k = 0; k < n_devices; k++) {
+            Device &dev = device[(next_device + k) % n_devices];
+            dev.bucket.refill(now);
+
+            for (uint8_t RDAC = 0; RDAC < 4; RDAC++) {
+                uint8_t bit = 1 << RDAC;
+
+                if (!(dev.pending_mask & bit) || dev.pending_prio[RDAC] != p) { continue; }
+
+                uint8_t value = dev.pending_value[RDAC];
+                uint32_t c = cost(move_bytes(*dev.pot, RDAC, value));
+                if (!dev.bucket.available(c) || !class_bucket[p].available(c)) { break; }
+
+                dev.pending_mask &= ~bit;
+                if (send(dev, RDAC, value, p, c)) {
+                    rv = err_code;
+                    dropped++;
+                }
+            }
+        }
+    }
+
+    if (n_devices) { next_device = (next_device + 1) % n_devices; }
+
+    return (err_code = rv);
+}
+
+bool AD525xRateLimiter::admit(AD525x &pot, uint8_t prio, uint8_t bytes) {
+    /** Charge a transaction to the budgets of `pot` and class `prio`, if they allow it. This is
+    how `AD525xScheduler` puts every operation it runs, not only wiper writes, under the budgets.
+
+    @param[in] pot   The target device.
+    @param[in] prio  One of the `AD525X_PRIO_*` classes.
+    @param[in] bytes Bytes the transaction puts on the wire, address bytes included.
+
+    @return Returns true if the transaction may go now and has been charged. Critical traffic is
+            always admitted and charged. Returns false, charging nothing, if it must wait.
+    */
+    if (prio >= AD525X_NUM_PRIO) { return false; }
+
+    Device *dev = find_device(pot);
+    uint32_t now = micros();
+    uint32_t c = cost(bytes);
+
+    class_bucket[prio].refill(now);
+    if (dev != NULL) { dev->bucket.refill(now); }
+
+    if (prio != AD525X_PRIO_CRITICAL &&
+        (!class_bucket[prio].available(c) || (dev != NULL && !dev->bucket.available(c)))) {
+        return false;
+    }
+
+    class_bucket[prio].take(c);
+    if (dev != NULL) { dev->bucket.take(c); }
+
+    return true;
+}
+
+uint32_t AD525xRateLimiter::get_wait_us(AD525x &pot, uint8_t prio, uint8_t bytes) {
+    /** Retrieve how long until `admit()` would let a transaction of `bytes` bytes through, in
+    microseconds. 0 if it would now. */
+    if (prio >= AD525X_NUM_PRIO || prio == AD525X_PRIO_CRITICAL) { return 0; }
+
+    Device *dev = find_device(pot);
+    uint32_t now = micros();
+    uint32_t c = cost(bytes);
+
+    class_bucket[prio].refill(now);
+    uint32_t wait = class_bucket[prio].wait_us(c);
+
+    if (dev != NULL) {
+        dev->bucket.refill(now);
+        uint32_t w = dev->bucket.wait_us(c);
+        if (w > wait) { wait = w; }
+    }
+
+    return wait;
+}
+
+uint8_t AD525xRateLimiter::move_bytes(AD525x &pot, uint8_t RDAC, uint8_t value) {
+    /** Bytes on the wire, address included, of `pot.move_RDAC(RDAC, value)`: none for the cached
+    value, an address and a command for a single step, and an address, instruction and data byte
+    otherwise. */
+    uint8_t current;
+
+    if (RDAC <= 3 && pot.peek_RDAC(RDAC, &current)) {
+        if (value == current) { return 0; }
+        if ((value == current + 1 && value <= pot.get_max_val()) || value + 1 == current) {
+            return 2;
+        }
+    }
+
+    return 3;
+}
+
+uint8_t AD525xRateLimiter::get_pending() {
+    /** Retrieve the number of updates waiting for budget. */
+    uint8_t n = 0;
+
+    for (uint8_t k = 0; k < n_devices; k++) {
+        for (uint8_t RDAC = 0; RDAC < 4; RDAC++) {
+            if (device[k].pending_mask & (1 << RDAC)) { n++; }
+        }
+    }
+
+    return n;
+}
+
+uint32_t AD525xRateLimiter::get_deferred() {
+    /** Retrieve the number of updates that had to wait for budget. */
+    return deferred;
+}
+
+uint32_t AD525xRateLimiter::get_coalesced() {
+    /** Retrieve the number of queued updates replaced by a newer value before being sent. */
+    return coalesced;
+}
+
+uint32_t AD525xRateLimiter::get_dropped() {
+    /** Retrieve the number of queued updates that failed on the bus and were dropped. */
+    return dropped;
+}
+
+uint8_t AD525xRateLimiter::get_err_code() {
+    /** Retrieve the error code of the last operation. See `AD525x_Errors.h`. */
+    return err_code;
+}
+
+//
+// Private functions
+//
+AD525xRateLimiter::Device *AD525xRateLimiter::find_device(AD525x &pot) {
+    /** Look up the entry for `pot`, adding an unlimited one if it is new. Returns NULL when full. */
+    for (uint8_t k = 0; k < n_devices; k++) {
+        if (device[k].pot == &pot) { return &device[k]; }
+    }
+
+    if (n_devices >= AD525X_BUDGET_MAX_DEVICES) { return NULL; }
+
+    Device &dev = device[n_devices++];
+    dev.pot = &pot;
+    dev.bucket.configure(0, 0);
+    dev.pending_mask = 0;
+
+    return &dev;
+}
+
+uint8_t AD525xRateLimiter::send(Device &dev, uint8_t RDAC, uint8_t value, uint8_t prio,
+                                uint32_t cost) {
+    /** Write the update and charge `cost` to the device and class budgets. */
+    dev.bucket.take(cost);
+    class_bucket[prio].take(cost);
+
+    return (err_code = dev.pot->move_RDAC(RDAC, value));
+}
+
+uint32_t AD525xRateLimiter::cost(uint8_t bytes) {
+    /** Convert `bytes` bytes on the wire to budget units. */
+    if (unit == AD525xRateLimiter::unit_us) {
+        if (bytes == 0) { return 0; }
+
+        // 9 clocks per byte (8 data + ACK) plus start and stop conditions.
+        return (((uint32_t)bytes * 9 + 2) * 1000000UL + bus_hz - 1) / bus_hz;
+    }
+
+    return bytes;
+}
@@ -0,0 +1,91 @@
+/** @file
+Header file for token-bucket bandwidth budgets per AD525x device and per priority class.
+*/
+#ifndef AD525X_BUDGET_H
+#define AD525X_BUDGET_H
+
+#include <AD525x.h>
+#include <cstdint>
+
+#ifndef AD525X_BUDGET_MAX_DEVICES
+#define AD525X_BUDGET_MAX_DEVICES 8     /*!< Devices tracked by one `AD525xRateLimiter`. */
+#endif
+
+#define AD525X_BUDGET_IDLE_MS 1800000UL /*!< Refill gap beyond which `micros()` may have wrapped. */
+
+class AD525xTokenBucket {
+// Rate is in units per second, where a unit is a byte or a microsecond of wire time.
+public:
+    AD525xTokenBucket() : rate(0), burst(0), tokens(0), last_us(0), last_ms(0) {};
+
+    void configure(uint32_t rate, uint32_t burst);
+    void refill(uint32_t now_us);
+
+    bool available(uint32_t cost);
+    void take(uint32_t cost);
+    uint32_t wait_us(uint32_t cost);
+
+private:
+    uint32_t rate;          /*!< Tokens added per second. 0 disables the limit. */
+    uint32_t burst;         /*!< Bucket capacity. */
+    int32_t tokens;         /*!< Current fill. Negative after critical traffic overdraws it. */
+    uint32_t last_us;       /*!< `micros()` timestamp up to which tokens have been credited. */
+    uint32_t last_ms;       /*!< `millis()` timestamp of the last refill. */
+};
+
+class AD525xRateLimiter {
+public:
+    AD525xRateLimiter(uint8_t unit = AD525xRateLimiter::unit_bytes, uint32_t bus_hz = 100000);
+
+    uint8_t set_device_budget(AD525x &pot, uint32_t rate, uint32_t burst);
+    uint8_t set_class_budget(uint8_t prio, uint32_t rate, uint32_t burst);
+
+    uint8_t submit_RDAC(AD525x &pot, uint8_t RDAC, uint8_t value,
+                        uint8_t prio = AD525X_PRIO_NORMAL);
+    uint8_t service(void);
+
+    bool admit(AD525x &pot, uint8_t prio, uint8_t bytes);
+    uint32_t get_wait_us(AD525x &pot, uint8_t prio, uint8_t bytes);
+
+    static uint8_t move_bytes(AD525x &pot, uint8_t RDAC, uint8_t value);
+
+    uint8_t get_pending(void);
+    uint32_t get_deferred(void);
+    uint32_t get_coalesced(void);
+    uint32_t get_dropped(void);
+
+    uint8_t get_err_code(void);
+
+    static const uint8_t unit_bytes = 0;    /*!< Budgets are in bytes on the wire. */
+    static const uint8_t unit_us = 1;       /*!< Budgets are in microseconds of wire time. */
+
+private:
+    struct Device {
+        AD525x *pot;
+        AD525xTokenBucket bucket;
+        uint8_t pending_mask;       /*!< Bit mask of RDACs with a queued value. */
+        uint8_t pending_value[4];   /*!< Latest queued value per RDAC. */
+        uint8_t pending_prio[4];    /*!< Highest priority class that queued each value. */
+    };
+
+    Device *find_device(AD525x &pot);
+    uint8_t send(Device &dev, uint8_t RDAC, uint8_t value, uint8_t prio, uint32_t cost);
+    uint32_t cost(uint8_t bytes);
+
+    Device device[AD525X_BUDGET_MAX_DEVICES];
+    uint8_t n_devices;
+    uint8_t next_device;            /*!< Round-robin start point for `service()`. */
+
+    AD525xTokenBucket class_bucket[AD525X_NUM_PRIO];
+
+    uint8_t unit;
+    uint32_t bus_hz;
+
+    uint32_t deferred;              /*!< Requests that had to wait for tokens. */
+    uint32_t coalesced;             /*!< Queued requests overwritten by a newer value. */
+    uint32_t dropped;               /*!< Queued requests that failed on the bus and were dropped. */
+
+    uint8_t err_code;
+};
+
+#endif
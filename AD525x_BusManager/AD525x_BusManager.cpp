@@ -0,0 +1,132 @@
+/** @file
+Class file for driving several I2C controllers (e.g. `Wire` and `Wire1`) side by side: one
+AD525xScheduler per bus, serviced round-robin so every bus keeps moving.
+*/
+
+#include <AD525x_BusManager.h>
+#include <AD525x_Errors.h>
+
+AD525xBusManager::AD525xBusManager() : n_buses(0), next(0), err_code(0) {
+    /** Create a manager with no buses. */
+}
+
+uint8_t AD525xBusManager::add_bus(AD525xScheduler &queue, uint8_t *index) {
+    /** Add the queue of one bus. Submit operations for devices on that bus to `queue` as usual,
+    then call `service()` on the manager instead of on each scheduler.
+
+    Every device queued on `queue` must be initialized on the same controller, e.g.
+    `pot.initialize(0, Wire1)`.
+
+    @param[in]  queue The scheduler of one bus.
+    @param[out] index If not NULL, receives the bus index used by `get_transactions()`.
+
+    @return Returns 0 on no error, or `EC_NO_RESOURCES` if `AD525X_MAX_BUSES` buses are added.
+    */
+    if (n_buses >= AD525X_MAX_BUSES) { return (err_code = EC_NO_RESOURCES); }
+
+    if (index != NULL) { *index = n_buses; }
+
+    transactions[n_buses] = 0;
+    sched[n_buses++] = &queue;
+
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xBusManager::run_one() {
+    /** Run one operation on the next bus, in turn, that has runnable work.
+
+    Each bus keeps its own priority order; between buses, turns rotate so a long EEMEM backup on
+    one bus never holds up wiper writes on another. A bus whose devices are all programming EEMEM
+    is skipped, so its programming time overlaps with traffic on the other buses.
+
+    @return Returns 0 if an operation ran successfully or nothing was runnable, otherwise the error
+            code of the operation that ran.
+    */
+    for (uint8_t n = 0; n < n_buses; n++) {
+        uint8_t i = next;
+        next = (next + 1) % n_buses;
+
+        uint8_t before = queued(i);
+        if (before == 0) { continue; }
+
+        uint8_t rv = sched[i]->run_one();
+        if (queued(i) == before) { continue; }      // Every queued device is busy.
+
+        transactions[i]++;
+        return (err_code = rv);
+    }
+
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xBusManager::service() {
+    /** Run operations, one bus at a time in turn, until no bus has runnable work. Call this
+    regularly, e.g. from `loop()`.
+
+    @return Returns 0 on no error, otherwise the error code of the last failed operation.
+    */
+    uint8_t rv = EC_NO_ERR;
+
+    while (true) {
+        uint32_t ran = 0;
+        for (uint8_t i = 0; i < n_buses; i++) {
+            ran += transactions[i];
+        }
+
+        uint8_t e = run_one();
+        if (e) { rv = e; }
+
+        for (uint8_t i = 0; i < n_buses; i++) {
+            ran -= transactions[i];
+        }
+
+        if (ran == 0) { break; }                    // Nothing was runnable.
+    }
+
+    return (err_code = rv);
+}
+
+uint32_t AD525xBusManager::get_wait_us() {
+    /** Retrieve how long until some bus can make progress. See `AD525xScheduler::get_wait_us()`.
+
+    @return Returns 0 if an operation is runnable now, the shortest wait of any bus otherwise, or
+            `AD525X_SCHED_IDLE` if nothing is queued on any bus.
+    */
+    uint32_t wait = AD525X_SCHED_IDLE;
+
+    for (uint8_t i = 0; i < n_buses; i++) {
+        uint32_t w = sched[i]->get_wait_us();
+        if (w < wait) { wait = w; }
+    }
+
+    return wait;
+}
+
+uint8_t AD525xBusManager::get_buses() {
+    /** Retrieve the number of buses added. */
+    return n_buses;
+}
+
+uint32_t AD525xBusManager::get_transactions(uint8_t index) {
+    /** Retrieve the number of operations run on bus `index`. */
+    return (index < n_buses) ? transactions[index] : 0;
+}
+
+uint8_t AD525xBusManager::get_err_code() {
+    /** Retrieve the error code of the last operation. See `AD525x_Errors.h`. */
+    return err_code;
+}
+
+//
+// Private functions
+//
+uint8_t AD525xBusManager::queued(uint8_t index) {
+    /** Total operations queued on bus `index`, over all priority classes. */
+    uint8_t n = 0;
+
+    for (uint8_t p = 0; p < AD525X_NUM_PRIO; p++) {
+        n += sched[index]->get_queued(p);
+    }
+
+    return n;
+}
@@ -0,0 +1,39 @@
+/** @file
+Header file for driving several I2C controllers (e.g. `Wire` and `Wire1`) side by side: one
+AD525xScheduler per bus, serviced round-robin so every bus keeps moving. Transfers are still
+blocking and run one at a time: buses are interleaved, never on the wire in parallel.
+*/
+#ifndef AD525X_BUSMANAGER_H
+#define AD525X_BUSMANAGER_H
+
+#include <AD525x.h>
+#include <AD525x_Scheduler.h>
+#include <cstdint>
+
+class AD525xBusManager {
+public:
+    AD525xBusManager();
+
+    uint8_t add_bus(AD525xScheduler &queue, uint8_t *index = NULL);
+
+    uint8_t run_one(void);
+    uint8_t service(void);
+
+    uint32_t get_wait_us(void);
+
+    uint8_t get_buses(void);
+    uint32_t get_transactions(uint8_t index);
+    uint8_t get_err_code(void);
+
+private:
+    uint8_t queued(uint8_t index);
+
+    AD525xScheduler *sched[AD525X_MAX_BUSES];   /*!< One queue per controller. */
+    uint32_t transactions[AD525X_MAX_BUSES];    /*!< Operations run per bus. */
+    uint8_t n_buses;
+    uint8_t next;                               /*!< Bus to serve first on the next turn. */
+
+    uint8_t err_code;
+};
+
+#endif
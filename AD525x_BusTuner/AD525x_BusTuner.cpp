@@ -0,0 +1,319 @@
+/** @file
+Class file for qualifying the I2C clock of an AD525x bus: probe rising SCL rates, verify
+error-free read-back at each, and run at the fastest stable one, shifting down while errors burst
+and back up when the link is clean.
+*/
+
+#include <AD525x_BusTuner.h>
+#include <AD525x_Errors.h>
+#include <Arduino.h>
+#include <Wire.h>
+
+static const uint32_t default_rates[] = {100000UL, 200000UL, 300000UL, 400000UL};
+
+AD525xBusTuner *AD525xBusTuner::attached[AD525X_MAX_BUSES];
+AD525xBusMonitor AD525xBusTuner::previous = NULL;
+void *AD525xBusTuner::previous_context = NULL;
+
+AD525xBusTuner::AD525xBusTuner() :
+    bus(&Wire), n_rates(1), current(0), max_passing(0), up_windows(AD525X_TUNE_UP_WINDOWS),
+    probing(false), qualifying(false), fallbacks(0), upshifts(0) {
+    /** Create a tuner. The bus clock is not touched until `qualify()`. */
+    rate[0] = default_rates[0];
+    loss[0] = 0;
+    clear_window();
+}
+
+uint8_t AD525xBusTuner::qualify(AD525x &pot, const uint32_t *rates, uint8_t n_rates) {
+    /** Find and apply the fastest reliable SCL rate for the bus of `pot`. The tuner then belongs
+    to that bus (`AD525x::get_bus()`); use one tuner per controller.
+
+    Reference values (the factory tolerance bytes and all 16 EEMEM registers) are read at the
+    slowest candidate. Each faster candidate must then read them back identically, with no bus
+    error, for `AD525X_TUNE_PASSES` rounds. The search stops at the first failure. For margin, the
+    fastest passing rate must also survive a soak of four times as many rounds, or the tuner steps
+    down one candidate. Nothing is written to the device.
+
+    The AD5253/AD5254 is rated for 400 kHz; faster candidates are allowed but at the caller's risk.
+    Every device on the bus shares the clock, so qualify with the slowest or most distant one.
+
+    @param[in] pot     An initialized device on the bus to qualify.
+    @param[in] rates   Candidate SCL rates in Hz, in any order. NULL for 100, 200, 300 and 400 kHz.
+    @param[in] n_rates Number of entries in `rates`, at most `AD525X_TUNE_MAX_RATES`.
+
+    @return Returns 0 on no error, `EC_BAD_REGISTER` for an empty or oversized rate list, or the
+            error raised while reading the references at the slowest rate, in which case that rate
+            is kept.
+    */
+    if (rates == NULL) {
+        rates = default_rates;
+        n_rates = sizeof(default_rates) / sizeof(default_rates[0]);
+    }
+
+    if (n_rates == 0 || n_rates > AD525X_TUNE_MAX_RATES) { return EC_BAD_REGISTER; }
+
+    // Insertion sort into ascending order.
+    for (uint8_t i = 0; i < n_rates; i++) {
+        uint8_t k = i;
+        for (; k > 0 && rate[k - 1] > rates[i]; k--) {
+            rate[k] = rate[k - 1];
+        }
+        rate[k] = rates[i];
+    }
+    this->n_rates = n_rates;
+    bus = &pot.get_bus();
+
+    qualifying = true;      // Probe errors are expected; keep an attached monitor out of it.
+    set_rate(0);
+    max_passing = 0;
+    probing = false;
+    for (uint8_t i = 0; i < n_rates; i++) {
+        loss[i] = 0;
+    }
+    up_windows = AD525X_TUNE_UP_WINDOWS;
+
+    for (uint8_t r = 0; r < 4; r++) {
+        AD525xToleranceResult t = pot.read_tolerance_result(r);
+        if (!t.ok()) {
+            qualifying = false;
+            return t.err;
+        }
+        tolerance[r] = t.value;
+    }
+
+    for (uint8_t reg = 0; reg < 16; reg++) {
+        AD525xResult e = pot.read_EEMEM_result(reg);
+        if (!e.ok()) {
+            qualifying = false;
+            return e.err;
+        }
+        eemem[reg] = e.value;
+    }
+
+    for (uint8_t i = 1; i < n_rates; i++) {
+        set_rate(i);
+        if (check(pot, AD525X_TUNE_PASSES)) { break; }
+        max_passing = i;
+    }
+
+    set_rate(max_passing);
+    if (max_passing > 0 && check(pot, 4 * AD525X_TUNE_PASSES)) {
+        max_passing--;
+        set_rate(max_passing);
+    }
+
+    qualifying = false;
+    return EC_NO_ERR;
+}
+
+uint8_t AD525xBusTuner::report(uint8_t err, uint8_t bytes) {
+    /** Feed the result of a transaction on the tuned bus. Called automatically after `attach()`.
+
+    Bus errors (NACKs, other I2C errors and short reads) are tracked over the last
+    `AD525X_TUNE_WINDOW` transactions, and the last full window of each rate is remembered. A rate
+    `r` losing a fraction `p` of its transactions delivers about `r * (1 - p)`. Once half a window
+    is seen, the clock shifts down one rate if the slower rate, at its remembered loss, is expected
+    to deliver a quarter more. A slower rate never measured counts as loss-free, hence the wide
+    margin. After each full window it shifts up one qualified rate if the faster one is expected to
+    deliver an eighth more. The remembered
+    loss of the faster rate halves every `AD525X_TUNE_UP_WINDOWS` windows, so a burst is retried
+    once it may have passed. An up-shift that is undone within one window doubles that wait, so a
+    marginal link does not oscillate.
+
+    @param[in] err   The error code of the transaction. Codes that are not bus errors are ignored.
+    @param[in] bytes Bytes transferred, for `get_goodput()`.
+
+    @return Returns `err` unchanged, so calls can be wrapped.
+    */
+    bool bus_error = (err >= EC_DATA_LONG && err <= EC_I2C_OTHER) || err == EC_BAD_READ_SIZE;
+    if (qualifying || (!bus_error && err != EC_NO_ERR)) { return err; }
+
+    if (window_len == AD525X_TUNE_WINDOW) {
+        if ((window >> (AD525X_TUNE_WINDOW - 1)) & 1) { errors--; }
+    } else {
+        window_len++;
+    }
+
+    window = (window << 1) | (bus_error ? 1 : 0);
+
+    if (bus_error) {
+        errors++;
+    } else {
+        bytes_ok += bytes;
+    }
+
+    uint8_t good = window_len - errors;
+
+    if (current > 0 && window_len >= AD525X_TUNE_WINDOW / 2 &&
+        better(current - 1, expected(current, good, window_len), 2)) {
+        loss[current] = (uint16_t)errors * AD525X_TUNE_WINDOW / window_len;
+        if (probing && up_windows < AD525X_TUNE_MAX_UP_WINDOWS) { up_windows *= 2; }
+        probing = false;
+
+        set_rate(current - 1);
+        fallbacks++;
+        return err;
+    }
+
+    if (window_len < AD525X_TUNE_WINDOW) { return err; }
+
+    loss[current] = (loss[current] + errors + 1) / 2;
+
+    if (probing) {
+        probing = false;                // The faster rate held for a full window.
+        up_windows = AD525X_TUNE_UP_WINDOWS;
+    }
+
+    if (current >= max_passing) { return err; }
+
+    // A clean window ages at the base pace, whatever the back-off.
+    aging += errors ? 1 : up_windows / AD525X_TUNE_UP_WINDOWS;
+    if (aging >= (uint16_t)up_windows * AD525X_TUNE_WINDOW) {
+        aging = 0;
+        loss[current + 1] /= 2;
+    }
+
+    if (better(current + 1, expected(current, good, AD525X_TUNE_WINDOW), 3)) {
+        set_rate(current + 1);
+        probing = true;
+        upshifts++;
+    }
+
+    return err;
+}
+
+void AD525xBusTuner::attach() {
+    /** Feed every AD525x transaction on this tuner's bus to `report()` automatically, via
+    `AD525x::set_bus_monitor()`. One tuner per bus can be attached at a time; attaching a second
+    tuner for the same bus replaces the first. Call after `qualify()`, which selects the bus.
+
+    A monitor installed before the first tuner is attached keeps receiving every transaction, and
+    is restored when the last tuner detaches. */
+    detach();
+
+    if (AD525x::get_bus_monitor() != on_transaction) {
+        previous = AD525x::get_bus_monitor(&previous_context);
+    }
+
+    for (uint8_t i = 0; i < AD525X_MAX_BUSES; i++) {
+        if (attached[i] == NULL || attached[i]->bus == bus) {
+            attached[i] = this;
+            break;
+        }
+    }
+
+    AD525x::set_bus_monitor(on_transaction);
+}
+
+void AD525xBusTuner::detach() {
+    /** Stop the automatic feed started by `attach()`. Once no tuner is attached, the monitor that
+    was installed before is restored. */
+    bool any = false;
+
+    for (uint8_t i = 0; i < AD525X_MAX_BUSES; i++) {
+        if (attached[i] == this) { attached[i] = NULL; }
+        if (attached[i] != NULL) { any = true; }
+    }
+
+    if (!any && AD525x::get_bus_monitor() == on_transaction) {
+        AD525x::set_bus_monitor(previous, previous_context);
+        previous = NULL;
+        previous_context = NULL;
+    }
+}
+
+uint32_t AD525xBusTuner::get_rate() {
+    /** Retrieve the SCL rate in use, in Hz. */
+    return rate[current];
+}
+
+uint32_t AD525xBusTuner::get_max_passing() {
+    /** Retrieve the fastest rate that passed qualification including the soak, in Hz. */
+    return rate[max_passing];
+}
+
+uint16_t AD525xBusTuner::get_fallbacks() {
+    /** Retrieve the number of times errors forced a slower rate. */
+    return fallbacks;
+}
+
+uint16_t AD525xBusTuner::get_upshifts() {
+    /** Retrieve the number of times a clean link moved to a faster rate. */
+    return upshifts;
+}
+
+uint32_t AD525xBusTuner::get_goodput() {
+    /** Retrieve the bytes per second of successful transactions since the last rate change. */
+    uint32_t elapsed = micros() - since;
+    if (elapsed == 0) { return 0; }
+
+    return (uint32_t)((uint64_t)bytes_ok * 1000000ULL / elapsed);
+}
+
+//
+// Private functions
+//
+void AD525xBusTuner::on_transaction(void *context, TwoWire *bus, uint8_t err, uint8_t bytes) {
+    /** Bus monitor shared by all attached tuners: pass the transaction on to the monitor it
+    replaced, then route it to the tuner of `bus`. */
+    (void)context;
+
+    if (previous != NULL) { previous(previous_context, bus, err, bytes); }
+
+    for (uint8_t i = 0; i < AD525X_MAX_BUSES; i++) {
+        if (attached[i] != NULL && attached[i]->bus == bus) {
+            attached[i]->report(err, bytes);
+            return;
+        }
+    }
+}
+
+uint8_t AD525xBusTuner::check(AD525x &pot, uint8_t rounds) {
+    /** Read every reference `rounds` times at the current rate. Returns 0 if all match, the bus
+    error if one occurred, or `EC_BAD_CHECKSUM` on a mismatch. */
+    for (uint8_t n = 0; n < rounds; n++) {
+        for (uint8_t r = 0; r < 4; r++) {
+            AD525xToleranceResult t = pot.read_tolerance_result(r);
+            if (!t.ok()) { return t.err; }
+            if (t.value != tolerance[r]) { return EC_BAD_CHECKSUM; }
+        }
+
+        for (uint8_t reg = 0; reg < 16; reg++) {
+            AD525xResult e = pot.read_EEMEM_result(reg);
+            if (!e.ok()) { return e.err; }
+            if (e.value != eemem[reg]) { return EC_BAD_CHECKSUM; }
+        }
+    }
+
+    return EC_NO_ERR;
+}
+
+void AD525xBusTuner::set_rate(uint8_t index) {
+    /** Switch the bus to candidate `index` and start a fresh error window. */
+    current = index;
+    bus->setClock(rate[index]);
+    clear_window();
+}
+
+void AD525xBusTuner::clear_window() {
+    /** Forget the transactions seen at the current rate. */
+    window = 0;
+    window_len = 0;
+    errors = 0;
+    aging = 0;
+    bytes_ok = 0;
+    since = micros();
+}
+
+uint32_t AD525xBusTuner::expected(uint8_t index, uint8_t good, uint8_t of) {
+    /** Expected goodput, in bits per second of clock, of candidate `index` when `good` of `of`
+    transactions succeed. */
+    return (uint64_t)rate[index] * good / of;
+}
+
+bool AD525xBusTuner::better(uint8_t index, uint32_t goodput, uint8_t margin) {
+    /** True if candidate `index`, at its remembered loss, is expected to beat `goodput` by more
+    than `goodput >> margin`. A margin of 0 compares plainly. */
+    uint32_t other = expected(index, AD525X_TUNE_WINDOW - loss[index], AD525X_TUNE_WINDOW);
+    return other > goodput + (margin ? goodput >> margin : 0);
+}
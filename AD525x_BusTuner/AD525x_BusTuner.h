@@ -0,0 +1,82 @@
+/** @file
+Header file for qualifying the I2C clock of an AD525x bus: probe rising SCL rates, verify
+error-free read-back at each, and run at the fastest stable one, shifting down while errors burst
+and back up when the link is clean.
+*/
+#ifndef AD525X_BUSTUNER_H
+#define AD525X_BUSTUNER_H
+
+#include <AD525x.h>
+#include <cstdint>
+
+#ifndef AD525X_TUNE_MAX_RATES
+#define AD525X_TUNE_MAX_RATES 8         /*!< Candidate SCL rates. */
+#endif
+
+#ifndef AD525X_TUNE_PASSES
+#define AD525X_TUNE_PASSES 8            /*!< Read-back rounds a candidate must pass. */
+#endif
+
+#ifndef AD525X_TUNE_WINDOW
+#define AD525X_TUNE_WINDOW 32           /*!< Transactions in the sliding error window, at most 32. */
+#endif
+
+#ifndef AD525X_TUNE_UP_WINDOWS
+#define AD525X_TUNE_UP_WINDOWS 4        /*!< Windows before the loss of a faster rate is retried. */
+#endif
+
+#define AD525X_TUNE_MAX_UP_WINDOWS 128  /*!< Limit of the back-off after failed up-shifts. */
+
+class AD525xBusTuner {
+public:
+    AD525xBusTuner();
+
+    uint8_t qualify(AD525x &pot, const uint32_t *rates = NULL, uint8_t n_rates = 0);
+    uint8_t report(uint8_t err, uint8_t bytes = 0);
+
+    void attach(void);
+    void detach(void);
+
+    uint32_t get_rate(void);
+    uint32_t get_max_passing(void);
+    uint16_t get_fallbacks(void);
+    uint16_t get_upshifts(void);
+    uint32_t get_goodput(void);
+
+private:
+    static void on_transaction(void *context, TwoWire *bus, uint8_t err, uint8_t bytes);
+
+    uint8_t check(AD525x &pot, uint8_t rounds);
+    void set_rate(uint8_t index);
+    void clear_window(void);
+    uint32_t expected(uint8_t index, uint8_t good, uint8_t of);
+    bool better(uint8_t index, uint32_t goodput, uint8_t margin);
+
+    static AD525xBusTuner *attached[AD525X_MAX_BUSES];  /*!< Attached tuners, one per bus. */
+    static AD525xBusMonitor previous;       /*!< Monitor installed before the first `attach()`. */
+    static void *previous_context;
+
+    TwoWire *bus;                           /*!< Controller whose clock is tuned. */
+    uint32_t rate[AD525X_TUNE_MAX_RATES];   /*!< Candidates, ascending. */
+    uint8_t n_rates;
+    uint8_t current;                        /*!< Index of the rate in use. */
+    uint8_t max_passing;                    /*!< Index of the fastest rate that passed. */
+    uint32_t window;                        /*!< One bit per recent transaction, 1 = bus error. */
+    uint8_t window_len;                     /*!< Valid bits in `window`. */
+    uint8_t errors;                         /*!< Set bits in `window`. */
+    uint8_t loss[AD525X_TUNE_MAX_RATES];    /*!< Smoothed errors per window at each rate. */
+    uint16_t aging;                         /*!< Progress toward halving the faster rate's loss. */
+    uint8_t up_windows;                     /*!< Windows between halvings of the faster rate's loss. */
+    bool probing;                           /*!< Shifted up and not yet proven for a window. */
+    bool qualifying;                        /*!< `qualify()` is running; ignore reports. */
+
+    uint16_t fallbacks;                     /*!< Down-shifts caused by errors. */
+    uint16_t upshifts;
+    uint32_t bytes_ok;                      /*!< Bytes of successful transactions at this rate. */
+    uint32_t since;                         /*!< `micros()` at the last rate change. */
+
+    float tolerance[4];                     /*!< Reference values read at the slowest rate. */
+    uint8_t eemem[16];
+};
+
+#endif
@@ -0,0 +1,103 @@
+/** @file
+Class file for a lock-free single-producer/single-consumer command ring, so an interrupt handler
+can post wiper setpoints that the main loop then writes to the device.
+*/
+
+#include <AD525x_CommandRing.h>
+#include <AD525x_Errors.h>
+
+AD525xCommandRing::AD525xCommandRing(AD525x &pot) :
+    pot(&pot), head(0), tail(0), overflows(0), high_water(0), target_mask(0), coalesced(0) {
+    /** Create an empty ring feeding `pot`. */
+}
+
+uint8_t AD525xCommandRing::push(uint8_t RDAC, uint8_t value) {
+    /** Post a wiper setpoint. Safe to call from an interrupt handler.
+
+    Touches no bus and takes no lock: a bounds check, a two-byte store and a release store of the
+    head index. If the ring is full the setpoint is dropped and counted in `get_overflows()`.
+
+    @return Returns 0 on no error, or `EC_NO_RESOURCES` if the ring is full.
+    */
+    uint8_t h = head;
+    uint8_t next = (h + 1) & (AD525X_RING_LEN - 1);
+
+    if (next == __atomic_load_n(&tail, __ATOMIC_ACQUIRE)) {
+        overflows++;
+        return EC_NO_RESOURCES;
+    }
+
+    ring[h].RDAC = RDAC;
+    ring[h].value = value;
+    __atomic_store_n(&head, next, __ATOMIC_RELEASE);
+
+    return EC_NO_ERR;
+}
+
+uint8_t AD525xCommandRing::drain() {
+    /** Empty the ring and write the result to the device. Call this from the main loop.
+
+    Entries are coalesced per RDAC, so however many setpoints the producer posted since the last
+    call, each wiper gets at most one `AD525x::move_RDAC()`, to its latest value. A write that
+    fails on the bus is kept and retried on the next call unless a newer setpoint replaces it.
+
+    @return Returns 0 on no error, otherwise the error code of the last failed write. Entries with
+            an RDAC above 3 are discarded with `EC_BAD_REGISTER`, and values above the device
+            maximum with `EC_BAD_WIPER_SETTING`.
+    */
+    uint8_t rv = EC_NO_ERR;
+    uint8_t t = tail;
+    uint8_t h = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+
+    uint8_t n = (h - t) & (AD525X_RING_LEN - 1);
+    if (n > high_water) { high_water = n; }
+
+    while (t != h) {
+        Entry e = ring[t];
+        t = (t + 1) & (AD525X_RING_LEN - 1);
+
+        if (e.RDAC > 3) {
+            rv = EC_BAD_REGISTER;
+            continue;
+        }
+
+        if (target_mask & (1 << e.RDAC)) { coalesced++; }
+
+        target[e.RDAC] = e.value;
+        target_mask |= (1 << e.RDAC);
+    }
+
+    __atomic_store_n(&tail, t, __ATOMIC_RELEASE);
+
+    for (uint8_t r = 0; r < 4; r++) {
+        if (!(target_mask & (1 << r))) { continue; }
+
+        // Only a bus error is worth retrying; a value the device refuses would fail forever.
+        uint8_t e = pot->move_RDAC(r, target[r]);
+        if (e) { rv = e; }
+        if (!(e >= EC_DATA_LONG && e <= EC_I2C_OTHER)) { target_mask &= ~(1 << r); }
+    }
+
+    return rv;
+}
+
+uint8_t AD525xCommandRing::get_pending() {
+    /** Retrieve the number of entries waiting in the ring. */
+    return (__atomic_load_n(&head, __ATOMIC_ACQUIRE) - tail) & (AD525X_RING_LEN - 1);
+}
+
+uint8_t AD525xCommandRing::get_high_water() {
+    /** Retrieve the most entries found in the ring by one `drain()`. Use this with
+    `get_overflows()` to size `AD525X_RING_LEN`; the ring holds at most `AD525X_RING_LEN - 1`. */
+    return high_water;
+}
+
+uint16_t AD525xCommandRing::get_overflows() {
+    /** Retrieve the number of setpoints dropped because the ring was full. */
+    return __atomic_load_n(&overflows, __ATOMIC_RELAXED);
+}
+
+uint32_t AD525xCommandRing::get_coalesced() {
+    /** Retrieve the number of setpoints replaced by a newer one before being written. */
+    return coalesced;
+}
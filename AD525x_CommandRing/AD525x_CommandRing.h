@@ -0,0 +1,53 @@
+/** @file
+Header file for a lock-free single-producer/single-consumer command ring, so an interrupt handler
+can post wiper setpoints that the main loop then writes to the device.
+*/
+#ifndef AD525X_COMMANDRING_H
+#define AD525X_COMMANDRING_H
+
+#include <AD525x.h>
+#include <cstdint>
+
+#ifndef AD525X_RING_LEN
+#define AD525X_RING_LEN 16      /*!< Ring slots; a power of two, at most 128. One slot is kept free. */
+#endif
+
+#if (AD525X_RING_LEN & (AD525X_RING_LEN - 1)) || AD525X_RING_LEN > 128
+#error "AD525X_RING_LEN must be a power of two no larger than 128"
+#endif
+
+class AD525xCommandRing {
+// The producer (one ISR or thread) calls only push(); the consumer (one main loop or thread)
+// calls everything else.
+public:
+    AD525xCommandRing(AD525x &pot);
+
+    uint8_t push(uint8_t RDAC, uint8_t value);
+
+    uint8_t drain(void);
+
+    uint8_t get_pending(void);
+    uint8_t get_high_water(void);
+    uint16_t get_overflows(void);
+    uint32_t get_coalesced(void);
+
+private:
+    struct Entry {
+        uint8_t RDAC;
+        uint8_t value;
+    };
+
+    AD525x *pot;
+
+    Entry ring[AD525X_RING_LEN];
+    uint8_t head;               /*!< Next slot to fill. Written by the producer only. */
+    uint8_t tail;               /*!< Next slot to drain. Written by the consumer only. */
+    uint16_t overflows;         /*!< Pushes dropped because the ring was full. Producer only. */
+    uint8_t high_water;         /*!< Most entries found by one `drain()`. */
+
+    uint8_t target[4];          /*!< Latest drained value per RDAC, not yet written. */
+    uint8_t target_mask;        /*!< RDACs with a value in `target`. */
+    uint32_t coalesced;         /*!< Drained entries replaced by a newer one before writing. */
+};
+
+#endif
@@ -0,0 +1,210 @@
+/** @file
+Class file for combining two RDACs of an AD5253/AD5254 into a single high-resolution
+potentiometer.
+*/
+
+#include <AD525x_Composite.h>
+#include <AD525x_Errors.h>
+
+AD525xComposite::AD525xComposite(AD525x &pot, uint8_t RDAC_a, uint8_t RDAC_b, uint8_t topology) :
+    pot(&pot), topology(topology), max_val(0), applied(false), calibrated(false), err_code(0) {
+    /** Bind two RDACs of `pot` into one composite resistor.
+
+    The object is not usable until `calibrate()` has been called, which reads the factory
+    tolerances from the device.
+
+    @param[in] pot      An initialized AD5253 or AD5254 object.
+    @param[in] RDAC_a   The first RDAC of the network [0-3].
+    @param[in] RDAC_b   The second RDAC of the network [0-3].
+    @param[in] topology Either `AD525xComposite::series` or `AD525xComposite::parallel`. Any other
+                        value sets `EC_BAD_REGISTER`, and `calibrate()` then refuses to run.
+    */
+    if (topology > AD525xComposite::parallel) { err_code = EC_BAD_REGISTER; }
+
+    RDAC[0] = RDAC_a;
+    RDAC[1] = RDAC_b;
+    code[0] = code[1] = 0;
+    step[0] = step[1] = offset[0] = offset[1] = 0;
+}
+
+uint8_t AD525xComposite::calibrate(float R_AB_nominal, float R_W) {
+    /** Compute the per-code resistance of both RDACs from the factory tolerance.
+
+    The W-B resistance of an RDAC is `R_WB(D) = D / (max_val + 1) * R_AB + R_W`, where `R_AB` is the
+    nominal end-to-end resistance corrected by the tolerance returned from `read_tolerance()`. Since
+    this is linear in `D`, each RDAC is fully described by a step and an offset, and no per-code
+    table needs to be held in RAM.
+
+    @param[in] R_AB_nominal The nominal end-to-end resistance of the part (e.g. 10000 for the 10 kOhm
+                            grade).
+    @param[in] R_W          The wiper resistance in ohms (75 typical).
+
+    @return Returns 0 on no error, otherwise the error code raised by `read_tolerance()`, or
+            `EC_BAD_REGISTER` if either RDAC or the topology is out of range or `R_AB_nominal` is
+            not positive.
+    */
+    calibrated = false;
+
+    if (RDAC[0] > 3 || RDAC[1] > 3 || RDAC[0] == RDAC[1]) { return (err_code = EC_BAD_REGISTER); }
+    if (topology > AD525xComposite::parallel) { return (err_code = EC_BAD_REGISTER); }
+    if (!(R_AB_nominal > 0)) { return (err_code = EC_BAD_REGISTER); }    // Also rejects NaN.
+
+    max_val = pot->get_max_val();
+
+    for (uint8_t i = 0; i < 2; i++) {
+        float tol = pot->read_tolerance(RDAC[i]);
+        if ((err_code = pot->get_err_code())) { return err_code; }
+
+        step[i] = R_AB_nominal * (1.0 + tol / 100.0) / (float(max_val) + 1.0);
+        offset[i] = R_W;
+
+        // `rdac_code()` divides by the step; a tolerance of -100 % or worse is a bad read.
+        if (!(step[i] > 0)) { return (err_code = EC_BAD_REGISTER); }
+    }
+
+    calibrated = true;
+    return (err_code = EC_NO_ERR);
+}
+
+float AD525xComposite::resistance(uint8_t code_a, uint8_t code_b) {
+    /** Calculate the resistance of the network for a pair of wiper codes.
+
+    @param[in] code_a The wiper code of the first RDAC.
+    @param[in] code_b The wiper code of the second RDAC.
+
+    @return Returns the calibrated network resistance in ohms.
+    */
+    float R_a = rdac_resistance(0, code_a);
+    float R_b = rdac_resistance(1, code_b);
+
+    if (topology == AD525xComposite::parallel) {
+        return R_a * R_b / (R_a + R_b);
+    }
+
+    return R_a + R_b;
+}
+
+uint8_t AD525xComposite::solve(float target, uint8_t *code_a, uint8_t *code_b) {
+    /** Find the pair of wiper codes whose network resistance is closest to `target`.
+
+    For each code of the first RDAC, the resistance required from the second RDAC is found by
+    inverting its (linear) transfer function, and only the two codes bracketing that value are
+    evaluated. This covers all (max_val + 1)^2 combinations in (max_val + 1) steps. Targets outside
+    the achievable range resolve to the nearest end point.
+
+    @param[in]  target Desired resistance in ohms.
+    @param[out] code_a Wiper code for the first RDAC.
+    @param[out] code_b Wiper code for the second RDAC.
+
+    @return Returns 0 on no error, or `EC_NOT_INITIALIZED` if `calibrate()` has not succeeded.
+    */
+    if (!calibrated) { return (err_code = EC_NOT_INITIALIZED); }
+
+    float best_err = -1;
+
+    for (uint16_t a = 0; a <= max_val; a++) {
+        float R_a = rdac_resistance(0, a);
+        float R_b;
+
+        if (topology == AD525xComposite::parallel) {
+            // R_b = target * R_a / (R_a - target); with R_a <= target, R_b would need to be infinite.
+            R_b = (R_a > target) ? target * R_a / (R_a - target) : rdac_resistance(1, max_val);
+        } else {
+            R_b = target - R_a;
+        }
+
+        uint8_t b = rdac_code(1, R_b);
+        for (uint8_t k = 0; k < 2 && b + k <= max_val; k++) {
+            float err = resistance(a, b + k) - target;
+            if (err < 0) { err = -err; }
+
+            if (best_err < 0 || err < best_err) {
+                best_err = err;
+                *code_a = a;
+                *code_b = b + k;
+            }
+        }
+    }
+
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xComposite::set_resistance(float target) {
+    /** Move the network to the resistance closest to `target`.
+
+    Only wipers whose code differs from the last value written by this object are written, so small
+    moves usually cost a single `write_RDAC()`.
+
+    @param[in] target Desired resistance in ohms.
+
+    @return Returns 0 on no error, otherwise the error code from `solve()` or `write_RDAC()`.
+    */
+    uint8_t next[2];
+    if (solve(target, &next[0], &next[1])) { return err_code; }
+
+    for (uint8_t i = 0; i < 2; i++) {
+        if (applied && next[i] == code[i]) { continue; }
+
+        if ((err_code = pot->write_RDAC(RDAC[i], next[i]))) {
+            applied = false;        // Device state is no longer known.
+            return err_code;
+        }
+        code[i] = next[i];
+    }
+
+    applied = true;
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xComposite::count_writes(float target) {
+    /** Retrieve how many wiper writes `set_resistance(target)` would issue now (0-2), e.g. to
+    price the move with `AD525xCostModel` before making it. Nothing is sent.
+
+    @return Returns the number of writes, or 0 if `solve()` fails (see `get_err_code()`).
+    */
+    uint8_t next[2];
+    if (solve(target, &next[0], &next[1])) { return 0; }
+
+    uint8_t writes = 0;
+    for (uint8_t i = 0; i < 2; i++) {
+        if (!applied || next[i] != code[i]) { writes++; }
+    }
+
+    return writes;
+}
+
+float AD525xComposite::get_resistance() {
+    /** Retrieve the calibrated resistance of the network as last set by `set_resistance()`.
+
+    @return Returns the resistance in ohms, or 0 if no setting has been applied.
+    */
+    if (!applied) { return 0; }
+
+    return resistance(code[0], code[1]);
+}
+
+uint8_t AD525xComposite::get_err_code() {
+    /** Retrieve the error code of the last operation. See `AD525x_Errors.h`.
+
+    @return Returns the error code. Non-zero value is an error.
+    */
+    return err_code;
+}
+
+//
+// Private functions
+//
+float AD525xComposite::rdac_resistance(uint8_t i, uint8_t code) {
+    /** Calibrated W-B resistance of RDAC `i` (0 or 1) at wiper code `code`. */
+    return step[i] * code + offset[i];
+}
+
+uint8_t AD525xComposite::rdac_code(uint8_t i, float R) {
+    /** Largest wiper code of RDAC `i` (0 or 1) not exceeding resistance `R`, clamped to range. */
+    float D = (R - offset[i]) / step[i];
+
+    if (D <= 0) { return 0; }
+    if (D >= max_val) { return max_val; }
+
+    return uint8_t(D);
+}
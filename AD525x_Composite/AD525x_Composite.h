@@ -0,0 +1,50 @@
+/** @file
+Header file for combining two RDACs of an AD5253/AD5254 into a single high-resolution
+potentiometer. A network is exactly two RDACs of one device; three- or four-RDAC networks are not
+supported.
+*/
+#ifndef AD525X_COMPOSITE_H
+#define AD525X_COMPOSITE_H
+
+#include <AD525x.h>
+#include <cstdint>
+
+class AD525xComposite {
+// Two RDACs of the same device wired in series or in parallel, treated as one resistor.
+public:
+    AD525xComposite(AD525x &pot, uint8_t RDAC_a, uint8_t RDAC_b, uint8_t topology);
+
+    uint8_t calibrate(float R_AB_nominal, float R_W = 75.0);
+
+    float resistance(uint8_t code_a, uint8_t code_b);
+    uint8_t solve(float target, uint8_t *code_a, uint8_t *code_b);
+
+    uint8_t set_resistance(float target);
+    uint8_t count_writes(float target);
+    float get_resistance(void);
+
+    uint8_t get_err_code(void);
+
+    static const uint8_t series = 0;        /*!< RDAC A and RDAC B W-B terminals in series. */
+    static const uint8_t parallel = 1;      /*!< RDAC A and RDAC B W-B terminals in parallel. */
+
+private:
+    float rdac_resistance(uint8_t i, uint8_t code);
+    uint8_t rdac_code(uint8_t i, float R);
+
+    AD525x *pot;            /*!< The device hosting both RDACs. */
+    uint8_t RDAC[2];        /*!< RDAC addresses of the two halves of the network. */
+    uint8_t topology;       /*!< `series` or `parallel`. */
+
+    float step[2];          /*!< Calibrated resistance per wiper code for each RDAC. */
+    float offset[2];        /*!< Wiper resistance of each RDAC. */
+    uint8_t max_val;        /*!< Maximum wiper code of the host device. */
+
+    uint8_t code[2];        /*!< Codes last written to the device. */
+    bool applied;           /*!< True once `code` reflects the device state. */
+    bool calibrated;
+
+    uint8_t err_code;
+};
+
+#endif
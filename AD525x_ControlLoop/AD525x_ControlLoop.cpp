@@ -0,0 +1,161 @@
+/** @file
+Class file for a fixed-rate, fixed-point PID loop that uses an AD525x wiper as its actuator.
+*/
+
+#include <AD525x_ControlLoop.h>
+#include <AD525x_Errors.h>
+#include <Arduino.h>
+
+AD525xControlLoop::AD525xControlLoop(AD525x &pot, uint8_t RDAC, uint32_t period_us,
+                                     AD525xFeedback feedback, void *context) :
+    pot(&pot), feedback(feedback), context(context), RDAC(RDAC), period_us(period_us),
+    next_tick(0), running(false), kp(0), ki(0), kd(0), setpoint(0), err_code(0) {
+    /** Create a control loop driving wiper `RDAC` of `pot` every `period_us` microseconds.
+
+    @param[in] pot       An initialized AD5253 or AD5254 object.
+    @param[in] RDAC      The RDAC used as the actuator [0-3].
+    @param[in] period_us The loop period in microseconds.
+    @param[in] feedback  Callback returning the current process value.
+    @param[in] context   Opaque pointer passed to `feedback`.
+    */
+    reset();
+}
+
+void AD525xControlLoop::set_gains(int32_t kp, int32_t ki, int32_t kd) {
+    /** Set the PID gains, as fixed point numbers with `frac_bits` fractional bits.
+
+    The wiper output is `(kp * e + ki * sum(e) + kd * d(input)) >> frac_bits`, clamped to the wiper
+    range, so a gain of `1 << frac_bits` maps one unit of process error to one wiper step.
+    */
+    this->kp = kp;
+    this->ki = ki;
+    this->kd = kd;
+}
+
+void AD525xControlLoop::set_setpoint(int32_t setpoint) {
+    /** Set the target process value. */
+    this->setpoint = setpoint;
+}
+
+void AD525xControlLoop::reset() {
+    /** Clear the controller state and statistics. The next `update()` ticks immediately. */
+    running = false;
+    integral = 0;
+    last_input = 0;
+    output = 0;
+
+    ticks = 0;
+    overruns = 0;
+    last_latency = 0;
+    max_latency = 0;
+}
+
+uint8_t AD525xControlLoop::update() {
+    /** Run a tick if one is due. Call this as often as possible, e.g. from `loop()`.
+
+    Ticks are scheduled on a fixed grid of `period_us`, so jitter in the caller does not accumulate
+    into drift. If the caller falls a full period or more behind, the missed ticks are dropped
+    rather than run back-to-back, and each occurrence is counted in `get_overruns()`.
+
+    @return Returns 0 if no tick was due or the tick succeeded, otherwise the error code of the
+            wiper update.
+    */
+    uint32_t now = micros();
+
+    if (!running) {
+        running = true;
+        next_tick = now;
+    }
+
+    if ((int32_t)(now - next_tick) < 0) { return EC_NO_ERR; }
+
+    next_tick += period_us;
+    if ((int32_t)(now - next_tick) >= 0) {
+        overruns++;
+        next_tick = now + period_us;
+    }
+
+    return tick();
+}
+
+uint8_t AD525xControlLoop::tick() {
+    /** Run one controller iteration immediately: sample, compute, actuate.
+
+    The wiper is moved with `AD525x::move_RDAC()`, so a steady output costs no bus traffic and a
+    single-step change costs a one-byte command. The wiper is never read back.
+
+    @return Returns 0 on no error, otherwise the error code from `AD525x::move_RDAC()`.
+    */
+    int32_t input = feedback(context);
+    int32_t error = setpoint - input;
+    int32_t max_val = pot->get_max_val();
+
+    int32_t d_input = (ticks == 0) ? 0 : input - last_input;
+    last_input = input;
+
+    // Past the point where the integral term alone drives the wiper full scale, a larger sum only
+    // winds up; bounding it there also keeps it within 32 bits whatever the proportional term does.
+    int64_t limit = 0x7FFFFFFFL;
+    if (ki != 0) {
+        int64_t reach = ((int64_t)max_val << frac_bits) / (ki < 0 ? -(int64_t)ki : ki) + 1;
+        if (reach < limit) { limit = reach; }
+    }
+
+    int64_t sum = (int64_t)integral + error;
+    if (sum > limit) { sum = limit; }
+    if (sum < -limit) { sum = -limit; }
+
+    int64_t u = (int64_t)kp * error + (int64_t)ki * sum - (int64_t)kd * d_input;
+    int64_t out = u >> frac_bits;
+
+    // Conditional integration: stop accumulating while the actuator is saturated (anti-windup).
+    if (out < 0) {
+        out = 0;
+        if (error > 0) { integral = (int32_t)sum; }
+    } else if (out > max_val) {
+        out = max_val;
+        if (error < 0) { integral = (int32_t)sum; }
+    } else {
+        integral = (int32_t)sum;
+    }
+
+    uint32_t start = micros();
+    err_code = pot->move_RDAC(RDAC, (uint8_t)out);
+    last_latency = micros() - start;
+
+    if (last_latency > max_latency) { max_latency = last_latency; }
+    if (!err_code) { output = (uint8_t)out; }
+
+    ticks++;
+    return err_code;
+}
+
+uint8_t AD525xControlLoop::get_output() {
+    /** Retrieve the wiper code successfully issued on the last tick. */
+    return output;
+}
+
+uint32_t AD525xControlLoop::get_ticks() {
+    /** Retrieve the number of ticks run since the last `reset()`. */
+    return ticks;
+}
+
+uint32_t AD525xControlLoop::get_overruns() {
+    /** Retrieve the number of times `update()` was called a full period or more late. */
+    return overruns;
+}
+
+uint32_t AD525xControlLoop::get_last_latency() {
+    /** Retrieve the duration of the last wiper update, in microseconds. */
+    return last_latency;
+}
+
+uint32_t AD525xControlLoop::get_max_latency() {
+    /** Retrieve the longest wiper update since the last `reset()`, in microseconds. */
+    return max_latency;
+}
+
+uint8_t AD525xControlLoop::get_err_code() {
+    /** Retrieve the error code of the last tick. See `AD525x_Errors.h`. */
+    return err_code;
+}
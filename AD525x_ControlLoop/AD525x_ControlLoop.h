@@ -0,0 +1,61 @@
+/** @file
+Header file for a fixed-rate, fixed-point PID loop that uses an AD525x wiper as its actuator.
+*/
+#ifndef AD525X_CONTROLLOOP_H
+#define AD525X_CONTROLLOOP_H
+
+#include <AD525x.h>
+#include <cstdint>
+
+/** Feedback source: returns the current process value, in the same units as the setpoint. */
+typedef int32_t (*AD525xFeedback)(void *context);
+
+class AD525xControlLoop {
+public:
+    AD525xControlLoop(AD525x &pot, uint8_t RDAC, uint32_t period_us, AD525xFeedback feedback,
+                      void *context = NULL);
+
+    void set_gains(int32_t kp, int32_t ki, int32_t kd);
+    void set_setpoint(int32_t setpoint);
+    void reset(void);
+
+    uint8_t update(void);
+    uint8_t tick(void);
+
+    uint8_t get_output(void);
+    uint32_t get_ticks(void);
+    uint32_t get_overruns(void);
+    uint32_t get_last_latency(void);
+    uint32_t get_max_latency(void);
+
+    uint8_t get_err_code(void);
+
+    static const uint8_t frac_bits = 16;    /*!< Gains are fixed point with this many fraction bits. */
+
+private:
+    AD525x *pot;
+    AD525xFeedback feedback;    /*!< User callback supplying the process value. */
+    void *context;              /*!< Passed through to `feedback`. */
+
+    uint8_t RDAC;
+    uint32_t period_us;         /*!< Loop period in microseconds. */
+    uint32_t next_tick;         /*!< `micros()` timestamp at which the next tick is due. */
+    bool running;
+
+    int32_t kp, ki, kd;         /*!< Gains in Q(31 - frac_bits).frac_bits fixed point. */
+    int32_t setpoint;
+    int32_t integral;           /*!< Accumulated error, in process units times ticks, bounded to
+                                     what drives the wiper full scale. */
+    int32_t last_input;
+
+    uint8_t output;             /*!< Wiper code issued on the last tick. */
+
+    uint32_t ticks;             /*!< Number of completed ticks. */
+    uint32_t overruns;          /*!< Ticks that started a full period or more late. */
+    uint32_t last_latency;      /*!< Duration of the last wiper update in microseconds. */
+    uint32_t max_latency;       /*!< Longest wiper update seen, in microseconds. */
+
+    uint8_t err_code;
+};
+
+#endif
@@ -0,0 +1,303 @@
+/** @file
+Class file for C++20 coroutine versions of the AD525x operations, and a single-threaded scheduler
+that interleaves many coroutine sequences across devices.
+*/
+
+#include <AD525x_Coroutine.h>
+
+#if defined(AD525X_HAS_COROUTINES)
+
+#include <AD525x_Errors.h>
+#include <Arduino.h>
+
+static_assert(AD525X_CORO_FRAME_SIZE % alignof(std::max_align_t) == 0,
+              "AD525X_CORO_FRAME_SIZE must be a multiple of the maximum alignment");
+
+alignas(std::max_align_t) static uint8_t frame_pool[AD525X_CORO_MAX_TASKS][AD525X_CORO_FRAME_SIZE];
+static bool frame_used[AD525X_CORO_MAX_TASKS];
+static uint8_t frames_in_use = 0;
+static uint8_t frame_high_water = 0;    // Most frames in use at once.
+static uint16_t largest_frame = 0;      // Largest frame requested, in bytes, even if refused.
+
+//
+// AD525xTask
+//
+AD525xTask AD525xTask::promise_type::get_return_object() {
+    return AD525xTask(std::coroutine_handle<promise_type>::from_promise(*this));
+}
+
+AD525xTask AD525xTask::promise_type::get_return_object_on_allocation_failure() {
+    /** Called when the frame pool is exhausted; `spawn()` rejects the resulting invalid task. */
+    return AD525xTask();
+}
+
+void *AD525xTask::promise_type::operator new(size_t size) noexcept {
+    /** Take a frame from the static pool. Returns NULL if the frame does not fit in
+    `AD525X_CORO_FRAME_SIZE` bytes or all `AD525X_CORO_MAX_TASKS` frames are in use. */
+    if (size > largest_frame) { largest_frame = size; }
+    if (size > AD525X_CORO_FRAME_SIZE) { return NULL; }
+
+    for (uint8_t i = 0; i < AD525X_CORO_MAX_TASKS; i++) {
+        if (!frame_used[i]) {
+            frame_used[i] = true;
+            if (++frames_in_use > frame_high_water) { frame_high_water = frames_in_use; }
+            return frame_pool[i];
+        }
+    }
+
+    return NULL;
+}
+
+void AD525xTask::promise_type::operator delete(void *frame, size_t size) {
+    (void)size;
+    frame_used[((uint8_t(*)[AD525X_CORO_FRAME_SIZE])frame) - frame_pool] = false;
+    frames_in_use--;
+}
+
+AD525xTask::~AD525xTask() {
+    // A task never handed to spawn() still owns its frame.
+    if (handle) { handle.destroy(); }
+}
+
+//
+// AD525xCoOp
+//
+bool AD525xCoOp::await_suspend(std::coroutine_handle<AD525xTask::promise_type> h) {
+    /** Run the operation at once if the device is free, without suspending. Otherwise suspend
+    until the device finishes programming EEMEM (or the sleep expires), letting other tasks run. */
+    AD525xTask::promise_type &p = h.promise();
+    uint32_t now = micros();
+
+    if (type == AD525xCoScheduler::op_sleep) {
+        p.wake = now + delay_us;
+        p.waiting_on = NULL;
+        return true;
+    }
+
+    uint32_t until;
+    if (sched->busy.busy_until(pot, now, &until)) {
+        p.wake = until;
+        p.waiting_on = pot;
+        return true;
+    }
+
+    result = sched->execute(type, pot, reg, value);
+    done = true;
+    return false;
+}
+
+AD525xResult AD525xCoOp::await_resume() {
+    /** Complete the operation if it was deferred, and return its value and error code. */
+    if (!done) {
+        result = sched->execute(type, pot, reg, value);
+        done = true;
+    }
+
+    return result;
+}
+
+//
+// AD525xCoScheduler
+//
+AD525xCoScheduler::AD525xCoScheduler() : busy(busy_slots, AD525X_CORO_MAX_BUSY) {
+    /** Create an empty scheduler. */
+    for (uint8_t i = 0; i < AD525X_CORO_MAX_TASKS; i++) {
+        task[i] = nullptr;
+        status[i] = NULL;
+    }
+}
+
+AD525xCoScheduler::~AD525xCoScheduler() {
+    for (uint8_t i = 0; i < AD525X_CORO_MAX_TASKS; i++) {
+        if (task[i]) { task[i].destroy(); }
+    }
+}
+
+uint8_t AD525xCoScheduler::spawn(AD525xTask &&task, volatile uint8_t *status) {
+    /** Hand a task to the scheduler. It first runs on the next `service()`.
+
+    @param[in]  task   A task returned by calling a coroutine, e.g. `spawn(backup(pot))`.
+    @param[out] status If not NULL, set to `AD525X_CORO_PENDING`, then to the task's `co_return`
+                       value when it finishes.
+
+    @return Returns 0 on no error, or `EC_NO_RESOURCES` if the task could not get a frame or all
+            `AD525X_CORO_MAX_TASKS` slots are in use.
+    */
+    if (!task.valid()) { return EC_NO_RESOURCES; }
+
+    for (uint8_t i = 0; i < AD525X_CORO_MAX_TASKS; i++) {
+        if (this->task[i]) { continue; }
+
+        this->task[i] = task.handle;
+        task.handle = nullptr;
+
+        this->task[i].promise().wake = micros();
+        this->status[i] = status;
+        if (status != NULL) { *status = AD525X_CORO_PENDING; }
+
+        return EC_NO_ERR;
+    }
+
+    return EC_NO_RESOURCES;
+}
+
+AD525xCoOp AD525xCoScheduler::move_RDAC(AD525x &pot, uint8_t RDAC, uint8_t value) {
+    /** `co_await` to move a wiper with `AD525x::move_RDAC()`. */
+    return AD525xCoOp(this, op_move_RDAC, &pot, RDAC, value, 0);
+}
+
+AD525xCoOp AD525xCoScheduler::read_RDAC(AD525x &pot, uint8_t RDAC) {
+    /** `co_await` to read a wiper from the device. */
+    return AD525xCoOp(this, op_read_RDAC, &pot, RDAC, 0, 0);
+}
+
+AD525xCoOp AD525xCoScheduler::write_EEMEM(AD525x &pot, uint8_t reg, uint8_t value) {
+    /** `co_await` to write an EEMEM register. Returns as soon as the write is sent; the next
+    operation on the same device waits out the programming time. */
+    return AD525xCoOp(this, op_write_EEMEM, &pot, reg, value, 0);
+}
+
+AD525xCoOp AD525xCoScheduler::read_EEMEM(AD525x &pot, uint8_t reg) {
+    /** `co_await` to read an EEMEM register. */
+    return AD525xCoOp(this, op_read_EEMEM, &pot, reg, 0, 0);
+}
+
+AD525xCoOp AD525xCoScheduler::store_RDAC(AD525x &pot, uint8_t RDAC) {
+    /** `co_await` to store a wiper to EEMEM. As `write_EEMEM()`, the device is then busy. */
+    return AD525xCoOp(this, op_store_RDAC, &pot, RDAC, 0, 0);
+}
+
+AD525xCoOp AD525xCoScheduler::restore_RDAC(AD525x &pot, uint8_t RDAC) {
+    /** `co_await` to restore a wiper from EEMEM. */
+    return AD525xCoOp(this, op_restore_RDAC, &pot, RDAC, 0, 0);
+}
+
+AD525xCoOp AD525xCoScheduler::sleep_ms(uint32_t ms) {
+    /** `co_await` to suspend the task for at least `ms` milliseconds. */
+    return AD525xCoOp(this, op_sleep, NULL, 0, 0, ms * 1000UL);
+}
+
+AD525xCoOp AD525xCoScheduler::yield() {
+    /** `co_await` to let every other ready task run once before continuing. */
+    return AD525xCoOp(this, op_sleep, NULL, 0, 0, 0);
+}
+
+uint8_t AD525xCoScheduler::service() {
+    /** Resume every task that is ready, once. Call this from `loop()`.
+
+    A task is ready when its sleep has expired and the device it waits for has finished programming
+    EEMEM. Finished tasks are destroyed and their status slot is filled in.
+
+    @return Returns the number of tasks still alive.
+    */
+    uint8_t active = 0;
+
+    for (uint8_t i = 0; i < AD525X_CORO_MAX_TASKS; i++) {
+        std::coroutine_handle<AD525xTask::promise_type> h = task[i];
+        if (!h) { continue; }
+
+        AD525xTask::promise_type &p = h.promise();
+        uint32_t now = micros();
+
+        if ((int32_t)(now - p.wake) < 0) {
+            active++;
+            continue;
+        }
+
+        if (p.waiting_on != NULL) {
+            uint32_t until;
+            if (busy.busy_until(p.waiting_on, now, &until)) {
+                p.wake = until;         // Another task started programming it meanwhile.
+                active++;
+                continue;
+            }
+            p.waiting_on = NULL;
+        }
+
+        h.resume();
+
+        if (h.done()) {
+            if (status[i] != NULL) { *status[i] = p.result; }
+            h.destroy();
+            task[i] = nullptr;
+        } else {
+            active++;
+        }
+    }
+
+    return active;
+}
+
+void AD525xCoScheduler::run() {
+    /** Call `service()` until every task has finished. */
+    while (service() > 0) {}
+}
+
+uint8_t AD525xCoScheduler::get_active() {
+    /** Retrieve the number of spawned tasks that have not finished. */
+    uint8_t n = 0;
+
+    for (uint8_t i = 0; i < AD525X_CORO_MAX_TASKS; i++) {
+        if (task[i]) { n++; }
+    }
+
+    return n;
+}
+
+uint8_t AD525xCoScheduler::get_busy_high_water() {
+    /** Retrieve the most devices programming EEMEM at once. A value above `AD525X_CORO_MAX_BUSY`
+    means a write had to wait out its programming time in place. */
+    return busy.get_high_water();
+}
+
+uint8_t AD525xCoScheduler::get_frame_high_water() {
+    /** Retrieve the most coroutine frames in use at once, across all schedulers. Use this to size
+    `AD525X_CORO_MAX_TASKS`. */
+    return frame_high_water;
+}
+
+uint16_t AD525xCoScheduler::get_largest_frame() {
+    /** Retrieve the size of the largest coroutine frame requested, in bytes, including refused
+    ones. Use this to size `AD525X_CORO_FRAME_SIZE`. */
+    return largest_frame;
+}
+
+//
+// Private functions
+//
+AD525xResult AD525xCoScheduler::execute(uint8_t type, AD525x *pot, uint8_t reg, uint8_t value) {
+    /** Run one operation on the bus. EEMEM writes mark the device busy. */
+    AD525xResult r = {0, EC_NO_ERR};
+
+    switch (type) {
+        case op_move_RDAC:
+            return {value, pot->move_RDAC(reg, value)};
+        case op_read_RDAC:
+            return pot->read_RDAC_result(reg);
+        case op_read_EEMEM:
+            return pot->read_EEMEM_result(reg);
+        case op_restore_RDAC:
+            return {0, pot->restore_RDAC(reg)};
+        case op_write_EEMEM:
+            r = {value, pot->write_EEMEM(reg, value)};
+            break;
+        case op_store_RDAC:
+            r = {0, pot->store_RDAC(reg)};
+            break;
+        default:
+            return r;
+    }
+
+    if (r.ok()) { set_busy(pot, micros()); }
+    return r;
+}
+
+void AD525xCoScheduler::set_busy(AD525x *pot, uint32_t now) {
+    /** Mark `pot` as programming EEMEM for the next `AD525X_EEMEM_WRITE_MS`. If every slot is in
+    use, wait out the programming time here instead, so the device is never addressed early. */
+    if (!busy.set_busy(pot, now + AD525X_EEMEM_WRITE_MS * 1000UL)) {
+        delay(AD525X_EEMEM_WRITE_MS);
+    }
+}
+
+#endif
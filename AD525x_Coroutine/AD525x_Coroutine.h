@@ -0,0 +1,144 @@
+/** @file
+Header file for C++20 coroutine versions of the AD525x operations, and a single-threaded scheduler
+that interleaves many coroutine sequences across devices.
+
+Only available when the compiler supports coroutines (`-std=c++20` or later and `<coroutine>`).
+*/
+#ifndef AD525X_COROUTINE_H
+#define AD525X_COROUTINE_H
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define AD525X_HAS_COROUTINES 1
+
+#include <AD525x.h>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef AD525X_CORO_MAX_TASKS
+#define AD525X_CORO_MAX_TASKS 8         /*!< Coroutines alive at once (spawned or not). */
+#endif
+
+#ifndef AD525X_CORO_FRAME_SIZE
+#define AD525X_CORO_FRAME_SIZE 256      /*!< Bytes per coroutine frame in the static pool. */
+#endif
+
+#ifndef AD525X_CORO_MAX_BUSY
+#define AD525X_CORO_MAX_BUSY 4          /*!< Devices that can be programming EEMEM at the same time. */
+#endif
+
+#define AD525X_CORO_PENDING 0xFF        /*!< Status value of a task that has not finished. */
+
+class AD525xCoScheduler;
+
+class AD525xTask {
+// Return type of a device sequence: `AD525xTask seq(...) { ...; co_return err; }`. Starts
+// suspended and runs once handed to `AD525xCoScheduler::spawn()`.
+public:
+    struct promise_type {
+        uint32_t wake = 0;          /*!< `micros()` timestamp before which the task is not resumed. */
+        AD525x *waiting_on = NULL;  /*!< Device whose EEMEM programming the task waits out, or
+                                         NULL. */
+        uint8_t result = 0;         /*!< Value of `co_return`. */
+
+        AD525xTask get_return_object(void);
+        static AD525xTask get_return_object_on_allocation_failure(void);
+
+        std::suspend_always initial_suspend(void) noexcept { return {}; }
+        std::suspend_always final_suspend(void) noexcept { return {}; }
+        void return_value(uint8_t err) { result = err; }
+        void unhandled_exception(void) {}
+
+        // Frames come from a static pool, never from the heap.
+        static void *operator new(size_t size) noexcept;
+        static void operator delete(void *frame, size_t size);
+    };
+
+    AD525xTask() : handle(nullptr) {};
+    AD525xTask(AD525xTask &&other) : handle(other.handle) { other.handle = nullptr; };
+    AD525xTask(const AD525xTask &) = delete;
+    AD525xTask &operator=(const AD525xTask &) = delete;
+    ~AD525xTask();
+
+    bool valid(void) const { return (bool)handle; }
+
+private:
+    friend class AD525xCoScheduler;
+    explicit AD525xTask(std::coroutine_handle<promise_type> h) : handle(h) {};
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+class AD525xCoOp {
+// Awaitable returned by the AD525xCoScheduler operations. `co_await` yields an AD525xResult.
+public:
+    AD525xCoOp(AD525xCoScheduler *sched, uint8_t type, AD525x *pot, uint8_t reg, uint8_t value,
+               uint32_t delay_us) :
+        sched(sched), pot(pot), delay_us(delay_us), type(type), reg(reg), value(value), done(false)
+        {};
+
+    bool await_ready(void) { return false; }
+    bool await_suspend(std::coroutine_handle<AD525xTask::promise_type> h);
+    AD525xResult await_resume(void);
+
+private:
+    AD525xCoScheduler *sched;
+    AD525x *pot;
+    uint32_t delay_us;
+    uint8_t type;
+    uint8_t reg;
+    uint8_t value;
+    bool done;
+    AD525xResult result;
+};
+
+class AD525xCoScheduler {
+public:
+    AD525xCoScheduler();
+    ~AD525xCoScheduler();
+
+    uint8_t spawn(AD525xTask &&task, volatile uint8_t *status = NULL);
+
+    // Awaitables, for use inside tasks
+    AD525xCoOp move_RDAC(AD525x &pot, uint8_t RDAC, uint8_t value);
+    AD525xCoOp read_RDAC(AD525x &pot, uint8_t RDAC);
+    AD525xCoOp write_EEMEM(AD525x &pot, uint8_t reg, uint8_t value);
+    AD525xCoOp read_EEMEM(AD525x &pot, uint8_t reg);
+    AD525xCoOp store_RDAC(AD525x &pot, uint8_t RDAC);
+    AD525xCoOp restore_RDAC(AD525x &pot, uint8_t RDAC);
+    AD525xCoOp sleep_ms(uint32_t ms);
+    AD525xCoOp yield(void);
+
+    uint8_t service(void);
+    void run(void);
+
+    uint8_t get_active(void);
+    uint8_t get_busy_high_water(void);
+
+    static uint8_t get_frame_high_water(void);
+    static uint16_t get_largest_frame(void);
+
+private:
+    friend class AD525xCoOp;
+
+    AD525xResult execute(uint8_t type, AD525x *pot, uint8_t reg, uint8_t value);
+    void set_busy(AD525x *pot, uint32_t now);
+
+    static const uint8_t op_move_RDAC = 0;
+    static const uint8_t op_read_RDAC = 1;
+    static const uint8_t op_write_EEMEM = 2;
+    static const uint8_t op_read_EEMEM = 3;
+    static const uint8_t op_store_RDAC = 4;
+    static const uint8_t op_restore_RDAC = 5;
+    static const uint8_t op_sleep = 6;
+
+    std::coroutine_handle<AD525xTask::promise_type> task[AD525X_CORO_MAX_TASKS];
+    volatile uint8_t *status[AD525X_CORO_MAX_TASKS];
+
+    AD525xBusySlot busy_slots[AD525X_CORO_MAX_BUSY];
+    AD525xBusyTable busy;           /*!< Devices programming EEMEM, in `micros()`. */
+};
+
+#endif
+
+#endif
@@ -0,0 +1,227 @@
+/** @file
+Class file for predicting the bus cost (transactions, bytes and wire time) of AD525x operations
+and batches, so work can be checked against a frame budget before it is submitted.
+*/
+
+#include <AD525x_CostModel.h>
+#include <AD525x_Errors.h>
+#include <Arduino.h>
+
+AD525xCostModel::AD525xCostModel(uint32_t clock_hz, uint16_t overhead_us) :
+    clock_hz(clock_hz), overhead_us(overhead_us), samples(0), measured_sum(0), error_sum(0) {
+    /** Create a model of one bus.
+
+    @param[in] clock_hz    SCL rate in Hz, e.g. `AD525xBusTuner::get_rate()`.
+    @param[in] overhead_us Time per transaction beyond the bus clocks (driver, controller, clock
+                           stretching). 0 until `calibrate()` measures it.
+    */
+}
+
+void AD525xCostModel::set_clock(uint32_t clock_hz) {
+    /** Change the SCL rate the model assumes, e.g. after the bus tuner shifts. */
+    this->clock_hz = clock_hz;
+}
+
+void AD525xCostModel::set_overhead_us(uint16_t overhead_us) {
+    /** Set the per-transaction overhead, e.g. a value saved from an earlier `calibrate()`. */
+    this->overhead_us = overhead_us;
+}
+
+AD525xCost AD525xCostModel::none() {
+    /** The empty cost, to start a batch with `AD525xCost::add()`. */
+    AD525xCost c = {0, 0, 0, 0};
+    return c;
+}
+
+AD525xCost AD525xCostModel::write_RDAC() {
+    /** Cost of `AD525x::write_RDAC()`: one transaction of address, register and value. */
+    return transaction(3);
+}
+
+AD525xCost AD525xCostModel::read_RDAC() {
+    /** Cost of `AD525x::read_RDAC()`.
+
+    The driver selects the register (address and register byte), reads (address and data byte),
+    then ends with an address-only write: three transactions.
+    */
+    AD525xCost c = transaction(2);
+    c.add(transaction(2));
+    c.add(transaction(1));
+    return c;
+}
+
+AD525xCost AD525xCostModel::move_RDAC(AD525x &pot, uint8_t RDAC, uint8_t value) {
+    /** Cost of `AD525x::move_RDAC()` with the device's current cache: nothing for a move to the
+    current value, a one-byte command for a single step, otherwise a write. A move the driver
+    refuses before reaching the bus (device not initialized, bad RDAC or value) costs nothing.
+    The device is only inspected, never addressed. */
+    uint8_t current;
+
+    if (pot.get_dev_addr() == 0 || RDAC > 3 || value > pot.get_max_val()) { return none(); }
+
+    if (pot.peek_RDAC(RDAC, &current)) {
+        if (value == current) { return none(); }
+        if (value == current + 1 || value + 1 == current) { return command(); }
+    }
+
+    return write_RDAC();
+}
+
+AD525xCost AD525xCostModel::write_EEMEM() {
+    /** Cost of `AD525x::write_EEMEM()`: one write, after which the device programs for up to
+    `AD525X_EEMEM_WRITE_MS` and must not be addressed. */
+    AD525xCost c = transaction(3);
+    c.busy_us = AD525X_EEMEM_WRITE_MS * 1000UL;
+    return c;
+}
+
+AD525xCost AD525xCostModel::read_EEMEM() {
+    /** Cost of `AD525x::read_EEMEM()`. See `read_RDAC()`. */
+    return read_RDAC();
+}
+
+AD525xCost AD525xCostModel::read_tolerance() {
+    /** Cost of `AD525x::read_tolerance()`: two register reads, integer and fraction. */
+    AD525xCost c = read_RDAC();
+    c.add(read_RDAC());
+    return c;
+}
+
+AD525xCost AD525xCostModel::command() {
+    /** Cost of a data-less command such as `increment_RDAC()` or `restore_RDAC()`. */
+    return transaction(2);
+}
+
+AD525xCost AD525xCostModel::store_RDAC() {
+    /** Cost of `AD525x::store_RDAC()`: a command that programs EEMEM. See `write_EEMEM()`. */
+    AD525xCost c = command();
+    c.busy_us = AD525X_EEMEM_WRITE_MS * 1000UL;
+    return c;
+}
+
+AD525xCost AD525xCostModel::set_resistance(AD525xComposite &composite, float target) {
+    /** Cost of `AD525xComposite::set_resistance(target)` from the composite's current state. */
+    AD525xCost c = none();
+
+    for (uint8_t n = composite.count_writes(target); n > 0; n--) {
+        c.add(write_RDAC());
+    }
+
+    return c;
+}
+
+bool AD525xCostModel::fits(const AD525xCost &cost, uint32_t budget_us, bool wait_busy) {
+    /** True if `cost` completes within `budget_us`.
+
+    @param[in] cost      A single operation or a batch.
+    @param[in] budget_us The time available, e.g. what is left of a control frame.
+    @param[in] wait_busy Also require EEMEM programming to finish within the budget, for callers
+                         that must address the same device again in the next frame.
+    */
+    uint32_t total = cost.wire_us + (wait_busy ? cost.busy_us : 0);
+    return total <= budget_us;
+}
+
+uint8_t AD525xCostModel::calibrate(AD525x &pot, uint8_t rounds) {
+    /** Measure `pot` to fit the per-transaction overhead, then validate the model.
+
+    Each round times a wiper read, a write of the same value back (so nothing changes) and an
+    EEMEM read with `micros()`. The smallest time beyond the bus clocks per transaction becomes the
+    overhead: interrupts and preemption only ever add time, so the minimum is the least disturbed
+    estimate. A second set of rounds is then checked against the fitted model; see
+    `get_error_pct()`. Set the clock first.
+
+    @return Returns 0 on no error, otherwise the bus error that stopped calibration. The overhead
+            is left unchanged on error.
+    */
+    uint16_t saved = overhead_us;
+    uint32_t fitted = 0xFFFFFFFFUL;
+
+    overhead_us = 0;
+    samples = measured_sum = error_sum = 0;
+
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        for (uint8_t n = 0; n < rounds; n++) {
+            uint8_t RDAC = n & 3;
+            uint32_t t[4];
+
+            t[0] = micros();
+            AD525xResult w = pot.read_RDAC_result(RDAC);
+            t[1] = micros();
+            uint8_t err = w.err ? w.err : pot.write_RDAC(RDAC, w.value);
+            t[2] = micros();
+            AD525xResult e = err ? w : pot.read_EEMEM_result(RDAC);
+            t[3] = micros();
+
+            if (err || e.err) {
+                overhead_us = saved;
+                return err ? err : e.err;
+            }
+
+            AD525xCost c[3] = {read_RDAC(), write_RDAC(), read_EEMEM()};
+            for (uint8_t k = 0; k < 3; k++) {
+                uint32_t measured = t[k + 1] - t[k];
+
+                if (pass == 0) {
+                    uint32_t excess = (measured > c[k].wire_us) ? measured - c[k].wire_us : 0;
+                    excess /= c[k].transactions;
+                    if (excess < fitted) { fitted = excess; }
+                } else {
+                    record(c[k], measured);
+                }
+            }
+        }
+
+        if (pass == 0 && rounds > 0) {
+            overhead_us = (fitted > 0xFFFF) ? 0xFFFF : fitted;
+        }
+    }
+
+    return EC_NO_ERR;
+}
+
+void AD525xCostModel::record(const AD525xCost &predicted, uint32_t measured_us) {
+    /** Compare a prediction with a measurement, e.g. `micros()` around the operation or a
+    scheduler latency, to keep track of the model's accuracy in service. */
+    uint32_t err = (measured_us > predicted.wire_us) ? measured_us - predicted.wire_us :
+                                                       predicted.wire_us - measured_us;
+
+    samples++;
+    measured_sum += measured_us;
+    error_sum += err;
+}
+
+uint16_t AD525xCostModel::get_overhead_us() {
+    /** Retrieve the per-transaction overhead in use, to save it for `set_overhead_us()`. */
+    return overhead_us;
+}
+
+uint16_t AD525xCostModel::get_error_pct() {
+    /** Retrieve the mean absolute prediction error of the recorded samples, in percent of the
+    measured time. */
+    if (measured_sum == 0) { return 0; }
+
+    return (uint16_t)((error_sum * 100ULL + measured_sum / 2) / measured_sum);
+}
+
+uint32_t AD525xCostModel::get_samples() {
+    /** Retrieve the number of measurements recorded since the last `calibrate()`. */
+    return samples;
+}
+
+//
+// Private functions
+//
+AD525xCost AD525xCostModel::transaction(uint8_t bytes) {
+    /** Cost of one transaction of `bytes` bytes, address included: 9 clocks per byte (8 data bits
+    and the acknowledge) plus framing, rounded up to whole microseconds, plus the overhead. */
+    uint32_t clocks = 9UL * bytes + AD525X_COST_FRAMING_CLOCKS;
+    AD525xCost c;
+
+    c.transactions = 1;
+    c.bytes = bytes;
+    c.wire_us = (clocks * 1000000UL + clock_hz - 1) / clock_hz + overhead_us;
+    c.busy_us = 0;
+
+    return c;
+}
@@ -0,0 +1,77 @@
+/** @file
+Header file for predicting the bus cost (transactions, bytes and wire time) of AD525x operations
+and batches, so work can be checked against a frame budget before it is submitted.
+*/
+#ifndef AD525X_COSTMODEL_H
+#define AD525X_COSTMODEL_H
+
+#include <AD525x.h>
+#include <AD525x_Composite.h>
+#include <cstdint>
+
+#define AD525X_COST_FRAMING_CLOCKS 2    /*!< SCL periods for the start and stop conditions. */
+
+/** Predicted cost of one operation or a batch. Build batches with `add()` (same bus, one after the
+other) and `overlap()` (different buses, at the same time). */
+struct AD525xCost {
+    uint16_t transactions;  /*!< I2C transactions (start ... stop). */
+    uint16_t bytes;         /*!< Bytes on the wire, including address bytes. */
+    uint32_t wire_us;       /*!< Bus time, including the per-transaction overhead. */
+    uint32_t busy_us;       /*!< EEMEM programming still running when the last transaction ends. */
+
+    void add(const AD525xCost &c) {
+        transactions += c.transactions;
+        bytes += c.bytes;
+        busy_us = (busy_us > c.wire_us) ? busy_us - c.wire_us : 0;
+        if (c.busy_us > busy_us) { busy_us = c.busy_us; }
+        wire_us += c.wire_us;
+    }
+
+    void overlap(const AD525xCost &c) {
+        transactions += c.transactions;
+        bytes += c.bytes;
+        if (c.wire_us > wire_us) { wire_us = c.wire_us; }
+        if (c.busy_us > busy_us) { busy_us = c.busy_us; }
+    }
+};
+
+class AD525xCostModel {
+public:
+    AD525xCostModel(uint32_t clock_hz = 100000UL, uint16_t overhead_us = 0);
+
+    void set_clock(uint32_t clock_hz);
+    void set_overhead_us(uint16_t overhead_us);
+
+    // Single operations, as issued by the AD525x driver
+    AD525xCost none(void);
+    AD525xCost write_RDAC(void);
+    AD525xCost read_RDAC(void);
+    AD525xCost move_RDAC(AD525x &pot, uint8_t RDAC, uint8_t value);
+    AD525xCost write_EEMEM(void);
+    AD525xCost read_EEMEM(void);
+    AD525xCost read_tolerance(void);
+    AD525xCost command(void);
+    AD525xCost store_RDAC(void);
+    AD525xCost set_resistance(AD525xComposite &composite, float target);
+
+    bool fits(const AD525xCost &cost, uint32_t budget_us, bool wait_busy = false);
+
+    // Calibration against measured timings
+    uint8_t calibrate(AD525x &pot, uint8_t rounds = 8);
+    void record(const AD525xCost &predicted, uint32_t measured_us);
+    uint16_t get_overhead_us(void);
+    uint16_t get_error_pct(void);
+    uint32_t get_samples(void);
+
+private:
+    AD525xCost transaction(uint8_t bytes);
+
+    uint32_t clock_hz;
+    uint16_t overhead_us;       /*!< Driver and controller time per transaction beyond the clocks. */
+
+    uint32_t samples;           /*!< Measurements passed to `record()`. */
+    uint32_t measured_sum;      /*!< Sum of measured times, microseconds. */
+    uint32_t error_sum;         /*!< Sum of absolute prediction errors, microseconds. */
+};
+
+#endif
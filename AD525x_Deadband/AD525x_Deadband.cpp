@@ -0,0 +1,147 @@
+/** @file
+Class file for a per-RDAC deadband/hysteresis filter that sits between a noisy setpoint source and
+an AD525x device.
+*/
+
+#include <AD525x_Deadband.h>
+#include <AD525x_Errors.h>
+#include <Arduino.h>
+
+AD525xDeadband::AD525xDeadband(AD525x &pot) : pot(&pot), err_code(0) {
+    /** Create a filter in front of `pot`. All channels start with no deadband, no hysteresis and no
+    hold time, which only drops requests that repeat the current value. */
+    for (uint8_t i = 0; i < 4; i++) {
+        configure(i, 0, 0, 0);
+    }
+}
+
+uint8_t AD525xDeadband::configure(uint8_t RDAC, uint8_t deadband, uint8_t hysteresis,
+                                  uint16_t hold_ms) {
+    /** Set the filter thresholds for one RDAC and clear its state and counters.
+
+    @param[in] RDAC       The RDAC to configure [0-3].
+    @param[in] deadband   Requests within this many steps of the current wiper are dropped.
+    @param[in] hysteresis Additional steps a request must move to reverse the direction of the last
+                          write. This suppresses the +1/-1 dithering of a value sitting on a code
+                          boundary.
+    @param[in] hold_ms    Minimum time between two writes. Requests inside the hold time are
+                          deferred; the latest one is written by `service()` once it expires.
+
+    @return Returns 0 on no error, or `EC_BAD_REGISTER` if `RDAC` exceeds 3.
+    */
+    if (RDAC > 3) { return (err_code = EC_BAD_REGISTER); }
+
+    Channel &c = channel[RDAC];
+    c.deadband = deadband;
+    c.hysteresis = hysteresis;
+    c.hold_ms = hold_ms;
+
+    c.out = c.pending = 0;
+    c.dir = 0;
+    c.has_out = c.has_pending = false;
+    c.last_write = 0;
+    c.absorbed = c.passed = 0;
+
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xDeadband::set(uint8_t RDAC, uint8_t value) {
+    /** Request a new wiper value, which is written only if it clears the filter.
+
+    @param[in] RDAC  The RDAC to move [0-3].
+    @param[in] value The requested wiper value.
+
+    @return Returns 0 if the request was absorbed, deferred or written successfully, otherwise the
+            error code from `AD525x::move_RDAC()` or `EC_BAD_REGISTER`.
+    */
+    if (RDAC > 3) { return (err_code = EC_BAD_REGISTER); }
+
+    Channel &c = channel[RDAC];
+
+    if (c.has_out) {
+        int16_t delta = int16_t(value) - int16_t(c.out);
+        int16_t threshold = c.deadband;
+
+        if ((delta > 0 && c.dir < 0) || (delta < 0 && c.dir > 0)) {
+            threshold += c.hysteresis;
+        }
+
+        if (delta <= threshold && delta >= -threshold) {
+            if (c.has_pending) { c.absorbed++; }    // A deferred move is cancelled as well.
+            c.has_pending = false;
+            c.absorbed++;
+            return (err_code = EC_NO_ERR);
+        }
+
+        if (millis() - c.last_write < c.hold_ms) {
+            if (c.has_pending) { c.absorbed++; }    // Superseded before reaching the bus.
+            c.pending = value;
+            c.has_pending = true;
+            return (err_code = EC_NO_ERR);
+        }
+    }
+
+    return apply(RDAC, value);
+}
+
+uint8_t AD525xDeadband::service() {
+    /** Write any deferred requests whose hold time has expired. Call this regularly, e.g. from
+    `loop()`, when a hold time is configured.
+
+    @return Returns 0 on no error, otherwise the error code of the last failed write. Failed
+            requests stay pending and are retried on the next call.
+    */
+    uint8_t rv = EC_NO_ERR;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        Channel &c = channel[i];
+
+        if (c.has_pending && millis() - c.last_write >= c.hold_ms) {
+            if (apply(i, c.pending)) { rv = err_code; }
+        }
+    }
+
+    return (err_code = rv);
+}
+
+uint32_t AD525xDeadband::get_absorbed(uint8_t RDAC) {
+    /** Retrieve the number of requests for `RDAC` that were dropped or superseded. */
+    return (RDAC > 3) ? 0 : channel[RDAC].absorbed;
+}
+
+uint32_t AD525xDeadband::get_passed(uint8_t RDAC) {
+    /** Retrieve the number of requests for `RDAC` that were written to the device. */
+    return (RDAC > 3) ? 0 : channel[RDAC].passed;
+}
+
+uint8_t AD525xDeadband::get_err_code() {
+    /** Retrieve the error code of the last operation. See `AD525x_Errors.h`. */
+    return err_code;
+}
+
+//
+// Private functions
+//
+uint8_t AD525xDeadband::apply(uint8_t RDAC, uint8_t value) {
+    /** Write `value` to the wiper and update the filter state. On failure the value is kept
+    pending so `service()` retries it. */
+    Channel &c = channel[RDAC];
+
+    if ((err_code = pot->move_RDAC(RDAC, value))) {
+        c.pending = value;
+        c.has_pending = true;
+        return err_code;
+    }
+
+    if (c.has_out) {
+        c.dir = (value > c.out) ? 1 : ((value < c.out) ? -1 : c.dir);
+    }
+
+    c.out = value;
+    c.has_out = true;
+    c.has_pending = false;
+    c.last_write = millis();
+    c.passed++;
+
+    return err_code;
+}
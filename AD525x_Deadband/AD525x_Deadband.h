@@ -0,0 +1,49 @@
+/** @file
+Header file for a per-RDAC deadband/hysteresis filter that sits between a noisy setpoint source and
+an AD525x device.
+*/
+#ifndef AD525X_DEADBAND_H
+#define AD525X_DEADBAND_H
+
+#include <AD525x.h>
+#include <cstdint>
+
+class AD525xDeadband {
+public:
+    AD525xDeadband(AD525x &pot);
+
+    uint8_t configure(uint8_t RDAC, uint8_t deadband, uint8_t hysteresis, uint16_t hold_ms);
+
+    uint8_t set(uint8_t RDAC, uint8_t value);
+    uint8_t service(void);
+
+    uint32_t get_absorbed(uint8_t RDAC);
+    uint32_t get_passed(uint8_t RDAC);
+
+    uint8_t get_err_code(void);
+
+private:
+    uint8_t apply(uint8_t RDAC, uint8_t value);
+
+    struct Channel {
+        uint8_t deadband;       /*!< Changes of this many steps or fewer are dropped. */
+        uint8_t hysteresis;     /*!< Extra steps required to reverse the direction of travel. */
+        uint16_t hold_ms;       /*!< Minimum time between two writes to the wiper. */
+
+        uint8_t out;            /*!< Value last written to the wiper. */
+        uint8_t pending;        /*!< Value waiting for the hold time to expire. */
+        int8_t dir;             /*!< Direction of the last write: -1, 0 or +1. */
+        bool has_out;
+        bool has_pending;
+
+        uint32_t last_write;    /*!< `millis()` at the last write. */
+        uint32_t absorbed;      /*!< Requests that never reached the bus. */
+        uint32_t passed;        /*!< Requests that were written to the bus. */
+    };
+
+    AD525x *pot;
+    Channel channel[4];
+    uint8_t err_code;
+};
+
+#endif
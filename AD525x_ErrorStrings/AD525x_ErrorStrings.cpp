@@ -12,7 +12,7 @@ const char *AD525xGetErrorString(uint8_t err_code) {
 
     @return Returns the human-readable string describing the current error code.
     */
-    switch(get_err_code()) {
+    switch(err_code) {
         case EC_NO_ERR:
             return EC_NO_ERR_str;
         case EC_DATA_LONG:
@@ -33,6 +33,12 @@ const char *AD525xGetErrorString(uint8_t err_code) {
             return EC_BAD_DEVICE_ADDR_str;
         case EC_NOT_INITIALIZED:
             return EC_NOT_INITIALIZED_str;
+        case EC_NO_RESOURCES:
+            return EC_NO_RESOURCES_str;
+        case EC_BAD_CHECKSUM:
+            return EC_BAD_CHECKSUM_str;
+        case EC_STORAGE:
+            return EC_STORAGE_str;
         default:
             return EC_UNKNOWN_ERR_str;
     }
@@ -17,9 +17,12 @@ Header file for retrieving human-readable strings corresponding to the error cod
 #define EC_BAD_READ_SIZE_str "Invalid number of bytes read from register."
 #define EC_BAD_DEVICE_ADDR_str "Bad device address - device address must be in [0, 3]."
 #define EC_NOT_INITIALIZED_str "Communication has not been initialized."
+#define EC_NO_RESOURCES_str "No free queue or table slot for the request."
+#define EC_BAD_CHECKSUM_str "Data read back failed its checksum."
+#define EC_STORAGE_str "Host file or socket could not be opened, read or written."
 
 #define EC_UNKNOWN_ERR_str "Unknown error."
 
-const char *AD525xErrorStringHandler(uint8_t err_code);
+const char *AD525xGetErrorString(uint8_t err_code);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,134 @@
+/** @file
+Class file for running an AD525xScheduler inside an existing epoll/poll event loop on Linux, via
+a single pollable file descriptor.
+*/
+
+#include <AD525x_EventLoop.h>
+
+#if defined(__linux__)
+
+#include <AD525x_Errors.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+AD525xEventSource::AD525xEventSource(AD525xScheduler &sched) :
+    sched(&sched), epoll_fd(-1), event_fd(-1), timer_fd(-1), dispatches(0) {
+    /** Create an event source for `sched`. Call `open()` before use. */
+}
+
+AD525xEventSource::~AD525xEventSource() {
+    close();
+}
+
+uint8_t AD525xEventSource::open() {
+    /** Create the file descriptors.
+
+    @return Returns 0 on no error, or `EC_STORAGE` if a descriptor could not be created.
+    */
+    close();
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    if (epoll_fd < 0 || event_fd < 0 || timer_fd < 0) {
+        close();
+        return EC_STORAGE;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+
+    ev.data.fd = event_fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, event_fd, &ev) != 0) {
+        close();
+        return EC_STORAGE;
+    }
+
+    ev.data.fd = timer_fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &ev) != 0) {
+        close();
+        return EC_STORAGE;
+    }
+
+    return arm(sched->get_wait_us());
+}
+
+void AD525xEventSource::close() {
+    /** Close the file descriptors. */
+    if (epoll_fd >= 0) { ::close(epoll_fd); }
+    if (event_fd >= 0) { ::close(event_fd); }
+    if (timer_fd >= 0) { ::close(timer_fd); }
+
+    epoll_fd = event_fd = timer_fd = -1;
+}
+
+int AD525xEventSource::get_fd() {
+    /** Retrieve the fd to watch for readability (`EPOLLIN` / `POLLIN`), or -1 if not open. */
+    return epoll_fd;
+}
+
+uint8_t AD525xEventSource::notify() {
+    /** Wake the event loop, e.g. after queueing operations on the scheduler.
+
+    Only the eventfd is touched, so this is safe from other threads and from signal handlers, but
+    the scheduler itself must still only be used from the event loop thread.
+
+    @return Returns 0 on no error, or `EC_STORAGE` if the source is not open.
+    */
+    if (event_fd < 0) { return EC_STORAGE; }
+
+    uint64_t one = 1;
+    if (write(event_fd, &one, sizeof(one)) != sizeof(one)) { return EC_STORAGE; }
+
+    return EC_NO_ERR;
+}
+
+uint8_t AD525xEventSource::dispatch() {
+    /** Handle readiness of `get_fd()`: run every runnable operation, then re-arm the timer for the
+    next EEMEM busy window, if any. Call this when the event loop reports the fd readable.
+
+    @return Returns 0 on no error, the error code of the last failed operation (see
+            `AD525xScheduler::service()`), or `EC_STORAGE` if the source is not open.
+    */
+    if (epoll_fd < 0) { return EC_STORAGE; }
+
+    uint64_t count;
+    while (read(event_fd, &count, sizeof(count)) > 0) {}
+    while (read(timer_fd, &count, sizeof(count)) > 0) {}
+
+    dispatches++;
+
+    uint8_t rv = sched->service();
+    uint8_t e = arm(sched->get_wait_us());
+
+    return rv ? rv : e;
+}
+
+uint32_t AD525xEventSource::get_dispatches() {
+    /** Retrieve the number of `dispatch()` calls, to compare wakeups against useful work. */
+    return dispatches;
+}
+
+//
+// Private functions
+//
+uint8_t AD525xEventSource::arm(uint32_t wait_us) {
+    /** Arm the timer to fire in `wait_us`, or disarm it for `AD525X_SCHED_IDLE`. */
+    struct itimerspec its = {};
+
+    if (wait_us != AD525X_SCHED_IDLE) {
+        if (wait_us == 0) { wait_us = 1; }      // An all-zero value would disarm the timer.
+
+        its.it_value.tv_sec = wait_us / 1000000UL;
+        its.it_value.tv_nsec = (wait_us % 1000000UL) * 1000UL;
+    }
+
+    if (timerfd_settime(timer_fd, 0, &its, NULL) != 0) { return EC_STORAGE; }
+
+    return EC_NO_ERR;
+}
+
+#endif
@@ -0,0 +1,44 @@
+/** @file
+Header file for running an AD525xScheduler inside an existing epoll/poll event loop on Linux, via
+a single pollable file descriptor.
+*/
+#ifndef AD525X_EVENTLOOP_H
+#define AD525X_EVENTLOOP_H
+
+#if defined(__linux__)
+
+#include <AD525x_Scheduler.h>
+#include <cstdint>
+
+class AD525xEventSource {
+// Exposes one fd that is readable when the scheduler has runnable work: after notify(), or when a
+// device it waits on finishes programming EEMEM. Internally an epoll set of an eventfd and a
+// timerfd, so it can be added to the caller's epoll, poll or select loop like any socket.
+public:
+    AD525xEventSource(AD525xScheduler &sched);
+    ~AD525xEventSource();
+
+    uint8_t open(void);
+    void close(void);
+    int get_fd(void);
+
+    uint8_t notify(void);
+    uint8_t dispatch(void);
+
+    uint32_t get_dispatches(void);
+
+private:
+    uint8_t arm(uint32_t wait_us);
+
+    AD525xScheduler *sched;
+
+    int epoll_fd;               /*!< The fd handed to the caller. */
+    int event_fd;               /*!< Signalled by `notify()`. */
+    int timer_fd;               /*!< Armed for the end of the earliest EEMEM busy window. */
+
+    uint32_t dispatches;        /*!< Calls to `dispatch()`, i.e. event loop wakeups. */
+};
+
+#endif
+
+#endif
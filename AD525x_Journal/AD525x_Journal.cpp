@@ -0,0 +1,505 @@
+/** @file
+Class file for an append-only journal of committed AD525x device state, used to rebuild the
+driver caches after a restart without re-reading every register over the bus.
+*/
+
+#include <AD525x_Journal.h>
+#include <AD525x_Errors.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define AD525X_JOURNAL_UNKNOWN 0xFFFFFFFFUL     // Record value meaning "no longer known".
+
+AD525xJournal::AD525xJournal() :
+    base(NULL), size(0), tail(0), seq(0), n_states(0), torn(false), mismatches(0), err_code(0) {
+    /** Create a journal with no storage. Call `attach()` or `open()` before use. */
+#if defined(__linux__)
+    fd = -1;
+    path[0] = '\0';
+#endif
+}
+
+uint8_t AD525xJournal::attach(uint8_t *buffer, uint32_t size) {
+    /** Use `size` bytes at `buffer` as journal storage and replay what is already in it.
+
+    Any memory that survives the restart being recovered from works, e.g. battery-backed RAM or a
+    memory-mapped FRAM. Zero the buffer before first use. Compaction of plain memory is done in
+    place and is not crash-safe; use `open()` where a file system is available.
+
+    @return Returns 0 on no error.
+    */
+    base = buffer;
+    this->size = size;
+
+    replay();
+    return (err_code = EC_NO_ERR);
+}
+
+#if defined(__linux__)
+uint8_t AD525xJournal::open(const char *path, uint32_t size) {
+    /** Open (or create) the journal file at `path`, map it, and replay its contents.
+
+    The file is memory-mapped shared, so committed records survive a crash or restart of the process
+    as soon as they are written, without a system call per record.
+
+    @param[in] path Journal file name. A `.tmp` sibling is used during `compact()`.
+    @param[in] size Capacity in bytes for a new file. An existing larger file keeps its size.
+
+    @return Returns 0 on no error, or `EC_STORAGE` if the file cannot be opened or mapped.
+    */
+    close();
+
+    if (strlen(path) >= sizeof(this->path)) { return (err_code = EC_STORAGE); }
+    strcpy(this->path, path);
+
+    fd = ::open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) { return (err_code = EC_STORAGE); }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close();
+        return (err_code = EC_STORAGE);
+    }
+
+    if ((uint32_t)st.st_size < size) {
+        if (ftruncate(fd, size) != 0) {
+            close();
+            return (err_code = EC_STORAGE);
+        }
+    } else {
+        size = st.st_size;
+    }
+
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close();
+        return (err_code = EC_STORAGE);
+    }
+
+    return attach((uint8_t *)map, size);
+}
+
+void AD525xJournal::close() {
+    /** Unmap and close the journal file. The in-memory state is kept. */
+    if (fd < 0) { return; }
+
+    if (base != NULL) { munmap(base, size); }
+    ::close(fd);
+
+    fd = -1;
+    base = NULL;
+    size = 0;
+}
+#endif
+
+uint8_t AD525xJournal::commit(AD525x &pot, uint8_t bus) {
+    /** Append the cached wiper state of `pot` to the journal, for wipers that changed.
+
+    Call this after a batch of operations has completed. Only wipers whose cached value differs from
+    the journal are appended, and wipers the driver no longer knows (e.g. after a restore from
+    EEMEM) are marked unknown so they are not trusted after a restart.
+
+    @param[in] pot An initialized device.
+    @param[in] bus Identifies the bus of `pot` when several buses share one journal.
+
+    @return Returns 0 on no error, `EC_NOT_INITIALIZED` if `pot` is not initialized, or
+            `EC_NO_RESOURCES` if the journal or the device table is full.
+    */
+    uint8_t addr = pot.get_dev_addr();
+    if (addr == 0) { return (err_code = EC_NOT_INITIALIZED); }
+
+    State *st = find_state(bus, addr, true);
+    if (st == NULL) { return (err_code = EC_NO_RESOURCES); }
+
+    for (uint8_t i = 0; i < 4; i++) {
+        bool known = st->wiper_known & (1 << i);
+
+        if (pot.is_cached(i)) {
+            uint8_t v = pot.read_RDAC_cached(i);
+            if (known && st->wiper[i] == v) { continue; }
+
+            if (append(type_wiper, bus, addr, i, v)) { return err_code; }
+        } else if (known) {
+            if (append(type_wiper, bus, addr, i, AD525X_JOURNAL_UNKNOWN)) { return err_code; }
+        }
+    }
+
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xJournal::record_EEMEM(AD525x &pot, uint8_t reg, uint8_t value, uint8_t bus) {
+    /** Append a successfully written EEMEM value, if it differs from the journal. See `commit()`. */
+    uint8_t addr = pot.get_dev_addr();
+    if (addr == 0) { return (err_code = EC_NOT_INITIALIZED); }
+    if (reg > 15) { return (err_code = EC_BAD_REGISTER); }
+
+    State *st = find_state(bus, addr, true);
+    if (st == NULL) { return (err_code = EC_NO_RESOURCES); }
+
+    if ((st->EEMEM_known & (1 << reg)) && st->EEMEM[reg] == value) {
+        return (err_code = EC_NO_ERR);
+    }
+
+    return append(type_EEMEM, bus, addr, reg, value);
+}
+
+uint8_t AD525xJournal::record_tolerance(AD525x &pot, uint8_t RDAC, float tolerance, uint8_t bus) {
+    /** Append a factory tolerance read with `AD525x::read_tolerance()`. See `commit()`. */
+    uint8_t addr = pot.get_dev_addr();
+    if (addr == 0) { return (err_code = EC_NOT_INITIALIZED); }
+    if (RDAC > 3) { return (err_code = EC_BAD_REGISTER); }
+
+    State *st = find_state(bus, addr, true);
+    if (st == NULL) { return (err_code = EC_NO_RESOURCES); }
+
+    if ((st->tolerance_known & (1 << RDAC)) && st->tolerance[RDAC] == tolerance) {
+        return (err_code = EC_NO_ERR);
+    }
+
+    uint32_t bits;
+    memcpy(&bits, &tolerance, sizeof(bits));
+    return append(type_tolerance, bus, addr, RDAC, bits);
+}
+
+uint8_t AD525xJournal::restore(AD525x &pot, uint8_t bus, uint8_t spot_checks) {
+    /** Seed the wiper cache of `pot` from the journal, then spot-check it against the hardware.
+
+    Up to `spot_checks` of the restored wipers are read back with `AD525x::read_RDAC()`. If any of
+    them disagrees, the whole cache of `pot` is discarded (so every wiper is re-read on demand) and
+    the mismatch is counted in `get_mismatches()`.
+
+    @return Returns 0 on no error (including when the journal knows nothing about `pot`), otherwise
+            the error code of a failed spot-check read.
+    */
+    uint8_t addr = pot.get_dev_addr();
+    if (addr == 0) { return (err_code = EC_NOT_INITIALIZED); }
+
+    State *st = find_state(bus, addr, false);
+    if (st == NULL) { return (err_code = EC_NO_ERR); }
+
+    for (uint8_t i = 0; i < 4; i++) {
+        if (st->wiper_known & (1 << i)) { pot.set_cached_RDAC(i, st->wiper[i]); }
+    }
+
+    for (uint8_t i = 0; i < 4 && spot_checks > 0; i++) {
+        if (!(st->wiper_known & (1 << i))) { continue; }
+        spot_checks--;
+
+        uint8_t v = pot.read_RDAC(i);
+        if ((err_code = pot.get_err_code())) { return err_code; }
+
+        if (v != st->wiper[i]) {
+            mismatches++;
+            pot.invalidate_cache();
+            return (err_code = EC_NO_ERR);
+        }
+    }
+
+    return (err_code = EC_NO_ERR);
+}
+
+bool AD525xJournal::get_EEMEM(AD525x &pot, uint8_t reg, uint8_t *value, uint8_t bus) {
+    /** Look up a journaled EEMEM value. Returns false if it is not known. */
+    State *st = find_state(bus, pot.get_dev_addr(), false);
+    if (st == NULL || reg > 15 || !(st->EEMEM_known & (1 << reg))) { return false; }
+
+    *value = st->EEMEM[reg];
+    return true;
+}
+
+bool AD525xJournal::get_tolerance(AD525x &pot, uint8_t RDAC, float *tolerance, uint8_t bus) {
+    /** Look up a journaled factory tolerance. Returns false if it is not known. */
+    State *st = find_state(bus, pot.get_dev_addr(), false);
+    if (st == NULL || RDAC > 3 || !(st->tolerance_known & (1 << RDAC))) { return false; }
+
+    *tolerance = st->tolerance[RDAC];
+    return true;
+}
+
+uint8_t AD525xJournal::compact() {
+    /** Rewrite the journal as a snapshot of the current state. Called automatically when the
+    journal fills up.
+
+    With a file (`open()`), the snapshot is written to a temporary file which then atomically
+    replaces the journal, so a crash during compaction loses nothing.
+
+    @return Returns 0 on no error, `EC_NO_RESOURCES` if the snapshot alone does not fit, or
+            `EC_STORAGE` on a file error.
+    */
+    if (base == NULL) { return (err_code = EC_STORAGE); }
+
+    uint32_t used = 0;
+
+#if defined(__linux__)
+    if (fd >= 0) {
+        char tmp_path[sizeof(path) + 4];
+        snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+        int tmp_fd = ::open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (tmp_fd < 0) { return (err_code = EC_STORAGE); }
+
+        void *map = MAP_FAILED;
+        if (ftruncate(tmp_fd, size) == 0) {
+            map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, tmp_fd, 0);
+        }
+
+        if (map == MAP_FAILED) {
+            ::close(tmp_fd);
+            unlink(tmp_path);
+            return (err_code = EC_STORAGE);
+        }
+
+        if (write_snapshot((uint8_t *)map, &used) || msync(map, size, MS_SYNC) != 0 ||
+            rename(tmp_path, path) != 0) {
+            uint8_t rv = err_code ? err_code : EC_STORAGE;
+            munmap(map, size);
+            ::close(tmp_fd);
+            unlink(tmp_path);
+            return (err_code = rv);
+        }
+
+        munmap(base, size);
+        ::close(fd);
+
+        fd = tmp_fd;
+        base = (uint8_t *)map;
+        tail = used;
+        seq = used / sizeof(Record);
+
+        // The rename itself is only durable once the directory is on disk.
+        return (err_code = sync_directory());
+    }
+#endif
+
+    if (write_snapshot(base, &used)) { return err_code; }
+
+    memset(base + used, 0, size - used);
+    tail = used;
+    seq = used / sizeof(Record);
+
+    return (err_code = EC_NO_ERR);
+}
+
+uint32_t AD525xJournal::get_records() {
+    /** Retrieve the number of valid records currently in the journal. */
+    return tail / sizeof(Record);
+}
+
+bool AD525xJournal::was_torn() {
+    /** True if replay stopped at a damaged record, e.g. one half-written during a crash, or found
+    records past the end of the log. Everything before it was recovered; the rest was erased. */
+    return torn;
+}
+
+uint32_t AD525xJournal::get_mismatches() {
+    /** Retrieve the number of `restore()` spot checks that disagreed with the hardware. */
+    return mismatches;
+}
+
+uint8_t AD525xJournal::get_err_code() {
+    /** Retrieve the error code of the last operation. See `AD525x_Errors.h`. */
+    return err_code;
+}
+
+//
+// Private functions
+//
+AD525xJournal::State *AD525xJournal::find_state(uint8_t bus, uint8_t addr, bool create) {
+    /** Look up the state of device `addr` on `bus`, optionally adding it. Returns NULL if absent
+    or the table is full. */
+    for (uint8_t k = 0; k < n_states; k++) {
+        if (state[k].bus == bus && state[k].addr == addr) { return &state[k]; }
+    }
+
+    if (!create || n_states >= AD525X_JOURNAL_MAX_DEVICES) { return NULL; }
+
+    State &st = state[n_states++];
+    memset(&st, 0, sizeof(st));
+    st.bus = bus;
+    st.addr = addr;
+
+    return &st;
+}
+
+uint8_t AD525xJournal::append(uint8_t type, uint8_t bus, uint8_t addr, uint8_t reg,
+                              uint32_t value) {
+    /** Append one record, compacting first if the journal is full. */
+    if (base == NULL) { return (err_code = EC_STORAGE); }
+
+    if (tail + sizeof(Record) > size) {
+        if (compact()) { return err_code; }
+        if (tail + sizeof(Record) > size) { return (err_code = EC_NO_RESOURCES); }
+    }
+
+    Record rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.magic = AD525xJournal::magic;
+    rec.type = type;
+    rec.bus = bus;
+    rec.addr = addr;
+    rec.reg = reg;
+    rec.value = value;
+    rec.seq = seq;
+    rec.crc = crc32((const uint8_t *)&rec, sizeof(rec) - sizeof(rec.crc));
+
+    memcpy(base + tail, &rec, sizeof(rec));
+    tail += sizeof(rec);
+    seq++;
+
+    apply(rec);
+    return (err_code = EC_NO_ERR);
+}
+
+void AD525xJournal::apply(const Record &rec) {
+    /** Fold one record into the in-memory state. */
+    State *st = find_state(rec.bus, rec.addr, true);
+    if (st == NULL || rec.reg > 15) { return; }
+
+    uint8_t bit = 1 << (rec.reg & 3);
+
+    switch (rec.type) {
+        case type_wiper:
+            if (rec.value == AD525X_JOURNAL_UNKNOWN) {
+                st->wiper_known &= ~bit;
+            } else {
+                st->wiper[rec.reg & 3] = rec.value;
+                st->wiper_known |= bit;
+            }
+            break;
+        case type_EEMEM:
+            st->EEMEM[rec.reg] = rec.value;
+            st->EEMEM_known |= (1 << rec.reg);
+            break;
+        case type_tolerance:
+            memcpy(&st->tolerance[rec.reg & 3], &rec.value, sizeof(float));
+            st->tolerance_known |= bit;
+            break;
+    }
+}
+
+void AD525xJournal::replay() {
+    /** Rebuild the in-memory state from the journal storage, stopping at the first record that is
+    empty, out of sequence, or fails its CRC.
+
+    Sequence numbers are positional, so anything left past that point would be replayed as current
+    once the next append fills the gap. Write-back after a crash is in no particular order: a later
+    record may have reached storage while the one before it did not. The rest of the storage must
+    therefore be blank; if it is not, the log was torn, and the remainder is zeroed (and, for a
+    file, synced) before anything new is appended.
+    */
+    n_states = 0;
+    tail = 0;
+    seq = 0;
+    torn = false;
+
+    while (tail + sizeof(Record) <= size) {
+        Record rec;
+        memcpy(&rec, base + tail, sizeof(rec));
+
+        bool valid = rec.magic == AD525xJournal::magic && rec.seq == seq &&
+                     rec.crc == crc32((const uint8_t *)&rec, sizeof(rec) - sizeof(rec.crc));
+        if (!valid) { break; }
+
+        apply(rec);
+        tail += sizeof(rec);
+        seq++;
+    }
+
+    for (uint32_t i = tail; i < size && !torn; i++) {
+        torn = base[i] != 0;
+    }
+
+    if (!torn) { return; }
+
+    memset(base + tail, 0, size - tail);
+#if defined(__linux__)
+    if (fd >= 0) { msync(base, size, MS_SYNC); }
+#endif
+}
+
+uint8_t AD525xJournal::write_snapshot(uint8_t *dest, uint32_t *used) {
+    /** Write the current state to `dest` as a fresh sequence of records. */
+    uint32_t off = 0;
+    uint32_t n = 0;
+
+    for (uint8_t k = 0; k < n_states; k++) {
+        State &st = state[k];
+
+        for (uint8_t reg = 0; reg < 16; reg++) {
+            for (uint8_t type = type_wiper; type <= type_tolerance; type++) {
+                Record rec;
+                memset(&rec, 0, sizeof(rec));
+
+                if (type == type_EEMEM && (st.EEMEM_known & (1 << reg))) {
+                    rec.value = st.EEMEM[reg];
+                } else if (reg < 4 && type == type_wiper && (st.wiper_known & (1 << reg))) {
+                    rec.value = st.wiper[reg];
+                } else if (reg < 4 && type == type_tolerance && (st.tolerance_known & (1 << reg))) {
+                    memcpy(&rec.value, &st.tolerance[reg], sizeof(float));
+                } else {
+                    continue;
+                }
+
+                if (off + sizeof(rec) > size) { return (err_code = EC_NO_RESOURCES); }
+
+                rec.magic = AD525xJournal::magic;
+                rec.type = type;
+                rec.bus = st.bus;
+                rec.addr = st.addr;
+                rec.reg = reg;
+                rec.seq = n++;
+                rec.crc = crc32((const uint8_t *)&rec, sizeof(rec) - sizeof(rec.crc));
+
+                memcpy(dest + off, &rec, sizeof(rec));
+                off += sizeof(rec);
+            }
+        }
+    }
+
+    *used = off;
+    return (err_code = EC_NO_ERR);
+}
+
+#if defined(__linux__)
+uint8_t AD525xJournal::sync_directory() {
+    /** fsync() the directory holding the journal file. Returns 0, or `EC_STORAGE`. */
+    char dir[sizeof(path)];
+    strcpy(dir, path);
+
+    char *slash = strrchr(dir, '/');
+    if (slash == NULL) {
+        strcpy(dir, ".");
+    } else {
+        slash[slash == dir ? 1 : 0] = '\0';     // Keep "/" for a file in the root.
+    }
+
+    int dir_fd = ::open(dir, O_RDONLY | O_DIRECTORY);
+    if (dir_fd < 0) { return EC_STORAGE; }
+
+    int rv = fsync(dir_fd);
+    ::close(dir_fd);
+
+    return (rv == 0) ? EC_NO_ERR : EC_STORAGE;
+}
+#endif
+
+uint32_t AD525xJournal::crc32(const uint8_t *data, uint32_t n) {
+    /** Bitwise CRC-32 (IEEE 802.3). Records are short, so no table is needed. */
+    uint32_t crc = 0xFFFFFFFFUL;
+
+    for (uint32_t i = 0; i < n; i++) {
+        crc ^= data[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+        }
+    }
+
+    return ~crc;
+}
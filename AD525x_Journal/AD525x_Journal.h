@@ -0,0 +1,101 @@
+/** @file
+Header file for an append-only journal of committed AD525x device state, used to rebuild the
+driver caches after a restart without re-reading every register over the bus.
+*/
+#ifndef AD525X_JOURNAL_H
+#define AD525X_JOURNAL_H
+
+#include <AD525x.h>
+#include <cstdint>
+
+#ifndef AD525X_JOURNAL_MAX_DEVICES
+#define AD525X_JOURNAL_MAX_DEVICES 16   /*!< Devices whose state one journal can hold. */
+#endif
+
+class AD525xJournal {
+// Each record is 20 bytes and carries a sequence number and a CRC-32, so a record torn by a crash
+// (or stale data past the end of the log) stops replay instead of corrupting the state.
+public:
+    AD525xJournal();
+
+    uint8_t attach(uint8_t *buffer, uint32_t size);
+#if defined(__linux__)
+    uint8_t open(const char *path, uint32_t size);
+    void close(void);
+#endif
+
+    uint8_t commit(AD525x &pot, uint8_t bus = 0);
+    uint8_t record_EEMEM(AD525x &pot, uint8_t reg, uint8_t value, uint8_t bus = 0);
+    uint8_t record_tolerance(AD525x &pot, uint8_t RDAC, float tolerance, uint8_t bus = 0);
+
+    uint8_t restore(AD525x &pot, uint8_t bus = 0, uint8_t spot_checks = 1);
+    bool get_EEMEM(AD525x &pot, uint8_t reg, uint8_t *value, uint8_t bus = 0);
+    bool get_tolerance(AD525x &pot, uint8_t RDAC, float *tolerance, uint8_t bus = 0);
+
+    uint8_t compact(void);
+
+    uint32_t get_records(void);
+    bool was_torn(void);
+    uint32_t get_mismatches(void);
+
+    uint8_t get_err_code(void);
+
+private:
+    struct Record {
+        uint8_t magic;
+        uint8_t type;
+        uint8_t bus;
+        uint8_t addr;
+        uint8_t reg;
+        uint8_t pad[3];
+        uint32_t value;
+        uint32_t seq;
+        uint32_t crc;               /*!< CRC-32 of all preceding fields. */
+    };
+
+    struct State {
+        uint8_t bus;
+        uint8_t addr;
+        uint8_t wiper[4];
+        uint8_t wiper_known;
+        uint8_t tolerance_known;
+        uint16_t EEMEM_known;
+        uint8_t EEMEM[16];
+        float tolerance[4];
+    };
+
+    State *find_state(uint8_t bus, uint8_t addr, bool create);
+    uint8_t append(uint8_t type, uint8_t bus, uint8_t addr, uint8_t reg, uint32_t value);
+    void apply(const Record &rec);
+    void replay(void);
+    uint8_t write_snapshot(uint8_t *dest, uint32_t *used);
+    static uint32_t crc32(const uint8_t *data, uint32_t n);
+#if defined(__linux__)
+    uint8_t sync_directory(void);
+#endif
+
+    static const uint8_t magic = 0xA5;
+    static const uint8_t type_wiper = 1;
+    static const uint8_t type_EEMEM = 2;
+    static const uint8_t type_tolerance = 3;
+
+    uint8_t *base;                  /*!< Start of the journal storage. */
+    uint32_t size;                  /*!< Capacity in bytes. */
+    uint32_t tail;                  /*!< Offset of the next record. */
+    uint32_t seq;                   /*!< Sequence number of the next record. */
+
+#if defined(__linux__)
+    int fd;                         /*!< Backing file, or -1 when attached to plain memory. */
+    char path[128];
+#endif
+
+    State state[AD525X_JOURNAL_MAX_DEVICES];
+    uint8_t n_states;
+
+    bool torn;                      /*!< Replay stopped on a damaged record. */
+    uint32_t mismatches;            /*!< Spot checks that disagreed with the journal. */
+
+    uint8_t err_code;
+};
+
+#endif
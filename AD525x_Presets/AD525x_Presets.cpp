@@ -0,0 +1,194 @@
+/** @file
+Class file for storing wiper presets in the user EEMEM registers (4-15) of an AD5253/AD5254.
+*/
+
+#include <AD525x_Presets.h>
+#include <AD525x_Errors.h>
+#include <Arduino.h>
+
+AD525xPresets::AD525xPresets(AD525x &pot) : pot(&pot), cached(0), err_code(0) {
+    /** Create a preset manager for `pot`. Presets are read lazily and cached on first use. */
+}
+
+uint8_t AD525xPresets::get_num_presets() {
+    /** Retrieve the number of presets that fit in the user EEMEM of this device (2 for AD5254, 3
+    for AD5253). */
+    return (16 - AD525xPresets::first_register) / slot_size();
+}
+
+uint8_t AD525xPresets::save(uint8_t preset, const uint8_t *wipers) {
+    /** Store four wiper values as preset number `preset`.
+
+    Only bytes that differ from the stored preset (when it is cached) are programmed, and the
+    function waits out the EEMEM programming time after each one, so the device is ready when it
+    returns.
+
+    @param[in] preset The preset slot [0, `get_num_presets()`).
+    @param[in] wipers Four wiper values, one per RDAC.
+
+    @return Returns 0 on no error, `EC_BAD_REGISTER` for an invalid slot, `EC_BAD_WIPER_SETTING`
+            for an out of range value, or the error raised by `AD525x::write_EEMEM()`.
+    */
+    if (preset >= get_num_presets()) { return (err_code = EC_BAD_REGISTER); }
+
+    for (uint8_t i = 0; i < 4; i++) {
+        if (wipers[i] > pot->get_max_val()) { return (err_code = EC_BAD_WIPER_SETTING); }
+    }
+
+    uint8_t n = slot_size();
+    uint8_t bytes[5], old[5];
+    bool have_old = cached & (1 << preset);
+
+    encode(wipers, preset, bytes);
+    if (have_old) { encode(cache[preset], preset, old); }
+
+    cached &= ~(1 << preset);       // Stored bytes are indeterminate until all writes succeed.
+
+    uint8_t reg = AD525xPresets::first_register + preset * n;
+    for (uint8_t i = 0; i < n; i++) {
+        if (have_old && old[i] == bytes[i]) { continue; }
+
+        if ((err_code = pot->write_EEMEM(reg + i, bytes[i]))) { return err_code; }
+        delay(AD525X_EEMEM_WRITE_MS);
+    }
+
+    for (uint8_t i = 0; i < 4; i++) {
+        cache[preset][i] = wipers[i];
+    }
+    cached |= (1 << preset);
+
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xPresets::save_current(uint8_t preset) {
+    /** Store the current wiper values as preset number `preset`. See `save()`. */
+    uint8_t wipers[4];
+
+    for (uint8_t i = 0; i < 4; i++) {
+        wipers[i] = pot->read_RDAC_cached(i);
+        if ((err_code = pot->get_err_code())) { return err_code; }
+    }
+
+    return save(preset, wipers);
+}
+
+uint8_t AD525xPresets::load(uint8_t preset, uint8_t *wipers) {
+    /** Retrieve the wiper values of preset `preset`, from the cache if possible.
+
+    @param[in]  preset The preset slot [0, `get_num_presets()`).
+    @param[out] wipers Receives four wiper values.
+
+    @return Returns 0 on no error, `EC_BAD_REGISTER` for an invalid slot, `EC_BAD_CHECKSUM` if the
+            slot is empty or corrupt, or the error raised by `AD525x::read_EEMEM()`.
+    */
+    if (preset >= get_num_presets()) { return (err_code = EC_BAD_REGISTER); }
+
+    if (!(cached & (1 << preset))) {
+        uint8_t n = slot_size();
+        uint8_t bytes[5];
+        uint8_t reg = AD525xPresets::first_register + preset * n;
+
+        for (uint8_t i = 0; i < n; i++) {
+            bytes[i] = pot->read_EEMEM(reg + i);
+            if ((err_code = pot->get_err_code())) { return err_code; }
+        }
+
+        if (!decode(bytes, preset, cache[preset])) { return (err_code = EC_BAD_CHECKSUM); }
+        cached |= (1 << preset);
+    }
+
+    for (uint8_t i = 0; i < 4; i++) {
+        wipers[i] = cache[preset][i];
+    }
+
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xPresets::recall(uint8_t preset) {
+    /** Move all four wipers to preset `preset`.
+
+    Once the preset is cached, this costs only the wiper moves that actually change something (see
+    `AD525x::move_RDAC()`), and no EEMEM reads.
+
+    @return Returns 0 on no error, otherwise the error raised by `load()` or
+            `AD525x::move_RDAC()`.
+    */
+    uint8_t wipers[4];
+    if (load(preset, wipers)) { return err_code; }
+
+    for (uint8_t i = 0; i < 4; i++) {
+        if ((err_code = pot->move_RDAC(i, wipers[i]))) { return err_code; }
+    }
+
+    return (err_code = EC_NO_ERR);
+}
+
+void AD525xPresets::invalidate() {
+    /** Drop the cached presets, e.g. after EEMEM has been written by something else. */
+    cached = 0;
+}
+
+uint8_t AD525xPresets::get_err_code() {
+    /** Retrieve the error code of the last operation. See `AD525x_Errors.h`. */
+    return err_code;
+}
+
+//
+// Private functions
+//
+uint8_t AD525xPresets::slot_size() {
+    /** Bytes per preset: packed wipers plus one checksum byte. */
+    return (pot->get_max_val() < 64) ? 4 : 5;
+}
+
+void AD525xPresets::encode(const uint8_t *wipers, uint8_t preset, uint8_t *bytes) {
+    /** Pack four wipers into the on-chip layout, followed by the checksum. */
+    uint8_t n = slot_size();
+
+    if (n == 4) {
+        bytes[0] = wipers[0] | (wipers[1] << 6);
+        bytes[1] = (wipers[1] >> 2) | (wipers[2] << 4);
+        bytes[2] = (wipers[2] >> 4) | (wipers[3] << 2);
+    } else {
+        for (uint8_t i = 0; i < 4; i++) {
+            bytes[i] = wipers[i];
+        }
+    }
+
+    bytes[n - 1] = crc8(bytes, n - 1, preset);
+}
+
+bool AD525xPresets::decode(const uint8_t *bytes, uint8_t preset, uint8_t *wipers) {
+    /** Unpack a preset from its on-chip layout. Returns false if the checksum does not match. */
+    uint8_t n = slot_size();
+
+    if (crc8(bytes, n - 1, preset) != bytes[n - 1]) { return false; }
+
+    if (n == 4) {
+        wipers[0] = bytes[0] & 0x3F;
+        wipers[1] = ((bytes[0] >> 6) | (bytes[1] << 2)) & 0x3F;
+        wipers[2] = ((bytes[1] >> 4) | (bytes[2] << 4)) & 0x3F;
+        wipers[3] = (bytes[2] >> 2) & 0x3F;
+    } else {
+        for (uint8_t i = 0; i < 4; i++) {
+            wipers[i] = bytes[i];
+        }
+    }
+
+    return true;
+}
+
+uint8_t AD525xPresets::crc8(const uint8_t *bytes, uint8_t n, uint8_t seed) {
+    /** CRC-8 (polynomial 0x07). The preset number is mixed into the seed so that a preset copied
+    into the wrong slot does not validate. */
+    uint8_t crc = 0xA5 ^ seed;
+
+    for (uint8_t i = 0; i < n; i++) {
+        crc ^= bytes[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+        }
+    }
+
+    return crc;
+}
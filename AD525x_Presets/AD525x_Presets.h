@@ -0,0 +1,42 @@
+/** @file
+Header file for storing wiper presets in the user EEMEM registers (4-15) of an AD5253/AD5254.
+*/
+#ifndef AD525X_PRESETS_H
+#define AD525X_PRESETS_H
+
+#include <AD525x.h>
+#include <cstdint>
+
+class AD525xPresets {
+// Each preset holds all four wipers plus a CRC-8. AD5254 presets take 5 bytes (2 fit), AD5253
+// presets pack four 6-bit wipers into 3 bytes and take 4 bytes (3 fit).
+public:
+    AD525xPresets(AD525x &pot);
+
+    uint8_t get_num_presets(void);
+
+    uint8_t save(uint8_t preset, const uint8_t *wipers);
+    uint8_t save_current(uint8_t preset);
+
+    uint8_t load(uint8_t preset, uint8_t *wipers);
+    uint8_t recall(uint8_t preset);
+
+    void invalidate(void);
+    uint8_t get_err_code(void);
+
+    static const uint8_t max_presets = 3;       /*!< Most presets any device can hold. */
+    static const uint8_t first_register = 4;    /*!< First EEMEM register not tied to an RDAC. */
+
+private:
+    uint8_t slot_size(void);
+    void encode(const uint8_t *wipers, uint8_t preset, uint8_t *bytes);
+    bool decode(const uint8_t *bytes, uint8_t preset, uint8_t *wipers);
+    uint8_t crc8(const uint8_t *bytes, uint8_t n, uint8_t seed);
+
+    AD525x *pot;
+    uint8_t cache[max_presets][4];  /*!< Presets already read from or written to EEMEM. */
+    uint8_t cached;                 /*!< Bit mask of valid entries in `cache`. */
+    uint8_t err_code;
+};
+
+#endif
@@ -0,0 +1,447 @@
+/** @file
+Class file for a compact binary request protocol that lets one process own a set of AD525x
+devices and serve batched wiper operations to others.
+*/
+
+#include <AD525x_Protocol.h>
+#include <AD525x_Errors.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+//
+// AD525xBatch
+//
+uint8_t AD525xBatch::add(uint8_t opcode, uint8_t device, uint8_t reg, uint8_t value) {
+    /** Append an operation to the batch.
+
+    @param[in] opcode One of the `AD525X_OP_*` opcodes.
+    @param[in] device Index of the device on the server (see `AD525xProtocolServer::add_device()`).
+    @param[in] reg    RDAC or EEMEM register.
+    @param[in] value  Data for writes; ignored otherwise.
+
+    @return Returns 0 on no error, or `EC_NO_RESOURCES` if the batch holds `AD525X_PROTO_MAX_OPS`.
+    */
+    if (n_ops >= AD525X_PROTO_MAX_OPS) { return EC_NO_RESOURCES; }
+
+    uint8_t *op = buffer + AD525X_PROTO_HEADER_LEN + n_ops * AD525X_PROTO_OP_LEN;
+    op[0] = opcode;
+    op[1] = device;
+    op[2] = reg;
+    op[3] = value;
+    n_ops++;
+
+    return EC_NO_ERR;
+}
+
+void AD525xBatch::clear() {
+    /** Remove all operations. */
+    n_ops = 0;
+}
+
+const uint8_t *AD525xBatch::data() {
+    /** Retrieve the encoded request, ready to send. */
+    buffer[0] = AD525X_PROTO_MAGIC;
+    buffer[1] = n_ops;
+    return buffer;
+}
+
+uint16_t AD525xBatch::size() {
+    /** Retrieve the length of the encoded request in bytes. */
+    return AD525X_PROTO_HEADER_LEN + n_ops * AD525X_PROTO_OP_LEN;
+}
+
+//
+// AD525xProtocolServer
+//
+AD525xProtocolServer::AD525xProtocolServer() :
+    n_devices(0), n_round(0), requests(0), rounds(0), ops(0), coalesced(0) {
+    /** Create a server with no devices. */
+}
+
+uint8_t AD525xProtocolServer::add_device(AD525x &pot, uint8_t *index) {
+    /** Make `pot` available to clients. Devices are addressed by the order they were added.
+
+    @param[in]  pot   An initialized device.
+    @param[out] index If not NULL, receives the device index used in requests.
+
+    @return Returns 0 on no error, or `EC_NO_RESOURCES` if the device table is full.
+    */
+    if (n_devices >= AD525X_PROTO_MAX_DEVICES) { return EC_NO_RESOURCES; }
+
+    if (index != NULL) { *index = n_devices; }
+    busy[n_devices] = false;
+    device[n_devices++] = &pot;
+
+    return EC_NO_ERR;
+}
+
+uint16_t AD525xProtocolServer::handle(const uint8_t *request, uint16_t length, uint8_t *response) {
+    /** Execute one request message and build the response. This is a round of one request; see
+    `run_round()` for the order of execution and which wiper writes are skipped.
+
+    @param[in]  request  The request message.
+    @param[in]  length   Length of `request` in bytes.
+    @param[out] response Buffer of at least `AD525X_PROTO_MAX_RESPONSE` bytes.
+
+    @return Returns the length of the response, or 0 if the request is malformed.
+    */
+    uint16_t response_length = 0;
+
+    begin_round();
+    if (add_request(request, length, response, &response_length)) { return 0; }
+    run_round();
+
+    return response_length;
+}
+
+void AD525xProtocolServer::begin_round() {
+    /** Start collecting requests for `run_round()`. */
+    n_round = 0;
+}
+
+uint8_t AD525xProtocolServer::add_request(const uint8_t *request, uint16_t length,
+                                          uint8_t *response, uint16_t *response_length) {
+    /** Add a request message to the current round. Nothing runs until `run_round()`, which fills
+    in `response`; both buffers must stay valid until then.
+
+    @param[in]  request         The request message.
+    @param[in]  length          Length of `request` in bytes.
+    @param[out] response        Buffer of at least `AD525X_PROTO_MAX_RESPONSE` bytes.
+    @param[out] response_length Receives the length the response will have.
+
+    @return Returns 0 on no error, `EC_BAD_READ_SIZE` if the request is malformed, or
+            `EC_NO_RESOURCES` if the round already holds `AD525X_PROTO_MAX_ROUND` requests.
+    */
+    if (length < AD525X_PROTO_HEADER_LEN || request[0] != AD525X_PROTO_MAGIC) { return EC_BAD_READ_SIZE; }
+
+    uint8_t n = request[1];
+    if (n > AD525X_PROTO_MAX_OPS ||
+        length != AD525X_PROTO_HEADER_LEN + n * AD525X_PROTO_OP_LEN) { return EC_BAD_READ_SIZE; }
+
+    if (n_round >= AD525X_PROTO_MAX_ROUND) { return EC_NO_RESOURCES; }
+
+    Request &req = round[n_round++];
+    req.op = request + AD525X_PROTO_HEADER_LEN;
+    req.result = response + AD525X_PROTO_HEADER_LEN;
+    req.n_ops = n;
+
+    response[0] = AD525X_PROTO_MAGIC;
+    response[1] = n;
+    *response_length = AD525X_PROTO_HEADER_LEN + n * AD525X_PROTO_RESULT_LEN;
+
+    return EC_NO_ERR;
+}
+
+void AD525xProtocolServer::run_round() {
+    /** Execute every request added since `begin_round()` and fill in their responses.
+
+    Requests run in the order they were added, and the operations of each in order, as if each had
+    been handled alone. After an EEMEM write or a store, the next operation on that device, in this
+    round or a later one, first waits out `AD525X_EEMEM_WRITE_MS`; other devices go on meanwhile. A wiper write is skipped when a later write in the round, from the same or
+    another request, replaces it with nothing reading that wiper in between: only the last value
+    would be visible. The later write must be valid for this, and the skipped write reports its
+    outcome, so it fails if the write that replaced it failed on the bus.
+    */
+    if (n_round == 0) { return; }
+
+    for (uint8_t k = 0; k < n_round; k++) {
+        for (uint8_t i = 0; i < round[k].n_ops; i++) {
+            round[k].result[i * AD525X_PROTO_RESULT_LEN] = EC_NO_ERR;
+        }
+    }
+
+    link(false);
+
+    for (uint8_t k = 0; k < n_round; k++) {
+        for (uint8_t i = 0; i < round[k].n_ops; i++) {
+            const uint8_t *o = round[k].op + i * AD525X_PROTO_OP_LEN;
+            uint8_t *r = round[k].result + i * AD525X_PROTO_RESULT_LEN;
+
+            if (r[0] == skipped) { continue; }
+
+            r[1] = 0;
+            r[0] = execute(o, &r[1]);
+            ops++;
+        }
+    }
+
+    link(true);
+
+    requests += n_round;
+    rounds++;
+    n_round = 0;
+}
+
+uint32_t AD525xProtocolServer::get_requests() {
+    /** Retrieve the number of well-formed requests handled. */
+    return requests;
+}
+
+uint32_t AD525xProtocolServer::get_rounds() {
+    /** Retrieve the number of rounds run. Requests per round shows how much batching the clients'
+    timing allows. */
+    return rounds;
+}
+
+uint32_t AD525xProtocolServer::get_ops() {
+    /** Retrieve the number of operations executed. */
+    return ops;
+}
+
+uint32_t AD525xProtocolServer::get_coalesced() {
+    /** Retrieve the number of wiper writes skipped because a later write in the round replaced
+    them. */
+    return coalesced;
+}
+
+//
+// Private functions
+//
+uint8_t AD525xProtocolServer::execute(const uint8_t *op, uint8_t *value) {
+    /** Run a single encoded operation. Returns its error code and stores read data in `value`. */
+    if (op[1] >= n_devices) { return EC_BAD_DEVICE_ADDR; }
+
+    AD525x *pot = device[op[1]];
+    AD525xResult r;
+    uint8_t err;
+
+    wait_ready(op[1]);
+
+    switch (op[0]) {
+        case AD525X_OP_WRITE_RDAC:
+            *value = op[3];
+            return pot->move_RDAC(op[2], op[3]);
+        case AD525X_OP_READ_RDAC:
+            r = pot->read_RDAC_cached_result(op[2]);
+            *value = r.value;
+            return r.err;
+        case AD525X_OP_WRITE_EEMEM:
+            *value = op[3];
+            err = pot->write_EEMEM(op[2], op[3]);
+            break;
+        case AD525X_OP_READ_EEMEM:
+            r = pot->read_EEMEM_result(op[2]);
+            *value = r.value;
+            return r.err;
+        case AD525X_OP_STORE_RDAC:
+            err = pot->store_RDAC(op[2]);
+            break;
+        case AD525X_OP_SYNC_RDAC:
+            r = pot->read_RDAC_result(op[2]);
+            *value = r.value;
+            return r.err;
+        default:
+            return EC_BAD_REGISTER;
+    }
+
+    // The device ignores its address while it programs EEMEM.
+    if (err == EC_NO_ERR) {
+        busy[op[1]] = true;
+        busy_until[op[1]] = micros() + AD525X_EEMEM_WRITE_MS * 1000UL;
+    }
+    return err;
+}
+
+void AD525xProtocolServer::wait_ready(uint8_t dev) {
+    /** Wait until device `dev` has finished programming EEMEM, if it is. */
+    if (!busy[dev]) { return; }
+
+    int32_t left = (int32_t)(busy_until[dev] - micros());
+    if (left > 0) {
+        delay(left / 1000);
+        delayMicroseconds(left % 1000);
+    }
+    busy[dev] = false;
+}
+
+void AD525xProtocolServer::link(bool resolve) {
+    /** Walk the round backwards, tracking the next valid write to each wiper that nothing reads
+    before. Before execution (`resolve` false), mark every write it replaces as `skipped`. After,
+    give each skipped write the error code of its replacement. */
+    uint8_t *next[AD525X_PROTO_MAX_DEVICES][4];
+    memset(next, 0, sizeof(next));
+
+    for (uint8_t k = n_round; k > 0; k--) {
+        for (uint8_t i = round[k - 1].n_ops; i > 0; i--) {
+            const uint8_t *o = round[k - 1].op + (i - 1) * AD525X_PROTO_OP_LEN;
+            uint8_t *r = round[k - 1].result + (i - 1) * AD525X_PROTO_RESULT_LEN;
+            uint8_t dev = o[1];
+
+            if (dev >= n_devices) { continue; }     // Fails without touching the bus.
+
+            if (o[0] == AD525X_OP_WRITE_RDAC) {
+                // An invalid write fails without touching the wiper, so it replaces nothing.
+                if (o[2] > 3 || o[3] > device[dev]->get_max_val()) { continue; }
+
+                if (!resolve && next[dev][o[2]] != NULL) {
+                    r[0] = skipped;
+                    coalesced++;
+                } else if (resolve && r[0] == skipped) {
+                    r[0] = next[dev][o[2]][0];
+                    r[1] = o[3];
+                }
+
+                next[dev][o[2]] = r;
+            } else if (o[0] != AD525X_OP_WRITE_EEMEM && o[0] != AD525X_OP_READ_EEMEM) {
+                // Any other access to the device (read, store, sync) must see the earlier writes.
+                memset(next[dev], 0, sizeof(next[dev]));
+            }
+        }
+    }
+}
+
+#if defined(__linux__)
+//
+// AD525xSocketServer
+//
+AD525xSocketServer::AD525xSocketServer(AD525xProtocolServer &server) :
+    server(&server), listen_fd(-1), n_clients(0) {
+    /** Create a socket front end for `server`. Call `listen()` to start accepting clients. */
+    path[0] = '\0';
+}
+
+AD525xSocketServer::~AD525xSocketServer() {
+    close();
+}
+
+uint8_t AD525xSocketServer::listen(const char *path) {
+    /** Bind a Unix SOCK_SEQPACKET socket at `path` (replacing a stale one) and start listening.
+
+    Sequenced packets keep message boundaries, so every `send()` by a client is exactly one batch
+    and needs no extra framing.
+
+    @return Returns 0 on no error, or `EC_STORAGE` if the socket cannot be created or bound.
+    */
+    close();
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (strlen(path) >= sizeof(addr.sun_path) || strlen(path) >= sizeof(this->path)) {
+        return EC_STORAGE;
+    }
+    strcpy(addr.sun_path, path);
+
+    listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) { return EC_STORAGE; }
+
+    unlink(path);
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        ::listen(listen_fd, AD525X_SOCKET_MAX_CLIENTS) != 0) {
+        ::close(listen_fd);
+        listen_fd = -1;
+        return EC_STORAGE;
+    }
+
+    strcpy(this->path, path);
+    return EC_NO_ERR;
+}
+
+uint8_t AD525xSocketServer::poll_once(int timeout_ms) {
+    /** Wait up to `timeout_ms` (-1 for ever) for activity, then accept new clients and serve every
+    pending request. Call this in the daemon's main loop.
+
+    The batches waiting from all clients, at most one per client, run together as one round of
+    `AD525xProtocolServer::run_round()`. Wiper writes are so coalesced across clients, and every
+    client gets a turn in each round. Everything runs on this thread, serialized on the bus without
+    any locking. Responses are sent without blocking: a client that does not read them is dropped
+    once its socket buffer is full, rather than stalling every other client.
+
+    @return Returns 0 on no error, or `EC_STORAGE` if the listening socket is not open or `poll()`
+            fails.
+    */
+    if (listen_fd < 0) { return EC_STORAGE; }
+
+    struct pollfd fds[AD525X_SOCKET_MAX_CLIENTS + 1];
+    fds[0].fd = listen_fd;
+    fds[0].events = POLLIN;
+
+    for (uint8_t k = 0; k < n_clients; k++) {
+        fds[k + 1].fd = client[k].fd;
+        fds[k + 1].events = POLLIN;
+    }
+
+    uint8_t n_polled = n_clients;
+    if (poll(fds, n_polled + 1, timeout_ms) < 0) { return EC_STORAGE; }
+
+    // Walk backwards so drop() (which moves the last client into the hole) is safe.
+    for (uint8_t k = n_polled; k > 0; k--) {
+        Client &c = client[k - 1];
+        c.request_length = 0;
+        if (!fds[k].revents) { continue; }
+
+        ssize_t n = recv(c.fd, c.request, sizeof(c.request), 0);
+        if (n <= 0) {
+            drop(k - 1);        // Hung up.
+        } else {
+            c.request_length = n;
+        }
+    }
+
+    server->begin_round();
+    for (uint8_t k = 0; k < n_clients; k++) {
+        Client &c = client[k];
+        c.response_length = 0;
+        if (c.request_length) {
+            server->add_request(c.request, c.request_length, c.response, &c.response_length);
+        }
+    }
+    server->run_round();
+
+    for (uint8_t k = n_clients; k > 0; k--) {
+        Client &c = client[k - 1];
+        if (c.request_length == 0) { continue; }
+
+        if (c.response_length == 0 ||       // Malformed request.
+            send(c.fd, c.response, c.response_length, MSG_NOSIGNAL | MSG_DONTWAIT) !=
+                c.response_length) {
+            drop(k - 1);        // Or not reading its responses: never block the round on it.
+        }
+    }
+
+    if (fds[0].revents & POLLIN) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+
+        if (fd >= 0 && n_clients < AD525X_SOCKET_MAX_CLIENTS) {
+            client[n_clients].fd = fd;
+            client[n_clients].request_length = 0;
+            n_clients++;
+        } else if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    return EC_NO_ERR;
+}
+
+void AD525xSocketServer::close() {
+    /** Disconnect all clients, close the listening socket and remove the socket file. */
+    while (n_clients > 0) {
+        drop(n_clients - 1);
+    }
+
+    if (listen_fd >= 0) {
+        ::close(listen_fd);
+        listen_fd = -1;
+        unlink(path);
+    }
+}
+
+int AD525xSocketServer::get_fd() {
+    /** Retrieve the listening socket, e.g. to check that `listen()` succeeded. */
+    return listen_fd;
+}
+
+void AD525xSocketServer::drop(uint8_t k) {
+    /** Close client `k` and compact the client table. */
+    ::close(client[k].fd);
+    if (k != --n_clients) { client[k] = client[n_clients]; }
+}
+#endif
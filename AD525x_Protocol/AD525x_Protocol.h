@@ -0,0 +1,146 @@
+/** @file
+Header file for a compact binary request protocol that lets one process own a set of AD525x
+devices and serve batched wiper operations to others.
+*/
+#ifndef AD525X_PROTOCOL_H
+#define AD525X_PROTOCOL_H
+
+#include <AD525x.h>
+#include <cstdint>
+
+#ifndef AD525X_PROTO_MAX_OPS
+#define AD525X_PROTO_MAX_OPS 32         /*!< Operations per request message. */
+#endif
+
+#ifndef AD525X_PROTO_MAX_DEVICES
+#define AD525X_PROTO_MAX_DEVICES 16     /*!< Devices served by one `AD525xProtocolServer`. */
+#endif
+
+#ifndef AD525X_PROTO_MAX_ROUND
+#define AD525X_PROTO_MAX_ROUND 16       /*!< Requests executed together in one round. */
+#endif
+
+/** @{ */
+// Message layout. Request: magic, op count, then per op: opcode, device, register, value.
+// Response: magic, op count, then per op: error code, value.
+#define AD525X_PROTO_MAGIC 0xAD
+#define AD525X_PROTO_HEADER_LEN 2
+#define AD525X_PROTO_OP_LEN 4
+#define AD525X_PROTO_RESULT_LEN 2
+#define AD525X_PROTO_MAX_REQUEST (AD525X_PROTO_HEADER_LEN + AD525X_PROTO_MAX_OPS * AD525X_PROTO_OP_LEN)
+#define AD525X_PROTO_MAX_RESPONSE (AD525X_PROTO_HEADER_LEN + AD525X_PROTO_MAX_OPS * AD525X_PROTO_RESULT_LEN)
+/**@}*/
+
+/** @{ */
+// Opcodes
+#define AD525X_OP_WRITE_RDAC 0x01       /*!< Move a wiper (via `move_RDAC()`). */
+#define AD525X_OP_READ_RDAC 0x02        /*!< Read a wiper, from the cache when known. */
+#define AD525X_OP_WRITE_EEMEM 0x03      /*!< Write an EEMEM register. */
+#define AD525X_OP_READ_EEMEM 0x04       /*!< Read an EEMEM register. */
+#define AD525X_OP_STORE_RDAC 0x05       /*!< Store a wiper to its EEMEM register. */
+#define AD525X_OP_SYNC_RDAC 0x06        /*!< Read a wiper from the device, bypassing the cache. */
+/**@}*/
+
+class AD525xBatch {
+// Client-side request builder.
+public:
+    AD525xBatch() : n_ops(0) {};
+
+    uint8_t add(uint8_t opcode, uint8_t device, uint8_t reg, uint8_t value = 0);
+    void clear(void);
+
+    const uint8_t *data(void);
+    uint16_t size(void);
+
+private:
+    uint8_t buffer[AD525X_PROTO_MAX_REQUEST];
+    uint8_t n_ops;
+};
+
+class AD525xProtocolServer {
+public:
+    AD525xProtocolServer();
+
+    uint8_t add_device(AD525x &pot, uint8_t *index = NULL);
+
+    uint16_t handle(const uint8_t *request, uint16_t length, uint8_t *response);
+
+    void begin_round(void);
+    uint8_t add_request(const uint8_t *request, uint16_t length, uint8_t *response,
+                        uint16_t *response_length);
+    void run_round(void);
+
+    uint32_t get_requests(void);
+    uint32_t get_rounds(void);
+    uint32_t get_ops(void);
+    uint32_t get_coalesced(void);
+
+private:
+    struct Request {
+        const uint8_t *op;          /*!< First encoded operation. */
+        uint8_t *result;            /*!< First result slot of the response. */
+        uint8_t n_ops;
+    };
+
+    uint8_t execute(const uint8_t *op, uint8_t *value);
+    void wait_ready(uint8_t dev);
+    void link(bool resolve);
+
+    static const uint8_t skipped = 0xFF;    /*!< Result placeholder of a superseded wiper write. */
+
+    AD525x *device[AD525X_PROTO_MAX_DEVICES];
+    bool busy[AD525X_PROTO_MAX_DEVICES];        /*!< Programming EEMEM until `busy_until`. */
+    uint32_t busy_until[AD525X_PROTO_MAX_DEVICES];  /*!< `micros()` at which programming ends. */
+    uint8_t n_devices;
+
+    Request round[AD525X_PROTO_MAX_ROUND];
+    uint8_t n_round;
+
+    uint32_t requests;              /*!< Well-formed requests handled. */
+    uint32_t rounds;                /*!< Rounds run, each covering one or more requests. */
+    uint32_t ops;                   /*!< Operations executed on the bus. */
+    uint32_t coalesced;             /*!< Wiper writes skipped because a later op replaced them. */
+};
+
+#if defined(__linux__)
+#ifndef AD525X_SOCKET_MAX_CLIENTS
+#define AD525X_SOCKET_MAX_CLIENTS 16    /*!< Concurrent client connections. */
+#endif
+
+#if AD525X_SOCKET_MAX_CLIENTS > AD525X_PROTO_MAX_ROUND
+#error "AD525X_SOCKET_MAX_CLIENTS must not exceed AD525X_PROTO_MAX_ROUND"
+#endif
+
+class AD525xSocketServer {
+// Serves an AD525xProtocolServer on a Unix SOCK_SEQPACKET socket: one datagram is one batch, and
+// the batches that arrive together from all clients run as one round.
+public:
+    AD525xSocketServer(AD525xProtocolServer &server);
+    ~AD525xSocketServer();
+
+    uint8_t listen(const char *path);
+    uint8_t poll_once(int timeout_ms);
+    void close(void);
+
+    int get_fd(void);
+
+private:
+    struct Client {
+        int fd;
+        uint16_t request_length;    /*!< Request received for this round, or 0. */
+        uint16_t response_length;   /*!< 0 if the request was malformed. */
+        uint8_t request[AD525X_PROTO_MAX_REQUEST];
+        uint8_t response[AD525X_PROTO_MAX_RESPONSE];
+    };
+
+    void drop(uint8_t k);
+
+    AD525xProtocolServer *server;
+    int listen_fd;
+    Client client[AD525X_SOCKET_MAX_CLIENTS];
+    uint8_t n_clients;
+    char path[108];                 /*!< Socket path, unlinked on close. */
+};
+#endif
+
+#endif
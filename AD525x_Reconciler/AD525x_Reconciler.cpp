@@ -0,0 +1,259 @@
+/** @file
+Class file for a desired-state reconciler that keeps a set of AD525x devices in a declared state
+with the fewest bus transactions.
+*/
+
+#include <AD525x_Reconciler.h>
+#include <AD525x_Errors.h>
+#include <Arduino.h>
+
+AD525xReconciler::AD525xReconciler() : n_devices(0), transactions(0), retries(0), err_code(0) {
+    /** Create a reconciler with no desired state. */
+}
+
+uint8_t AD525xReconciler::set_wiper(AD525x &pot, uint8_t RDAC, uint8_t value) {
+    /** Declare the desired wiper value of `RDAC` on `pot`. Nothing is sent until `reconcile()`.
+
+    @return Returns 0 on no error, `EC_BAD_REGISTER` if `RDAC` exceeds 3, `EC_BAD_WIPER_SETTING`
+            if `value` exceeds the device maximum, or `EC_NO_RESOURCES` if the device table is full.
+    */
+    if (RDAC > 3) { return (err_code = EC_BAD_REGISTER); }
+    if (value > pot.get_max_val()) { return (err_code = EC_BAD_WIPER_SETTING); }
+
+    Device *dev = find_device(pot);
+    if (dev == NULL) { return (err_code = EC_NO_RESOURCES); }
+
+    dev->wiper[RDAC] = value;
+    dev->wiper_mask |= (1 << RDAC);
+
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xReconciler::set_EEMEM(AD525x &pot, uint8_t reg, uint8_t value) {
+    /** Declare the desired contents of EEMEM register `reg` on `pot`.
+
+    EEMEM state is compared against the values this object has written. A register is not read
+    back from the device, so the first reconcile after start-up always programs it once.
+
+    @return Returns 0 on no error, `EC_BAD_REGISTER` if `reg` exceeds 15, `EC_BAD_WIPER_SETTING` if
+            `reg` is an RDAC register (0-3) and `value` exceeds the maximum wiper setting, or
+            `EC_NO_RESOURCES` if the device table is full.
+    */
+    if (reg > 15) { return (err_code = EC_BAD_REGISTER); }
+    if (reg <= 3 && value > pot.get_max_val()) { return (err_code = EC_BAD_WIPER_SETTING); }
+
+    Device *dev = find_device(pot);
+    if (dev == NULL) { return (err_code = EC_NO_RESOURCES); }
+
+    dev->EEMEM[reg] = value;
+    dev->EEMEM_mask |= (1 << reg);
+
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xReconciler::forget(AD525x &pot) {
+    /** Drop all desired state for `pot` and free its table entry. */
+    for (uint8_t k = 0; k < n_devices; k++) {
+        if (device[k].pot == &pot) {
+            device[k] = device[--n_devices];
+            return (err_code = EC_NO_ERR);
+        }
+    }
+
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xReconciler::reconcile() {
+    /** Issue the operations needed to bring every device closer to its desired state.
+
+    Wipers are compared against the cached state of each `AD525x` object, so wipers that already
+    match cost nothing. When all four wipers of a device need the same single step, one
+    increment/decrement-all command is sent instead of four writes; otherwise each wiper is moved
+    with `AD525x::move_RDAC()`. At most one EEMEM register is programmed per device per call, and
+    the device is then left alone until programming completes.
+
+    Failed writes are left outstanding and retried on the next call, so calling this periodically
+    converges after transient bus errors without rewriting what already succeeded.
+
+    @return Returns 0 on no error, otherwise the error code of the last failed operation.
+    */
+    uint8_t rv = EC_NO_ERR;
+    uint32_t now = millis();
+
+    for (uint8_t k = 0; k < n_devices; k++) {
+        if (reconcile_device(device[k], now)) { rv = err_code; }
+    }
+
+    return (err_code = rv);
+}
+
+bool AD525xReconciler::converged() {
+    /** True if every declared wiper and EEMEM value is known to be on its device. */
+    return get_outstanding() == 0;
+}
+
+uint16_t AD525xReconciler::get_outstanding() {
+    /** Retrieve the number of declared values not yet known to be on their device. */
+    uint16_t n = 0;
+
+    for (uint8_t k = 0; k < n_devices; k++) {
+        uint8_t w = dirty_wipers(device[k]);
+        uint16_t e = dirty_EEMEM(device[k]);
+
+        for (uint8_t i = 0; i < 16; i++) {
+            n += ((w >> i) & 1) + ((e >> i) & 1);
+        }
+    }
+
+    return n;
+}
+
+uint32_t AD525xReconciler::get_transactions() {
+    /** Retrieve the number of bus transactions issued by `reconcile()`. */
+    return transactions;
+}
+
+uint32_t AD525xReconciler::get_retries() {
+    /** Retrieve the number of writes reissued after a failure. */
+    return retries;
+}
+
+uint8_t AD525xReconciler::get_err_code() {
+    /** Retrieve the error code of the last operation. See `AD525x_Errors.h`. */
+    return err_code;
+}
+
+//
+// Private functions
+//
+AD525xReconciler::Device *AD525xReconciler::find_device(AD525x &pot) {
+    /** Look up the entry for `pot`, adding an empty one if it is new. Returns NULL when full. */
+    for (uint8_t k = 0; k < n_devices; k++) {
+        if (device[k].pot == &pot) { return &device[k]; }
+    }
+
+    if (n_devices >= AD525X_RECONCILE_MAX_DEVICES) { return NULL; }
+
+    Device &dev = device[n_devices++];
+    dev.pot = &pot;
+    dev.wiper_mask = dev.wiper_failed = 0;
+    dev.EEMEM_mask = dev.EEMEM_known_mask = dev.EEMEM_failed = 0;
+    dev.busy = false;
+
+    return &dev;
+}
+
+uint8_t AD525xReconciler::dirty_wipers(Device &dev) {
+    /** Bit mask of declared wipers whose cached value is unknown or different. */
+    uint8_t dirty = 0;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        if (!(dev.wiper_mask & (1 << i))) { continue; }
+
+        if (!dev.pot->is_cached(i) || dev.pot->read_RDAC_cached(i) != dev.wiper[i]) {
+            dirty |= (1 << i);
+        }
+    }
+
+    return dirty;
+}
+
+uint16_t AD525xReconciler::dirty_EEMEM(Device &dev) {
+    /** Bit mask of declared EEMEM registers not known to hold their desired value. */
+    uint16_t dirty = dev.EEMEM_mask & ~dev.EEMEM_known_mask;
+
+    for (uint8_t i = 0; i < 16; i++) {
+        uint16_t bit = 1 << i;
+        if ((dev.EEMEM_mask & dev.EEMEM_known_mask & bit) && dev.EEMEM_known[i] != dev.EEMEM[i]) {
+            dirty |= bit;
+        }
+    }
+
+    return dirty;
+}
+
+uint8_t AD525xReconciler::reconcile_device(Device &dev, uint32_t now) {
+    /** Run one reconcile pass on a single device. */
+    uint8_t rv = EC_NO_ERR;
+    AD525x *pot = dev.pot;
+
+    if (dev.busy) {
+        if ((int32_t)(now - dev.busy_until) < 0) { return (err_code = EC_NO_ERR); }
+        dev.busy = false;
+    }
+
+    uint8_t dirty = dirty_wipers(dev);
+
+    if (dirty == 0x0F) {
+        // All four known and off by the same single step: one command moves them all.
+        int8_t step = 0;
+        uint8_t max_val = pot->get_max_val();
+
+        for (uint8_t i = 0; i < 4; i++) {
+            if (!pot->is_cached(i)) { step = 0; break; }
+
+            uint8_t cur = pot->read_RDAC_cached(i);
+            int8_t s = (dev.wiper[i] == cur + 1 && cur < max_val) ? 1 :
+                       ((dev.wiper[i] + 1 == cur) ? -1 : 0);
+
+            if (s == 0 || (i > 0 && s != step)) { step = 0; break; }
+            step = s;
+        }
+
+        if (step != 0) {
+            transactions++;
+            if (dev.wiper_failed) { retries++; }
+
+            if ((step > 0) ? pot->increment_all_RDAC() : pot->decrement_all_RDAC()) {
+                dev.wiper_failed = 0x0F;
+                rv = pot->get_err_code();
+            } else {
+                dev.wiper_failed = 0;
+            }
+
+            dirty = dirty_wipers(dev);
+        }
+    }
+
+    for (uint8_t i = 0; i < 4; i++) {
+        uint8_t bit = 1 << i;
+        if (!(dirty & bit)) { continue; }
+
+        transactions++;
+        if (dev.wiper_failed & bit) { retries++; }
+
+        if (pot->move_RDAC(i, dev.wiper[i])) {
+            dev.wiper_failed |= bit;
+            rv = pot->get_err_code();
+        } else {
+            dev.wiper_failed &= ~bit;
+        }
+    }
+
+    uint16_t EEMEM_dirty = dirty_EEMEM(dev);
+
+    for (uint8_t i = 0; i < 16; i++) {
+        uint16_t bit = 1 << i;
+        if (!(EEMEM_dirty & bit)) { continue; }
+
+        transactions++;
+        if (dev.EEMEM_failed & bit) { retries++; }
+
+        if (pot->write_EEMEM(i, dev.EEMEM[i])) {
+            dev.EEMEM_failed |= bit;
+            dev.EEMEM_known_mask &= ~bit;
+            rv = pot->get_err_code();
+            continue;   // Nothing was programmed; a failing register must not hold up the rest.
+        }
+
+        dev.EEMEM_failed &= ~bit;
+        dev.EEMEM_known[i] = dev.EEMEM[i];
+        dev.EEMEM_known_mask |= bit;
+
+        dev.busy = true;
+        dev.busy_until = now + AD525X_EEMEM_WRITE_MS;
+        break;      // One EEMEM write per pass; the device is busy programming it.
+    }
+
+    return (err_code = rv);
+}
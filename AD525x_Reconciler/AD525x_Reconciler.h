@@ -0,0 +1,61 @@
+/** @file
+Header file for a desired-state reconciler that keeps a set of AD525x devices in a declared state
+with the fewest bus transactions.
+*/
+#ifndef AD525X_RECONCILER_H
+#define AD525X_RECONCILER_H
+
+#include <AD525x.h>
+#include <cstdint>
+
+#ifndef AD525X_RECONCILE_MAX_DEVICES
+#define AD525X_RECONCILE_MAX_DEVICES 8  /*!< Devices tracked by one `AD525xReconciler`. */
+#endif
+
+class AD525xReconciler {
+public:
+    AD525xReconciler();
+
+    uint8_t set_wiper(AD525x &pot, uint8_t RDAC, uint8_t value);
+    uint8_t set_EEMEM(AD525x &pot, uint8_t reg, uint8_t value);
+    uint8_t forget(AD525x &pot);
+
+    uint8_t reconcile(void);
+    bool converged(void);
+
+    uint16_t get_outstanding(void);
+    uint32_t get_transactions(void);
+    uint32_t get_retries(void);
+
+    uint8_t get_err_code(void);
+
+private:
+    struct Device {
+        AD525x *pot;
+        uint8_t wiper[4];           /*!< Desired wiper values. */
+        uint8_t wiper_mask;         /*!< Bit mask of wipers with a desired value. */
+        uint8_t wiper_failed;       /*!< Wipers whose last write failed. */
+        uint8_t EEMEM[16];          /*!< Desired EEMEM contents. */
+        uint8_t EEMEM_known[16];    /*!< EEMEM contents last written successfully. */
+        uint16_t EEMEM_mask;        /*!< Bit mask of EEMEM registers with a desired value. */
+        uint16_t EEMEM_known_mask;  /*!< Bit mask of valid entries in `EEMEM_known`. */
+        uint16_t EEMEM_failed;      /*!< EEMEM registers whose last write failed. */
+        uint32_t busy_until;        /*!< `millis()` at which EEMEM programming is complete. */
+        bool busy;
+    };
+
+    Device *find_device(AD525x &pot);
+    uint8_t dirty_wipers(Device &dev);
+    uint16_t dirty_EEMEM(Device &dev);
+    uint8_t reconcile_device(Device &dev, uint32_t now);
+
+    Device device[AD525X_RECONCILE_MAX_DEVICES];
+    uint8_t n_devices;
+
+    uint32_t transactions;          /*!< Bus transactions issued by `reconcile()`. */
+    uint32_t retries;               /*!< Writes reissued after a failure. */
+
+    uint8_t err_code;
+};
+
+#endif
@@ -0,0 +1,121 @@
+/** @file
+Class file for applying a set of wiper values to one AD525x device as a single all-or-nothing
+scene.
+*/
+
+#include <AD525x_Scene.h>
+#include <AD525x_Errors.h>
+#include <Arduino.h>
+
+AD525xScene::AD525xScene(AD525x &pot) :
+    pot(&pot), mask(0), was_rolled_back(false), duration(0), err_code(0) {
+    /** Create an empty scene for `pot`. */
+}
+
+uint8_t AD525xScene::set(uint8_t RDAC, uint8_t value) {
+    /** Stage a wiper value. Nothing is sent until `apply()`.
+
+    @return Returns 0 on no error, `EC_BAD_REGISTER` if `RDAC` exceeds 3, or `EC_BAD_WIPER_SETTING`
+            if `value` exceeds the device maximum.
+    */
+    if (RDAC > 3) { return (err_code = EC_BAD_REGISTER); }
+    if (value > pot->get_max_val()) { return (err_code = EC_BAD_WIPER_SETTING); }
+
+    this->value[RDAC] = value;
+    mask |= (1 << RDAC);
+
+    return (err_code = EC_NO_ERR);
+}
+
+void AD525xScene::clear() {
+    /** Remove all staged wiper values. */
+    mask = 0;
+}
+
+uint8_t AD525xScene::apply(uint8_t retries, bool rollback) {
+    /** Apply all staged wiper values, or none of them.
+
+    The previous value of every staged wiper is taken from the `AD525x` cache (read from the device
+    only if unknown) before anything is written. Wipers moving down are written before wipers moving
+    up, so intermediate states never exceed the louder of the old and new scene. Wipers already at
+    their target cost nothing.
+
+    If a write fails, the unfinished part of the scene is retried up to `retries` times. If it still
+    fails and `rollback` is set, the previous values are restored (with the same retry budget), so
+    the device is left in either the new or the old scene rather than a mix of both.
+
+    @param[in] retries  Additional attempts after the first failure.
+    @param[in] rollback Restore the previous scene if the new one cannot be applied.
+
+    @return Returns 0 if the new scene is in place, otherwise the error code of the first failure.
+            Use `rolled_back()` to tell whether the old scene was restored.
+    */
+    uint32_t start = micros();
+    uint8_t prev[4];
+
+    was_rolled_back = false;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        if (!(mask & (1 << i))) { continue; }
+
+        prev[i] = pot->read_RDAC_cached(i);
+        if (pot->get_err_code()) {
+            duration = micros() - start;
+            return (err_code = pot->get_err_code());    // Nothing has been written yet.
+        }
+    }
+
+    uint8_t rv = EC_NO_ERR;
+    for (uint8_t attempt = 0; attempt <= retries; attempt++) {
+        if (!(rv = write_ordered(value, prev, mask))) { break; }
+    }
+
+    if (rv && rollback) {
+        for (uint8_t attempt = 0; attempt <= retries; attempt++) {
+            if (!write_ordered(prev, value, mask)) {
+                was_rolled_back = true;
+                break;
+            }
+        }
+    }
+
+    duration = micros() - start;
+    return (err_code = rv);
+}
+
+bool AD525xScene::rolled_back() {
+    /** True if the last `apply()` failed and the previous scene was restored. */
+    return was_rolled_back;
+}
+
+uint32_t AD525xScene::get_duration() {
+    /** Retrieve the duration of the last `apply()`, including retries and rollback, in
+    microseconds. */
+    return duration;
+}
+
+uint8_t AD525xScene::get_err_code() {
+    /** Retrieve the error code of the last operation. See `AD525x_Errors.h`. */
+    return err_code;
+}
+
+//
+// Private functions
+//
+uint8_t AD525xScene::write_ordered(const uint8_t *target, const uint8_t *from, uint8_t mask) {
+    /** Move the wipers in `mask` from the scene `from` to `target`, decreasing moves first. The
+    order comes from the two scenes, not the cache: a retried wiper whose write failed is no longer
+    cached, but must still go out in its own pass. Returns the first error. */
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        for (uint8_t i = 0; i < 4; i++) {
+            if (!(mask & (1 << i))) { continue; }
+
+            bool down = target[i] <= from[i];
+            if (down != (pass == 0)) { continue; }
+
+            if (pot->move_RDAC(i, target[i])) { return pot->get_err_code(); }
+        }
+    }
+
+    return EC_NO_ERR;
+}
@@ -0,0 +1,36 @@
+/** @file
+Header file for applying a set of wiper values to one AD525x device as a single all-or-nothing
+scene.
+*/
+#ifndef AD525X_SCENE_H
+#define AD525X_SCENE_H
+
+#include <AD525x.h>
+#include <cstdint>
+
+class AD525xScene {
+public:
+    AD525xScene(AD525x &pot);
+
+    uint8_t set(uint8_t RDAC, uint8_t value);
+    void clear(void);
+
+    uint8_t apply(uint8_t retries = 2, bool rollback = true);
+
+    bool rolled_back(void);
+    uint32_t get_duration(void);
+    uint8_t get_err_code(void);
+
+private:
+    uint8_t write_ordered(const uint8_t *target, const uint8_t *from, uint8_t mask);
+
+    AD525x *pot;
+    uint8_t value[4];       /*!< Staged wiper values. */
+    uint8_t mask;           /*!< Bit mask of staged wipers. */
+
+    bool was_rolled_back;   /*!< True if the last `apply()` restored the previous scene. */
+    uint32_t duration;      /*!< Duration of the last `apply()` in microseconds. */
+    uint8_t err_code;
+};
+
+#endif
@@ -0,0 +1,299 @@
+/** @file
+Class file for a priority-aware transaction queue shared by one or more AD525x devices on a bus.
+*/
+
+#include <AD525x_Scheduler.h>
+#include <AD525x_Budget.h>
+#include <AD525x_Errors.h>
+#include <Arduino.h>
+
+AD525xScheduler::AD525xScheduler() :
+    busy(busy_slots, AD525X_SCHED_MAX_BUSY), limiter(NULL), err_code(0) {
+    /** Create an empty scheduler. Operations are submitted with the queueing functions and executed
+    by `service()` or `run_one()`. */
+    for (uint8_t p = 0; p < AD525X_NUM_PRIO; p++) {
+        count[p] = 0;
+    }
+
+    reset_stats();
+}
+
+uint8_t AD525xScheduler::write_RDAC(AD525x &pot, uint8_t RDAC, uint8_t value, uint8_t prio,
+                                    volatile uint8_t *status) {
+    /** Queue a wiper update. It is executed with `AD525x::move_RDAC()`.
+
+    @param[in]  pot    The target device.
+    @param[in]  RDAC   The RDAC to move [0-3].
+    @param[in]  value  The wiper value.
+    @param[in]  prio   One of the `AD525X_PRIO_*` classes.
+    @param[out] status If not NULL, set to `AD525X_SCHED_PENDING` now and to the error code of the
+                       operation when it completes.
+
+    @return Returns 0 if queued, `EC_NO_RESOURCES` if the class queue is full, or `EC_BAD_REGISTER`
+            if `prio` is not a valid class.
+    */
+    return enqueue(pot, op_write_RDAC, RDAC, value, NULL, prio, status);
+}
+
+uint8_t AD525xScheduler::read_RDAC(AD525x &pot, uint8_t RDAC, uint8_t *result, uint8_t prio,
+                                   volatile uint8_t *status) {
+    /** Queue a wiper read. The value is stored to `result` on completion. See `write_RDAC()`. */
+    return enqueue(pot, op_read_RDAC, RDAC, 0, result, prio, status);
+}
+
+uint8_t AD525xScheduler::write_EEMEM(AD525x &pot, uint8_t reg, uint8_t value, uint8_t prio,
+                                     volatile uint8_t *status) {
+    /** Queue an EEMEM write. The device is left alone for `AD525X_EEMEM_WRITE_MS` afterwards while
+    it programs, and other work is scheduled in the meantime. See `write_RDAC()`. */
+    return enqueue(pot, op_write_EEMEM, reg, value, NULL, prio, status);
+}
+
+uint8_t AD525xScheduler::read_EEMEM(AD525x &pot, uint8_t reg, uint8_t *result, uint8_t prio,
+                                    volatile uint8_t *status) {
+    /** Queue an EEMEM read. The value is stored to `result` on completion. See `write_RDAC()`. */
+    return enqueue(pot, op_read_EEMEM, reg, 0, result, prio, status);
+}
+
+uint8_t AD525xScheduler::store_RDAC(AD525x &pot, uint8_t RDAC, uint8_t prio,
+                                    volatile uint8_t *status) {
+    /** Queue a store of the RDAC wiper to its EEMEM register. See `write_EEMEM()`. */
+    return enqueue(pot, op_store_RDAC, RDAC, 0, NULL, prio, status);
+}
+
+void AD525xScheduler::set_budget(AD525xRateLimiter *limiter) {
+    /** Charge every operation, reads and EEMEM traffic included, to the budgets of `limiter`.
+    An operation whose device or class budget is spent waits in its queue, as for a device that
+    is programming EEMEM, while other devices and classes go ahead. Critical operations are never
+    held back, but they are charged. Pass NULL to run without budgets. */
+    this->limiter = limiter;
+}
+
+uint8_t AD525xScheduler::run_one() {
+    /** Execute the single most urgent runnable operation, if there is one.
+
+    The highest non-empty priority class wins, so an urgent wiper write submitted while a bulk
+    EEMEM backup is queued goes out at the next transaction boundary, and the backup resumes after
+    it. Within a class, operations run in submission order, except that operations for a device
+    still programming EEMEM, or over its budget (see `set_budget()`), are skipped until it is ready.
+
+    @return Returns 0 if an operation ran successfully or nothing was runnable, otherwise the error
+            code of the operation that ran.
+    */
+    uint32_t now = micros();
+
+    for (uint8_t p = 0; p < AD525X_NUM_PRIO; p++) {
+        for (uint8_t i = 0; i < count[p]; i++) {
+            if (busy.busy_until(queue[p][i].pot, now)) { continue; }
+            if (limiter != NULL &&
+                !limiter->admit(*queue[p][i].pot, p, op_bytes(queue[p][i]))) { continue; }
+
+            Op op = queue[p][i];
+            for (uint8_t k = i + 1; k < count[p]; k++) {
+                queue[p][k - 1] = queue[p][k];
+            }
+            count[p]--;
+
+            uint8_t rv = execute(op);
+
+            last_latency[p] = micros() - op.enqueued;
+            if (last_latency[p] > max_latency[p]) { max_latency[p] = last_latency[p]; }
+
+            return (err_code = rv);
+        }
+    }
+
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xScheduler::service() {
+    /** Execute operations until nothing is runnable. Call this regularly, e.g. from `loop()`.
+
+    Priorities are re-evaluated after every operation. Returns without waiting when the only queued
+    work is for devices that are programming EEMEM.
+
+    @return Returns 0 on no error, otherwise the error code of the last failed operation.
+    */
+    uint8_t rv = EC_NO_ERR;
+
+    while (true) {
+        uint8_t queued = 0;
+        for (uint8_t p = 0; p < AD525X_NUM_PRIO; p++) {
+            queued += count[p];
+        }
+
+        uint8_t before = queued;
+        uint8_t e = run_one();
+        if (e) { rv = e; }
+
+        queued = 0;
+        for (uint8_t p = 0; p < AD525X_NUM_PRIO; p++) {
+            queued += count[p];
+        }
+
+        if (queued == before) { break; }    // Nothing was runnable.
+    }
+
+    return (err_code = rv);
+}
+
+uint32_t AD525xScheduler::get_wait_us() {
+    /** Retrieve how long until `run_one()` can make progress, so an event loop can sleep until then.
+
+    @return Returns 0 if an operation is runnable now, the time in microseconds until the first
+            busy device finishes programming EEMEM or the first budget refills if every queued
+            operation waits on one, or `AD525X_SCHED_IDLE` if nothing is queued.
+    */
+    uint32_t now = micros();
+    uint32_t wait = AD525X_SCHED_IDLE;
+
+    for (uint8_t p = 0; p < AD525X_NUM_PRIO; p++) {
+        for (uint8_t i = 0; i < count[p]; i++) {
+            uint32_t until, w;
+
+            if (busy.busy_until(queue[p][i].pot, now, &until)) {
+                w = until - now;
+            } else if (limiter != NULL) {
+                w = limiter->get_wait_us(*queue[p][i].pot, p, op_bytes(queue[p][i]));
+            } else {
+                w = 0;
+            }
+
+            if (w == 0) { return 0; }
+            if (w < wait) { wait = w; }
+        }
+    }
+
+    return wait;
+}
+
+uint8_t AD525xScheduler::get_queued(uint8_t prio) {
+    /** Retrieve the number of operations waiting in class `prio`. */
+    return (prio < AD525X_NUM_PRIO) ? count[prio] : 0;
+}
+
+uint32_t AD525xScheduler::get_last_latency(uint8_t prio) {
+    /** Retrieve the submission-to-completion time of the last operation of class `prio`, in
+    microseconds. */
+    return (prio < AD525X_NUM_PRIO) ? last_latency[prio] : 0;
+}
+
+uint32_t AD525xScheduler::get_max_latency(uint8_t prio) {
+    /** Retrieve the worst submission-to-completion time of class `prio` since the last
+    `reset_stats()`, in microseconds. */
+    return (prio < AD525X_NUM_PRIO) ? max_latency[prio] : 0;
+}
+
+uint8_t AD525xScheduler::get_high_water(uint8_t prio) {
+    /** Retrieve the deepest the queue of class `prio` has been since the last `reset_stats()`.
+    Use this to size `AD525X_SCHED_QUEUE_LEN`: if it equals the queue length, submissions may have
+    been refused. */
+    return (prio < AD525X_NUM_PRIO) ? high_water[prio] : 0;
+}
+
+uint8_t AD525xScheduler::get_busy_high_water() {
+    /** Retrieve the most devices programming EEMEM at once since the last `reset_stats()`. A value
+    above `AD525X_SCHED_MAX_BUSY` means a write had to wait out its programming time in place. */
+    return busy.get_high_water();
+}
+
+void AD525xScheduler::reset_stats() {
+    /** Clear the latency statistics and high-water marks. */
+    busy.reset_high_water();
+
+    for (uint8_t p = 0; p < AD525X_NUM_PRIO; p++) {
+        high_water[p] = count[p];
+        last_latency[p] = 0;
+        max_latency[p] = 0;
+    }
+}
+
+uint8_t AD525xScheduler::get_err_code() {
+    /** Retrieve the error code of the last operation. See `AD525x_Errors.h`. */
+    return err_code;
+}
+
+//
+// Private functions
+//
+uint8_t AD525xScheduler::enqueue(AD525x &pot, uint8_t type, uint8_t reg, uint8_t value,
+                                 uint8_t *result, uint8_t prio, volatile uint8_t *status) {
+    /** Append an operation to the queue of class `prio`. */
+    if (prio >= AD525X_NUM_PRIO) { return (err_code = EC_BAD_REGISTER); }
+    if (count[prio] >= AD525X_SCHED_QUEUE_LEN) { return (err_code = EC_NO_RESOURCES); }
+
+    Op &op = queue[prio][count[prio]++];
+    if (count[prio] > high_water[prio]) { high_water[prio] = count[prio]; }
+
+    op.pot = &pot;
+    op.type = type;
+    op.reg = reg;
+    op.value = value;
+    op.result = result;
+    op.status = status;
+    op.enqueued = micros();
+
+    if (status != NULL) { *status = AD525X_SCHED_PENDING; }
+
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xScheduler::execute(Op &op) {
+    /** Run `op` on its device and post the result to its completion slot. */
+    uint8_t rv = EC_NO_ERR;
+    uint8_t value = 0;
+
+    switch (op.type) {
+        case op_write_RDAC:
+            rv = op.pot->move_RDAC(op.reg, op.value);
+            break;
+        case op_read_RDAC: {
+            AD525xResult r = op.pot->read_RDAC_result(op.reg);
+            value = r.value;
+            rv = r.err;
+            break;
+        }
+        case op_write_EEMEM:
+            rv = op.pot->write_EEMEM(op.reg, op.value);
+            break;
+        case op_read_EEMEM: {
+            AD525xResult r = op.pot->read_EEMEM_result(op.reg);
+            value = r.value;
+            rv = r.err;
+            break;
+        }
+        case op_store_RDAC:
+            rv = op.pot->store_RDAC(op.reg);
+            break;
+    }
+
+    if (!rv && (op.type == op_write_EEMEM || op.type == op_store_RDAC)) {
+        set_busy(op.pot, micros());
+    }
+
+    if (!rv && op.result != NULL) { *op.result = value; }
+    if (op.status != NULL) { *op.status = rv; }
+
+    return rv;
+}
+
+uint8_t AD525xScheduler::op_bytes(Op &op) {
+    /** Bytes `op` puts on the wire, address bytes included, for charging to the budgets. */
+    switch (op.type) {
+        case op_write_RDAC:
+            return AD525xRateLimiter::move_bytes(*op.pot, op.reg, op.value);
+        case op_store_RDAC:
+            return 2;       // Address and command.
+        case op_write_EEMEM:
+            return 3;       // Address, instruction and data.
+        default:
+            return 4;       // A read: address and instruction, then address and data.
+    }
+}
+
+void AD525xScheduler::set_busy(AD525x *pot, uint32_t now) {
+    /** Mark `pot` as programming EEMEM for the next `AD525X_EEMEM_WRITE_MS`. If every slot is in
+    use, wait out the programming time here instead, so the device is never addressed early. */
+    if (!busy.set_busy(pot, now + AD525X_EEMEM_WRITE_MS * 1000UL)) {
+        delay(AD525X_EEMEM_WRITE_MS);
+    }
+}
@@ -0,0 +1,91 @@
+/** @file
+Header file for a priority-aware transaction queue shared by one or more AD525x devices on a bus.
+*/
+#ifndef AD525X_SCHEDULER_H
+#define AD525X_SCHEDULER_H
+
+#include <AD525x.h>
+#include <cstdint>
+
+#ifndef AD525X_SCHED_QUEUE_LEN
+#define AD525X_SCHED_QUEUE_LEN 8    /*!< Queued operations per priority class. */
+#endif
+
+#ifndef AD525X_SCHED_MAX_BUSY
+#define AD525X_SCHED_MAX_BUSY 4     /*!< Devices that can be programming EEMEM at the same time. */
+#endif
+
+#define AD525X_SCHED_PENDING 0xFF   /*!< Status value of an operation that has not completed. */
+#define AD525X_SCHED_IDLE 0xFFFFFFFFUL  /*!< `get_wait_us()` value when nothing is queued. */
+
+class AD525xRateLimiter;
+
+class AD525xScheduler {
+public:
+    AD525xScheduler();
+
+    uint8_t write_RDAC(AD525x &pot, uint8_t RDAC, uint8_t value,
+                       uint8_t prio = AD525X_PRIO_NORMAL, volatile uint8_t *status = NULL);
+    uint8_t read_RDAC(AD525x &pot, uint8_t RDAC, uint8_t *result,
+                      uint8_t prio = AD525X_PRIO_NORMAL, volatile uint8_t *status = NULL);
+    uint8_t write_EEMEM(AD525x &pot, uint8_t reg, uint8_t value,
+                        uint8_t prio = AD525X_PRIO_BULK, volatile uint8_t *status = NULL);
+    uint8_t read_EEMEM(AD525x &pot, uint8_t reg, uint8_t *result,
+                       uint8_t prio = AD525X_PRIO_BULK, volatile uint8_t *status = NULL);
+    uint8_t store_RDAC(AD525x &pot, uint8_t RDAC,
+                       uint8_t prio = AD525X_PRIO_BULK, volatile uint8_t *status = NULL);
+
+    void set_budget(AD525xRateLimiter *limiter);
+
+    uint8_t run_one(void);
+    uint8_t service(void);
+
+    uint32_t get_wait_us(void);
+
+    uint8_t get_queued(uint8_t prio);
+    uint32_t get_last_latency(uint8_t prio);
+    uint32_t get_max_latency(uint8_t prio);
+    uint8_t get_high_water(uint8_t prio);
+    uint8_t get_busy_high_water(void);
+    void reset_stats(void);
+
+    uint8_t get_err_code(void);
+
+private:
+    struct Op {
+        AD525x *pot;
+        uint8_t type;               /*!< One of the `op_*` constants. */
+        uint8_t reg;                /*!< RDAC or EEMEM register. */
+        uint8_t value;              /*!< Data for writes. */
+        uint8_t *result;            /*!< Destination for reads, may be NULL. */
+        volatile uint8_t *status;   /*!< Completion slot, may be NULL. */
+        uint32_t enqueued;          /*!< `micros()` at submission. */
+    };
+
+    uint8_t enqueue(AD525x &pot, uint8_t type, uint8_t reg, uint8_t value, uint8_t *result,
+                    uint8_t prio, volatile uint8_t *status);
+    uint8_t execute(Op &op);
+    uint8_t op_bytes(Op &op);
+    void set_busy(AD525x *pot, uint32_t now);
+
+    static const uint8_t op_write_RDAC = 0;
+    static const uint8_t op_read_RDAC = 1;
+    static const uint8_t op_write_EEMEM = 2;
+    static const uint8_t op_read_EEMEM = 3;
+    static const uint8_t op_store_RDAC = 4;
+
+    Op queue[AD525X_NUM_PRIO][AD525X_SCHED_QUEUE_LEN];
+    uint8_t count[AD525X_NUM_PRIO];
+
+    AD525xBusySlot busy_slots[AD525X_SCHED_MAX_BUSY];
+    AD525xBusyTable busy;           /*!< Devices programming EEMEM, in `micros()`. */
+    AD525xRateLimiter *limiter;     /*!< Budgets every operation is charged to, or NULL. */
+
+    uint32_t last_latency[AD525X_NUM_PRIO];     /*!< Submission to completion, microseconds. */
+    uint32_t max_latency[AD525X_NUM_PRIO];
+    uint8_t high_water[AD525X_NUM_PRIO];        /*!< Deepest queue seen per class. */
+
+    uint8_t err_code;
+};
+
+#endif
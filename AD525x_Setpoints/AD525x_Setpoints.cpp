@@ -0,0 +1,274 @@
+/** @file
+Class file for a lock-free setpoint table, shared between processes (or threads), in which
+clients post desired wiper values and a single bus owner pushes changes to the devices.
+*/
+
+#include <AD525x_Setpoints.h>
+#include <AD525x_Errors.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+AD525xSetpoints::AD525xSetpoints() : table(NULL), n_devices(0), pushed(0) {
+    /** Create an unattached handle. Call `attach()` or `open()` before use. */
+#if defined(__linux__)
+    mapped = false;
+#endif
+}
+
+AD525xSetpoints::~AD525xSetpoints() {
+#if defined(__linux__)
+    close();
+#endif
+}
+
+uint8_t AD525xSetpoints::attach(AD525xSetpointTable *table) {
+    /** Use `table`, initializing it if it is still zero-filled.
+
+    Use this when the table is shared between threads of one process, or when the caller mapped the
+    shared memory itself. When several attach a fresh table at once, exactly one initializes it and
+    the others wait for it to finish.
+
+    @return Returns 0 on no error, `EC_BAD_CHECKSUM` if the table holds anything other than a table
+            of this layout, or `EC_NOT_INITIALIZED` if another initializer never finished.
+    */
+    uint32_t expected = 0;
+    if (__atomic_compare_exchange_n(&table->magic, &expected, initializing, false,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        memset((uint8_t *)table + sizeof(table->magic), 0, sizeof(*table) - sizeof(table->magic));
+        table->size = sizeof(*table);
+        __atomic_store_n(&table->magic, AD525X_SETPOINT_MAGIC, __ATOMIC_RELEASE);
+    }
+
+    uint8_t rv = check(table);
+    for (uint32_t n = 0; rv == EC_NOT_INITIALIZED && n < AD525X_SETPOINT_TRIES; n++) {
+        rv = check(table);
+    }
+
+    if (rv) { return rv; }
+
+    this->table = table;
+    return EC_NO_ERR;
+}
+
+#if defined(__linux__)
+uint8_t AD525xSetpoints::open(const char *name, bool create) {
+    /** Map the POSIX shared memory object `name` (e.g. "/ad525x").
+
+    The bus owner opens with `create` set, which creates and initializes the table. Clients open
+    without it and fail with `EC_NOT_INITIALIZED` until the owner has done so.
+
+    @return Returns 0 on no error, `EC_STORAGE` if the object cannot be opened or mapped,
+            `EC_NOT_INITIALIZED` if a client finds no initialized table, or `EC_BAD_CHECKSUM` if
+            the object holds a table of another layout (remove it with `shm_unlink()`).
+    */
+    close();
+
+    int fd = shm_open(name, O_RDWR | (create ? O_CREAT : 0), 0660);
+    if (fd < 0) { return EC_STORAGE; }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return EC_STORAGE;
+    }
+
+    // Never map past the end of the object: touching that page would raise SIGBUS.
+    if (st.st_size != 0 && st.st_size != (off_t)sizeof(AD525xSetpointTable)) {
+        ::close(fd);
+        return EC_BAD_CHECKSUM;
+    }
+
+    if (st.st_size == 0 && (!create || ftruncate(fd, sizeof(AD525xSetpointTable)) != 0)) {
+        ::close(fd);
+        return create ? EC_STORAGE : EC_NOT_INITIALIZED;
+    }
+
+    void *map = mmap(NULL, sizeof(AD525xSetpointTable), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (map == MAP_FAILED) { return EC_STORAGE; }
+
+    mapped = true;
+    AD525xSetpointTable *t = (AD525xSetpointTable *)map;
+    table = t;
+
+    uint8_t rv = create ? attach(t) : check(t);
+    if (rv) { close(); }
+
+    return rv;
+}
+
+void AD525xSetpoints::close() {
+    /** Unmap a table mapped by `open()`. The shared memory object itself is left in place. */
+    if (mapped && table != NULL) { munmap(table, sizeof(AD525xSetpointTable)); }
+
+    mapped = false;
+    table = NULL;
+}
+#endif
+
+uint8_t AD525xSetpoints::set(uint8_t device, uint8_t RDAC, uint8_t value) {
+    /** Post a desired wiper value. Lock-free and safe from any number of writers.
+
+    The value and a version counter share one 32-bit word updated with compare-and-swap, so the
+    owner can never see a torn update and always sees that the slot changed, even if the same value
+    is posted twice in a row.
+
+    @return Returns 0 on no error, `EC_NOT_INITIALIZED` if no table is attached, or
+            `EC_BAD_DEVICE_ADDR` / `EC_BAD_REGISTER` for an out of range slot.
+    */
+    if (table == NULL) { return EC_NOT_INITIALIZED; }
+    if (device >= AD525X_SETPOINT_MAX_DEVICES) { return EC_BAD_DEVICE_ADDR; }
+    if (RDAC > 3) { return EC_BAD_REGISTER; }
+
+    uint32_t *slot = &table->desired[device][RDAC];
+    uint32_t old = __atomic_load_n(slot, __ATOMIC_RELAXED);
+    uint32_t next;
+
+    do {
+        uint32_t version = (old >> 8) + 1;
+        if ((version & 0xFFFFFF) == 0) { version = 1; }     // 0 means "never set".
+        next = (version << 8) | value;
+    } while (!__atomic_compare_exchange_n(slot, &old, next, true, __ATOMIC_RELEASE,
+                                          __ATOMIC_RELAXED));
+
+    return EC_NO_ERR;
+}
+
+uint8_t AD525xSetpoints::snapshot(uint8_t hw[][4], uint8_t *known) {
+    /** Copy a consistent snapshot of the hardware wiper state published by the bus owner.
+
+    This is a seqlock read: no system call and no lock, and it retries only if the owner published
+    during the copy. It gives up after `AD525X_SETPOINT_TRIES` attempts.
+
+    @param[out] hw    Array of `AD525X_SETPOINT_MAX_DEVICES` rows of four wiper values.
+    @param[out] known Array of `AD525X_SETPOINT_MAX_DEVICES` bit masks of valid entries in `hw`.
+
+    @return Returns 0 on no error, `EC_NOT_INITIALIZED` if no table is attached, or `EC_STORAGE` if
+            no consistent copy could be taken.
+    */
+    if (table == NULL) { return EC_NOT_INITIALIZED; }
+
+    for (uint32_t n = 0; ; n++) {
+        // A bus owner that died while publishing leaves the sequence odd for good.
+        if (n >= AD525X_SETPOINT_TRIES) { return EC_STORAGE; }
+
+        uint32_t s1 = __atomic_load_n(&table->hw_seq, __ATOMIC_ACQUIRE);
+        if (s1 & 1) { continue; }
+
+        for (uint8_t d = 0; d < AD525X_SETPOINT_MAX_DEVICES; d++) {
+            for (uint8_t r = 0; r < 4; r++) {
+                hw[d][r] = __atomic_load_n(&table->hw[d][r], __ATOMIC_RELAXED);
+            }
+            known[d] = __atomic_load_n(&table->hw_known[d], __ATOMIC_RELAXED);
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&table->hw_seq, __ATOMIC_RELAXED) == s1) { break; }
+    }
+
+    return EC_NO_ERR;
+}
+
+uint8_t AD525xSetpoints::add_device(AD525x &pot, uint8_t *index) {
+    /** Bus owner: bind the next table row to `pot`.
+
+    @param[in]  pot   An initialized device owned by this process.
+    @param[out] index If not NULL, receives the row index clients use for `pot`.
+
+    @return Returns 0 on no error, or `EC_NO_RESOURCES` if every row is bound.
+    */
+    if (n_devices >= AD525X_SETPOINT_MAX_DEVICES) { return EC_NO_RESOURCES; }
+
+    if (index != NULL) { *index = n_devices; }
+
+    for (uint8_t r = 0; r < 4; r++) {
+        seen[n_devices][r] = 0;
+    }
+    device[n_devices++] = &pot;
+
+    return EC_NO_ERR;
+}
+
+uint8_t AD525xSetpoints::sync() {
+    /** Bus owner: push every slot whose version changed since the last push, then publish the
+    hardware state for `snapshot()`.
+
+    Unchanged slots cost one atomic load each and no bus traffic. Changed slots are written with
+    `AD525x::move_RDAC()`; a failed write is retried on the next call.
+
+    @return Returns 0 on no error, otherwise the error code of the last failed write, or
+            `EC_NOT_INITIALIZED` if no table is attached.
+    */
+    if (table == NULL) { return EC_NOT_INITIALIZED; }
+
+    uint8_t rv = EC_NO_ERR;
+
+    for (uint8_t d = 0; d < n_devices; d++) {
+        for (uint8_t r = 0; r < 4; r++) {
+            uint32_t w = __atomic_load_n(&table->desired[d][r], __ATOMIC_ACQUIRE);
+            uint32_t version = w >> 8;
+
+            if (version == 0 || version == seen[d][r]) { continue; }
+
+            if (device[d]->move_RDAC(r, w & 0xFF)) {
+                rv = device[d]->get_err_code();
+            } else {
+                seen[d][r] = version;
+                pushed++;
+            }
+        }
+    }
+
+    publish();
+    return rv;
+}
+
+uint32_t AD525xSetpoints::get_pushed() {
+    /** Bus owner: retrieve the number of wiper updates pushed to the devices. */
+    return pushed;
+}
+
+//
+// Private functions
+//
+uint8_t AD525xSetpoints::check(AD525xSetpointTable *table) {
+    /** Returns 0 for an initialized table of this layout, `EC_NOT_INITIALIZED` for one that is
+    still zero or being initialized, or `EC_BAD_CHECKSUM` for anything else. */
+    uint32_t magic = __atomic_load_n(&table->magic, __ATOMIC_ACQUIRE);
+
+    if (magic == 0 || magic == initializing) { return EC_NOT_INITIALIZED; }
+    if (magic != AD525X_SETPOINT_MAGIC || table->size != sizeof(*table)) { return EC_BAD_CHECKSUM; }
+
+    return EC_NO_ERR;
+}
+
+void AD525xSetpoints::publish() {
+    /** Write the cached hardware state of the owned devices under the seqlock. An owner that died
+    mid-publish leaves the counter odd; rounding up to even first keeps odd meaning "writing". */
+    uint32_t s = (__atomic_load_n(&table->hw_seq, __ATOMIC_RELAXED) + 1) & ~1UL;
+
+    __atomic_store_n(&table->hw_seq, s + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    for (uint8_t d = 0; d < n_devices; d++) {
+        uint8_t known = 0;
+
+        for (uint8_t r = 0; r < 4; r++) {
+            if (!device[d]->is_cached(r)) { continue; }
+
+            __atomic_store_n(&table->hw[d][r], device[d]->read_RDAC_cached(r), __ATOMIC_RELAXED);
+            known |= (1 << r);
+        }
+
+        __atomic_store_n(&table->hw_known[d], known, __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&table->hw_seq, s + 2, __ATOMIC_RELEASE);
+}
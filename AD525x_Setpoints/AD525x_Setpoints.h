@@ -0,0 +1,73 @@
+/** @file
+Header file for a lock-free setpoint table, shared between processes (or threads), in which
+clients post desired wiper values and a single bus owner pushes changes to the devices.
+*/
+#ifndef AD525X_SETPOINTS_H
+#define AD525X_SETPOINTS_H
+
+#include <AD525x.h>
+#include <cstdint>
+
+#ifndef AD525X_SETPOINT_MAX_DEVICES
+#define AD525X_SETPOINT_MAX_DEVICES 16  /*!< Devices in one setpoint table. */
+#endif
+
+#ifndef AD525X_SETPOINT_TRIES
+#define AD525X_SETPOINT_TRIES 100000UL  /*!< Spins before a reader gives up on a stuck writer. */
+#endif
+
+/** Marks an initialized table. Encodes the layout version and the row count, so processes built
+with a different `AD525X_SETPOINT_MAX_DEVICES` do not share a table. */
+#define AD525X_SETPOINT_MAGIC (0xAD525000UL | (AD525X_SETPOINT_MAX_DEVICES & 0xFFF))
+
+/** The shared region. Plain data only, so it can live in shared memory mapped at any address.
+Must be zero-filled before the first `attach()`, as new shared memory is. */
+struct AD525xSetpointTable {
+    uint32_t magic;
+    uint32_t size;                                      /*!< `sizeof(AD525xSetpointTable)`. */
+    uint32_t desired[AD525X_SETPOINT_MAX_DEVICES][4];   /*!< `(version << 8) | value` per wiper. */
+    uint32_t hw_seq;                                    /*!< Seqlock over `hw` and `hw_known`; odd
+                                                             while the owner is updating. */
+    uint8_t hw[AD525X_SETPOINT_MAX_DEVICES][4];         /*!< Wiper values on the hardware. */
+    uint8_t hw_known[AD525X_SETPOINT_MAX_DEVICES];      /*!< Bit mask of valid entries in `hw`. */
+};
+
+class AD525xSetpoints {
+public:
+    AD525xSetpoints();
+    ~AD525xSetpoints();
+
+    uint8_t attach(AD525xSetpointTable *table);
+#if defined(__linux__)
+    uint8_t open(const char *name, bool create);
+    void close(void);
+#endif
+
+    // Client side
+    uint8_t set(uint8_t device, uint8_t RDAC, uint8_t value);
+    uint8_t snapshot(uint8_t hw[][4], uint8_t *known);
+
+    // Bus owner side
+    uint8_t add_device(AD525x &pot, uint8_t *index = NULL);
+    uint8_t sync(void);
+    uint32_t get_pushed(void);
+
+private:
+    void publish(void);
+    static uint8_t check(AD525xSetpointTable *table);
+
+    static const uint32_t initializing = (uint32_t)~AD525X_SETPOINT_MAGIC;  /*!< Magic while zeroing. */
+
+    AD525xSetpointTable *table;
+#if defined(__linux__)
+    bool mapped;                    /*!< True if `table` was mapped by `open()`. */
+#endif
+
+    AD525x *device[AD525X_SETPOINT_MAX_DEVICES];        /*!< Owner only. */
+    uint32_t seen[AD525X_SETPOINT_MAX_DEVICES][4];      /*!< Owner only: last version pushed. */
+    uint8_t n_devices;
+
+    uint32_t pushed;                /*!< Wiper updates pushed to the bus. */
+};
+
+#endif
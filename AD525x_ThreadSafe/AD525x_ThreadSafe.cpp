@@ -0,0 +1,202 @@
+/** @file
+Class file for a thread-safe front end to AD525x: bus transactions are serialized per bus, errors
+are returned per call, and cached wiper reads are served lock-free.
+*/
+
+#include <AD525x_ThreadSafe.h>
+#include <AD525x_Errors.h>
+
+//
+// AD525xBusLock
+//
+AD525xBusLock::AD525xBusLock() {
+#if defined(__linux__)
+    pthread_mutex_init(&mutex, NULL);
+#endif
+}
+
+AD525xBusLock::~AD525xBusLock() {
+#if defined(__linux__)
+    pthread_mutex_destroy(&mutex);
+#endif
+}
+
+void AD525xBusLock::lock() {
+    /** Take exclusive use of the bus. */
+#if defined(__linux__)
+    pthread_mutex_lock(&mutex);
+#endif
+}
+
+void AD525xBusLock::unlock() {
+    /** Release the bus. */
+#if defined(__linux__)
+    pthread_mutex_unlock(&mutex);
+#endif
+}
+
+//
+// AD525xShared
+//
+AD525xShared::AD525xShared(AD525x &pot, AD525xBusLock &bus) : pot(&pot), bus(&bus) {
+    /** Wrap an initialized device. Every device on the same I2C bus must share one `bus` lock, and
+    once wrapped, `pot` must only be used through this object.
+    */
+    for (uint8_t r = 0; r < 4; r++) {
+        mirror[r] = 0;
+    }
+
+    bus.lock();
+    publish();
+    bus.unlock();
+}
+
+uint8_t AD525xShared::write_RDAC(uint8_t RDAC, uint8_t value) {
+    /** Locked `AD525x::write_RDAC()`. @return Returns 0 on no error or the error code. */
+    bus->lock();
+    uint8_t rv = pot->write_RDAC(RDAC, value);
+    publish();
+    bus->unlock();
+
+    return rv;
+}
+
+uint8_t AD525xShared::move_RDAC(uint8_t RDAC, uint8_t value) {
+    /** Locked `AD525x::move_RDAC()`. @return Returns 0 on no error or the error code. */
+    bus->lock();
+    uint8_t rv = pot->move_RDAC(RDAC, value);
+    publish();
+    bus->unlock();
+
+    return rv;
+}
+
+uint8_t AD525xShared::read_RDAC(uint8_t RDAC, uint8_t *value) {
+    /** Locked `AD525x::read_RDAC()`, always from the device.
+
+    @param[in]  RDAC  The address of one of the 4 RDAC registers (0-3).
+    @param[out] value Receives the wiper value; left unchanged on error.
+
+    @return Returns 0 on no error or the error code.
+    */
+    bus->lock();
+    AD525xResult r = pot->read_RDAC_result(RDAC);
+    publish();
+    bus->unlock();
+
+    if (r.ok()) { *value = r.value; }
+    return r.err;
+}
+
+uint8_t AD525xShared::increment_RDAC(uint8_t RDAC) {
+    /** Locked `AD525x::increment_RDAC()`. @return Returns 0 on no error or the error code. */
+    bus->lock();
+    uint8_t rv = pot->increment_RDAC(RDAC);
+    publish();
+    bus->unlock();
+
+    return rv;
+}
+
+uint8_t AD525xShared::decrement_RDAC(uint8_t RDAC) {
+    /** Locked `AD525x::decrement_RDAC()`. @return Returns 0 on no error or the error code. */
+    bus->lock();
+    uint8_t rv = pot->decrement_RDAC(RDAC);
+    publish();
+    bus->unlock();
+
+    return rv;
+}
+
+uint8_t AD525xShared::restore_RDAC(uint8_t RDAC) {
+    /** Locked `AD525x::restore_RDAC()`. @return Returns 0 on no error or the error code. */
+    bus->lock();
+    uint8_t rv = pot->restore_RDAC(RDAC);
+    publish();
+    bus->unlock();
+
+    return rv;
+}
+
+uint8_t AD525xShared::store_RDAC(uint8_t RDAC) {
+    /** Locked `AD525x::store_RDAC()`. @return Returns 0 on no error or the error code. */
+    bus->lock();
+    uint8_t rv = pot->store_RDAC(RDAC);
+    bus->unlock();
+
+    return rv;
+}
+
+uint8_t AD525xShared::write_EEMEM(uint8_t reg, uint8_t value) {
+    /** Locked `AD525x::write_EEMEM()`. @return Returns 0 on no error or the error code. */
+    bus->lock();
+    uint8_t rv = pot->write_EEMEM(reg, value);
+    bus->unlock();
+
+    return rv;
+}
+
+uint8_t AD525xShared::read_EEMEM(uint8_t reg, uint8_t *value) {
+    /** Locked `AD525x::read_EEMEM()`.
+
+    @param[in]  reg   The EEMEM register (0-15).
+    @param[out] value Receives the register value; left unchanged on error.
+
+    @return Returns 0 on no error or the error code.
+    */
+    bus->lock();
+    AD525xResult r = pot->read_EEMEM_result(reg);
+    bus->unlock();
+
+    if (r.ok()) { *value = r.value; }
+    return r.err;
+}
+
+uint8_t AD525xShared::read_tolerance(uint8_t RDAC, float *tolerance) {
+    /** Locked `AD525x::read_tolerance()`.
+
+    @param[in]  RDAC      The address of one of the 4 RDAC registers (0-3).
+    @param[out] tolerance Receives the tolerance in percent; left unchanged on error.
+
+    @return Returns 0 on no error or the error code.
+    */
+    bus->lock();
+    AD525xToleranceResult r = pot->read_tolerance_result(RDAC);
+    bus->unlock();
+
+    if (r.ok()) { *tolerance = r.value; }
+    return r.err;
+}
+
+uint8_t AD525xShared::read_cached(uint8_t RDAC, uint8_t *value) {
+    /** Read a wiper value, lock-free when it is cached.
+
+    A known wiper is served with a single atomic load and never waits for the bus. An unknown one
+    (e.g. after a restore) falls back to `read_RDAC()`, which takes the bus lock.
+
+    @param[in]  RDAC  The address of one of the 4 RDAC registers (0-3).
+    @param[out] value Receives the wiper value; left unchanged on error.
+
+    @return Returns 0 on no error or the error code.
+    */
+    if (RDAC > 3) { return EC_BAD_REGISTER; }
+
+    uint16_t m = __atomic_load_n(&mirror[RDAC], __ATOMIC_ACQUIRE);
+    if (m & 0x100) {
+        *value = m & 0xFF;
+        return EC_NO_ERR;
+    }
+
+    return read_RDAC(RDAC, value);
+}
+
+//
+// Private functions
+//
+void AD525xShared::publish() {
+    /** Copy the device's wiper cache into `mirror`. Call with the bus lock held. */
+    for (uint8_t r = 0; r < 4; r++) {
+        uint16_t m = pot->is_cached(r) ? (0x100 | pot->read_RDAC_cached(r)) : 0;
+        __atomic_store_n(&mirror[r], m, __ATOMIC_RELEASE);
+    }
+}
@@ -0,0 +1,60 @@
+/** @file
+Header file for a thread-safe front end to AD525x: bus transactions are serialized per bus, errors
+are returned per call, and cached wiper reads are served lock-free.
+*/
+#ifndef AD525X_THREADSAFE_H
+#define AD525X_THREADSAFE_H
+
+#include <AD525x.h>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <pthread.h>
+#endif
+
+class AD525xBusLock {
+// One per I2C bus, shared by every AD525xShared on that bus. A no-op where there are no threads.
+public:
+    AD525xBusLock();
+    ~AD525xBusLock();
+
+    void lock(void);
+    void unlock(void);
+
+private:
+#if defined(__linux__)
+    pthread_mutex_t mutex;
+#endif
+};
+
+class AD525xShared {
+public:
+    AD525xShared(AD525x &pot, AD525xBusLock &bus);
+
+    // Bus operations. Each takes the bus lock and returns its own error code.
+    uint8_t write_RDAC(uint8_t RDAC, uint8_t value);
+    uint8_t move_RDAC(uint8_t RDAC, uint8_t value);
+    uint8_t read_RDAC(uint8_t RDAC, uint8_t *value);
+    uint8_t increment_RDAC(uint8_t RDAC);
+    uint8_t decrement_RDAC(uint8_t RDAC);
+    uint8_t restore_RDAC(uint8_t RDAC);
+    uint8_t store_RDAC(uint8_t RDAC);
+
+    uint8_t write_EEMEM(uint8_t reg, uint8_t value);
+    uint8_t read_EEMEM(uint8_t reg, uint8_t *value);
+    uint8_t read_tolerance(uint8_t RDAC, float *tolerance);
+
+    // Lock-free
+    uint8_t read_cached(uint8_t RDAC, uint8_t *value);
+
+private:
+    void publish(void);
+
+    AD525x *pot;
+    AD525xBusLock *bus;
+
+    uint16_t mirror[4];     /*!< Atomic copy of the wiper cache: `0x100 | value` when known, else
+                                 0. Written under the bus lock, read without it. */
+};
+
+#endif
@@ -0,0 +1,249 @@
+/** @file
+Class file for wear-aware EEMEM writes: coalescing of rapid writes, per-register write counters
+and endurance warnings.
+*/
+
+#include <AD525x_Wear.h>
+#include <AD525x_Errors.h>
+#include <Arduino.h>
+
+AD525xWearManager::AD525xWearManager(AD525x &pot, uint16_t coalesce_ms) :
+    pot(&pot), coalesce_ms(coalesce_ms), pending(0), pending_store(0), next_reg(0), stored_known(0),
+    suppressed(0), busy_until(0), busy(false), warn_threshold(AD525X_EEMEM_ENDURANCE * 8 / 10),
+    lifetime_days(0), warned(0), callback(NULL), context(NULL), err_code(0) {
+    /** Create a wear manager for `pot`.
+
+    @param[in] pot         The device whose EEMEM is managed. All EEMEM writes to it should go
+                           through this object so the counters stay accurate.
+    @param[in] coalesce_ms Delay between the first write request to a register and programming it.
+                           Later requests inside that window replace the value without costing a
+                           program cycle.
+    */
+    for (uint8_t i = 0; i < 16; i++) {
+        count[i] = session_count[i] = 0;
+    }
+
+    session_start = millis();
+}
+
+uint8_t AD525xWearManager::write_EEMEM(uint8_t reg, uint8_t value) {
+    /** Request that EEMEM register `reg` be programmed with `value`.
+
+    The register is programmed by `service()` once the coalescing delay has passed, with whatever
+    value was requested last. Requests for the value already in EEMEM are dropped.
+
+    @return Returns 0 on no error, `EC_BAD_REGISTER` if `reg` exceeds 15, or `EC_BAD_WIPER_SETTING`
+            if `reg` is an RDAC register (0-3) and `value` exceeds the maximum wiper setting. Bus
+            errors are reported by `service()`.
+    */
+    if (reg > 15) { return (err_code = EC_BAD_REGISTER); }
+    if (reg <= 3 && value > pot->get_max_val()) { return (err_code = EC_BAD_WIPER_SETTING); }
+
+    uint16_t bit = 1 << reg;
+
+    if (pending & bit) {
+        suppressed++;       // The earlier request will never be programmed.
+    } else if ((stored_known & bit) && stored[reg] == value) {
+        suppressed++;
+        return (err_code = EC_NO_ERR);
+    } else {
+        pending_since[reg] = millis();
+    }
+
+    pending |= bit;
+    pending_store &= ~bit;
+    pending_value[reg] = value;
+
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xWearManager::store_RDAC(uint8_t RDAC) {
+    /** Request that the wiper of `RDAC` be stored to its EEMEM register.
+
+    The wiper is sampled when the store is actually programmed, so moving the wiper several times
+    inside the coalescing window stores only its final position. See `write_EEMEM()`.
+
+    @return Returns 0 on no error, or `EC_BAD_REGISTER` if `RDAC` exceeds 3.
+    */
+    if (RDAC > 3) { return (err_code = EC_BAD_REGISTER); }
+
+    uint16_t bit = 1 << RDAC;
+
+    if (pending & bit) {
+        suppressed++;
+    } else {
+        pending_since[RDAC] = millis();
+    }
+
+    pending |= bit;
+    pending_store |= bit;
+
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xWearManager::service() {
+    /** Program at most one register whose coalescing delay has expired. Call this regularly, e.g.
+    from `loop()`. It never blocks; while the device is programming, it returns immediately.
+
+    @return Returns 0 on no error, otherwise the bus error. A failed register stays pending, and
+            the next call starts with the register after it, so registers are served in turn.
+    */
+    uint32_t now = millis();
+
+    if (busy) {
+        if ((int32_t)(now - busy_until) < 0) { return (err_code = EC_NO_ERR); }
+        busy = false;
+    }
+
+    for (uint8_t i = 0; i < 16; i++) {
+        uint8_t reg = (next_reg + i) & 0x0F;
+
+        if ((pending & (1 << reg)) && now - pending_since[reg] >= coalesce_ms) {
+            next_reg = (reg + 1) & 0x0F;
+            return program(reg);
+        }
+    }
+
+    return (err_code = EC_NO_ERR);
+}
+
+uint8_t AD525xWearManager::flush() {
+    /** Program every pending register now, waiting out the programming time of each. Use before
+    power-down.
+
+    @return Returns 0 on no error, otherwise the last bus error.
+    */
+    uint8_t rv = EC_NO_ERR;
+
+    if (busy) {
+        int32_t remaining = (int32_t)(busy_until - millis());
+        if (remaining > 0) { delay(remaining); }
+        busy = false;
+    }
+
+    for (uint8_t reg = 0; reg < 16; reg++) {
+        if (!(pending & (1 << reg))) { continue; }
+
+        if (program(reg)) { rv = err_code; }
+
+        if (busy) {
+            delay(AD525X_EEMEM_WRITE_MS);
+            busy = false;
+        }
+    }
+
+    return (err_code = rv);
+}
+
+void AD525xWearManager::set_counters(const uint32_t *counts) {
+    /** Restore 16 per-register program counts saved by the host, e.g. from the MCU's own EEPROM or
+    a file. */
+    for (uint8_t i = 0; i < 16; i++) {
+        count[i] = counts[i];
+    }
+}
+
+void AD525xWearManager::get_counters(uint32_t *counts) {
+    /** Copy the 16 per-register program counts out for the host to persist. */
+    for (uint8_t i = 0; i < 16; i++) {
+        counts[i] = count[i];
+    }
+}
+
+void AD525xWearManager::set_warning(uint32_t threshold, uint16_t lifetime_days,
+                                    AD525xWearCallback callback, void *context) {
+    /** Configure endurance warnings.
+
+    @param[in] threshold     Warn when a register reaches this many program cycles.
+    @param[in] lifetime_days Also warn if, at the program rate seen since construction, a register
+                             would exceed `AD525X_EEMEM_ENDURANCE` within this many days. 0 disables
+                             the projection.
+    @param[in] callback      Called once per register when it becomes at risk. May be NULL.
+    @param[in] context       Opaque pointer passed to `callback`.
+    */
+    warn_threshold = threshold;
+    this->lifetime_days = lifetime_days;
+    this->callback = callback;
+    this->context = context;
+    warned = 0;
+}
+
+uint32_t AD525xWearManager::get_write_count(uint8_t reg) {
+    /** Retrieve the number of program cycles of register `reg`. */
+    return (reg > 15) ? 0 : count[reg];
+}
+
+uint32_t AD525xWearManager::get_suppressed() {
+    /** Retrieve the number of requests that never needed a program cycle. */
+    return suppressed;
+}
+
+bool AD525xWearManager::at_risk(uint8_t reg) {
+    /** True if register `reg` has crossed the warning threshold or is projected to wear out within
+    the configured lifetime. */
+    if (reg > 15) { return false; }
+    if (count[reg] >= warn_threshold) { return true; }
+
+    uint32_t elapsed = millis() - session_start;
+    if (lifetime_days == 0 || session_count[reg] < 2 || elapsed < 60000UL) { return false; }
+
+    float projected = count[reg] + float(session_count[reg]) / elapsed * 86400000.0 * lifetime_days;
+    return projected > AD525X_EEMEM_ENDURANCE;
+}
+
+uint8_t AD525xWearManager::get_err_code() {
+    /** Retrieve the error code of the last operation. See `AD525x_Errors.h`. */
+    return err_code;
+}
+
+//
+// Private functions
+//
+uint8_t AD525xWearManager::program(uint8_t reg) {
+    /** Program the pending request of `reg`, unless EEMEM already holds the value. */
+    uint16_t bit = 1 << reg;
+    uint8_t value = pending_value[reg];
+
+    if (pending_store & bit) {
+        value = pot->read_RDAC_cached(reg);
+        if ((err_code = pot->get_err_code())) { return err_code; }
+    }
+
+    if ((stored_known & bit) && stored[reg] == value) {
+        pending &= ~bit;
+        suppressed++;
+        return (err_code = EC_NO_ERR);
+    }
+
+    if (pending_store & bit) {
+        err_code = pot->store_RDAC(reg);
+    } else {
+        err_code = pot->write_EEMEM(reg, value);
+    }
+
+    if (err_code) {
+        stored_known &= ~bit;
+        return err_code;
+    }
+
+    pending &= ~bit;
+    stored[reg] = value;
+    stored_known |= bit;
+
+    count[reg]++;
+    session_count[reg]++;
+    check_wear(reg);
+
+    busy = true;
+    busy_until = millis() + AD525X_EEMEM_WRITE_MS;
+
+    return err_code;
+}
+
+void AD525xWearManager::check_wear(uint8_t reg) {
+    /** Report `reg` to the warning callback the first time it becomes at risk. */
+    if ((warned & (1 << reg)) || !at_risk(reg)) { return; }
+
+    warned |= (1 << reg);
+    if (callback != NULL) { callback(reg, count[reg], context); }
+}
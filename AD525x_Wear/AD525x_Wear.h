@@ -0,0 +1,71 @@
+/** @file
+Header file for wear-aware EEMEM writes: coalescing of rapid writes, per-register write counters
+and endurance warnings.
+*/
+#ifndef AD525X_WEAR_H
+#define AD525X_WEAR_H
+
+#include <AD525x.h>
+#include <cstdint>
+
+#define AD525X_EEMEM_ENDURANCE 100000UL     /*!< Rated EEMEM program cycles per register. */
+
+/** Called when a register crosses the warning threshold or is projected to wear out early. */
+typedef void (*AD525xWearCallback)(uint8_t reg, uint32_t count, void *context);
+
+class AD525xWearManager {
+public:
+    AD525xWearManager(AD525x &pot, uint16_t coalesce_ms = 1000);
+
+    uint8_t write_EEMEM(uint8_t reg, uint8_t value);
+    uint8_t store_RDAC(uint8_t RDAC);
+
+    uint8_t service(void);
+    uint8_t flush(void);
+
+    void set_counters(const uint32_t *counts);
+    void get_counters(uint32_t *counts);
+    void set_warning(uint32_t threshold, uint16_t lifetime_days, AD525xWearCallback callback,
+                     void *context = NULL);
+
+    uint32_t get_write_count(uint8_t reg);
+    uint32_t get_suppressed(void);
+    bool at_risk(uint8_t reg);
+
+    uint8_t get_err_code(void);
+
+private:
+    uint8_t program(uint8_t reg);
+    void check_wear(uint8_t reg);
+
+    AD525x *pot;
+    uint16_t coalesce_ms;           /*!< Delay from the first request to programming. */
+
+    uint8_t pending_value[16];      /*!< Latest requested value per register. */
+    uint16_t pending;               /*!< Registers with a request waiting to be programmed. */
+    uint16_t pending_store;         /*!< Pending requests that are `store_RDAC()` (registers 0-3). */
+    uint32_t pending_since[16];     /*!< `millis()` of the first request in each pending burst. */
+    uint8_t next_reg;               /*!< Register `service()` tries first, so one failing register
+                                         cannot starve the others. */
+
+    uint8_t stored[16];             /*!< Values known to be in EEMEM. */
+    uint16_t stored_known;          /*!< Bit mask of valid entries in `stored`. */
+
+    uint32_t count[16];             /*!< Program cycles per register, including earlier sessions. */
+    uint32_t session_count[16];     /*!< Program cycles since construction. */
+    uint32_t session_start;         /*!< `millis()` at construction. */
+    uint32_t suppressed;            /*!< Requests that never needed programming. */
+
+    uint32_t busy_until;            /*!< `millis()` at which the last programming completes. */
+    bool busy;
+
+    uint32_t warn_threshold;        /*!< Cycle count that triggers a warning. */
+    uint16_t lifetime_days;         /*!< Required service life, 0 to disable projection. */
+    uint16_t warned;                /*!< Registers already reported to the callback. */
+    AD525xWearCallback callback;
+    void *context;
+
+    uint8_t err_code;
+};
+
+#endif
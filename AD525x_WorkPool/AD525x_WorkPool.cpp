@@ -0,0 +1,324 @@
+/** @file
+Class file for a work-stealing thread pool for CPU-side work (transition planning, calibration
+tables, waveform decoding) in large device fleets on Linux.
+*/
+
+#include <AD525x_WorkPool.h>
+
+#if defined(__linux__)
+
+#include <AD525x_Errors.h>
+
+static thread_local AD525xWorkPool *current_pool = NULL;   // Pool of the calling worker, if any.
+static thread_local uint8_t current_index = 0;
+
+AD525xWorkPool::AD525xWorkPool() :
+    n_workers(0), running(false), queued(0), outstanding(0), next(0), executed(0), stolen(0) {
+    /** Create a stopped pool. Call `start()` to launch the workers. */
+    pthread_mutex_init(&sleep_lock, NULL);
+    pthread_cond_init(&wake, NULL);
+    pthread_cond_init(&idle, NULL);
+
+    for (uint8_t i = 0; i < AD525X_POOL_MAX_WORKERS; i++) {
+        pthread_mutex_init(&worker[i].lock, NULL);
+    }
+}
+
+AD525xWorkPool::~AD525xWorkPool() {
+    stop();
+
+    for (uint8_t i = 0; i < AD525X_POOL_MAX_WORKERS; i++) {
+        pthread_mutex_destroy(&worker[i].lock);
+    }
+
+    pthread_cond_destroy(&idle);
+    pthread_cond_destroy(&wake);
+    pthread_mutex_destroy(&sleep_lock);
+}
+
+uint8_t AD525xWorkPool::start(uint8_t n_workers) {
+    /** Launch `n_workers` threads, typically one per core left over after the bus threads.
+
+    @return Returns 0 on no error, `EC_BAD_REGISTER` if `n_workers` is 0 or exceeds
+            `AD525X_POOL_MAX_WORKERS`, or `EC_NO_RESOURCES` if a thread could not be created.
+    */
+    stop();
+
+    if (n_workers == 0 || n_workers > AD525X_POOL_MAX_WORKERS) { return EC_BAD_REGISTER; }
+
+    __atomic_store_n(&running, true, __ATOMIC_RELEASE);
+
+    for (uint8_t i = 0; i < n_workers; i++) {
+        Worker &w = worker[i];
+        w.pool = this;
+        w.index = i;
+        w.head = 0;
+        w.count = 0;
+        w.high_water = 0;
+        w.pinned_head = 0;
+        w.pinned_count = 0;
+
+        if (pthread_create(&w.thread, NULL, worker_main, &w) != 0) {
+            __atomic_store_n(&this->n_workers, i, __ATOMIC_RELEASE);   // Join the ones created.
+            stop();
+            return EC_NO_RESOURCES;
+        }
+    }
+
+    // Publish the count once every worker exists. Until then nothing can be submitted and no
+    // worker steals, so no thread indexes a worker that is still being set up.
+    __atomic_store_n(&this->n_workers, n_workers, __ATOMIC_RELEASE);
+
+    return EC_NO_ERR;
+}
+
+void AD525xWorkPool::stop() {
+    /** Stop and join the workers once they finish the job in hand. Queued jobs are dropped; call
+    `wait_idle()` first to finish them. */
+    pthread_mutex_lock(&sleep_lock);
+    __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&wake);
+    pthread_mutex_unlock(&sleep_lock);
+
+    uint8_t n = __atomic_load_n(&n_workers, __ATOMIC_ACQUIRE);
+    for (uint8_t i = 0; i < n; i++) {
+        pthread_join(worker[i].thread, NULL);
+    }
+
+    __atomic_store_n(&n_workers, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&queued, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&outstanding, 0, __ATOMIC_RELAXED);
+}
+
+uint8_t AD525xWorkPool::submit(AD525xJob job, void *arg) {
+    /** Queue `job(arg)`.
+
+    From a worker thread the job goes to that worker's own deque (newest first, for cache warmth);
+    from any other thread the workers are used in turn. Idle workers steal the oldest jobs of busy
+    ones, so uneven jobs still spread across all cores.
+
+    @return Returns 0 on no error, `EC_NOT_INITIALIZED` if the pool is not started, or
+            `EC_NO_RESOURCES` if the target deque is full.
+    */
+    uint8_t n = __atomic_load_n(&n_workers, __ATOMIC_ACQUIRE);
+    if (n == 0) { return EC_NOT_INITIALIZED; }
+
+    uint8_t target;
+    if (current_pool == this) {
+        target = current_index;
+    } else {
+        target = __atomic_fetch_add(&next, 1, __ATOMIC_RELAXED) % n;
+    }
+
+    Worker &w = worker[target];
+
+    pthread_mutex_lock(&w.lock);
+    if (w.count >= AD525X_POOL_QUEUE_LEN) {
+        pthread_mutex_unlock(&w.lock);
+        return EC_NO_RESOURCES;
+    }
+
+    Item &item = w.items[(w.head + w.count) % AD525X_POOL_QUEUE_LEN];
+    item.job = job;
+    item.arg = arg;
+    __atomic_store_n(&w.count, w.count + 1, __ATOMIC_RELAXED);    // Thieves pre-check it unlocked.
+    if (w.count > w.high_water) { w.high_water = w.count; }
+
+    __atomic_fetch_add(&outstanding, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&queued, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&w.lock);
+
+    pthread_mutex_lock(&sleep_lock);
+    pthread_cond_signal(&wake);
+    pthread_mutex_unlock(&sleep_lock);
+
+    return EC_NO_ERR;
+}
+
+uint8_t AD525xWorkPool::submit_to(uint8_t worker, AD525xJob job, void *arg) {
+    /** Queue `job(arg)` to run on worker `worker` only, after every job pinned to it before.
+
+    Use this for bus I/O: give each bus its own worker and pin that bus's transactions to it. They
+    then run in order, one at a time, with no bus lock, while CPU work is stolen around them. A
+    pinned job is run before the worker's other jobs, so it waits at most for the job in hand.
+
+    @return Returns 0 on no error, `EC_NOT_INITIALIZED` if the pool is not started,
+            `EC_BAD_REGISTER` if there is no such worker, or `EC_NO_RESOURCES` if the worker
+            already holds `AD525X_POOL_PINNED_LEN` pinned jobs.
+    */
+    uint8_t n = __atomic_load_n(&n_workers, __ATOMIC_ACQUIRE);
+    if (n == 0) { return EC_NOT_INITIALIZED; }
+    if (worker >= n) { return EC_BAD_REGISTER; }
+
+    Worker &w = this->worker[worker];
+
+    pthread_mutex_lock(&w.lock);
+    if (w.pinned_count >= AD525X_POOL_PINNED_LEN) {
+        pthread_mutex_unlock(&w.lock);
+        return EC_NO_RESOURCES;
+    }
+
+    Item &item = w.pinned[(w.pinned_head + w.pinned_count) % AD525X_POOL_PINNED_LEN];
+    item.job = job;
+    item.arg = arg;
+    __atomic_fetch_add(&outstanding, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&w.pinned_count, w.pinned_count + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&w.lock);
+
+    // Only this worker can run the job, so wake them all rather than one that may not be it.
+    pthread_mutex_lock(&sleep_lock);
+    pthread_cond_broadcast(&wake);
+    pthread_mutex_unlock(&sleep_lock);
+
+    return EC_NO_ERR;
+}
+
+void AD525xWorkPool::wait_idle() {
+    /** Block until every submitted job, including jobs submitted by jobs, has finished. Must not
+    be called from a worker. */
+    pthread_mutex_lock(&sleep_lock);
+    while (__atomic_load_n(&outstanding, __ATOMIC_ACQUIRE) > 0) {
+        pthread_cond_wait(&idle, &sleep_lock);
+    }
+    pthread_mutex_unlock(&sleep_lock);
+}
+
+uint8_t AD525xWorkPool::get_workers() {
+    /** Retrieve the number of running worker threads. */
+    return __atomic_load_n(&n_workers, __ATOMIC_ACQUIRE);
+}
+
+uint32_t AD525xWorkPool::get_executed() {
+    /** Retrieve the number of jobs run. */
+    return __atomic_load_n(&executed, __ATOMIC_RELAXED);
+}
+
+uint32_t AD525xWorkPool::get_stolen() {
+    /** Retrieve the number of jobs run by a worker other than the one they were queued to. */
+    return __atomic_load_n(&stolen, __ATOMIC_RELAXED);
+}
+
+uint16_t AD525xWorkPool::get_high_water() {
+    /** Retrieve the deepest any worker's deque has been since `start()`. Use this to size
+    `AD525X_POOL_QUEUE_LEN`. */
+    uint16_t hw = 0;
+    uint8_t n = __atomic_load_n(&n_workers, __ATOMIC_ACQUIRE);
+
+    for (uint8_t i = 0; i < n; i++) {
+        pthread_mutex_lock(&worker[i].lock);
+        if (worker[i].high_water > hw) { hw = worker[i].high_water; }
+        pthread_mutex_unlock(&worker[i].lock);
+    }
+
+    return hw;
+}
+
+//
+// Private functions
+//
+void *AD525xWorkPool::worker_main(void *arg) {
+    Worker *w = (Worker *)arg;
+
+    current_pool = w->pool;
+    current_index = w->index;
+    w->pool->run(*w);
+
+    return NULL;
+}
+
+void AD525xWorkPool::run(Worker &w) {
+    /** Worker loop: pinned jobs first, then the own deque, then steal, then sleep until a job is
+    queued. */
+    while (__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+        Item item;
+
+        if (pop_pinned(w, &item) || pop(w, &item) || steal(w.index, &item)) {
+            item.job(item.arg);
+            finish();
+            continue;
+        }
+
+        pthread_mutex_lock(&sleep_lock);
+        while (__atomic_load_n(&queued, __ATOMIC_ACQUIRE) == 0 &&
+               __atomic_load_n(&w.pinned_count, __ATOMIC_ACQUIRE) == 0 &&
+               __atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+            pthread_cond_wait(&wake, &sleep_lock);
+        }
+        pthread_mutex_unlock(&sleep_lock);
+    }
+}
+
+bool AD525xWorkPool::pop(Worker &w, Item *item) {
+    /** Take the newest job from the worker's own deque. */
+    pthread_mutex_lock(&w.lock);
+
+    bool found = w.count > 0;
+    if (found) {
+        __atomic_store_n(&w.count, w.count - 1, __ATOMIC_RELAXED);
+        *item = w.items[(w.head + w.count) % AD525X_POOL_QUEUE_LEN];
+        __atomic_fetch_sub(&queued, 1, __ATOMIC_RELAXED);
+    }
+
+    pthread_mutex_unlock(&w.lock);
+    return found;
+}
+
+bool AD525xWorkPool::pop_pinned(Worker &w, Item *item) {
+    /** Take the oldest job pinned to the worker. */
+    if (__atomic_load_n(&w.pinned_count, __ATOMIC_ACQUIRE) == 0) { return false; }  // Cheap pre-check.
+
+    pthread_mutex_lock(&w.lock);
+
+    bool found = w.pinned_count > 0;
+    if (found) {
+        *item = w.pinned[w.pinned_head];
+        w.pinned_head = (w.pinned_head + 1) % AD525X_POOL_PINNED_LEN;
+        __atomic_store_n(&w.pinned_count, w.pinned_count - 1, __ATOMIC_RELEASE);
+    }
+
+    pthread_mutex_unlock(&w.lock);
+    return found;
+}
+
+bool AD525xWorkPool::steal(uint8_t thief, Item *item) {
+    /** Take the oldest job from the first other worker that has one. Pinned jobs are left alone. */
+    uint8_t n = __atomic_load_n(&n_workers, __ATOMIC_ACQUIRE);
+
+    for (uint8_t k = 1; k < n; k++) {
+        Worker &v = worker[(thief + k) % n];
+
+        if (__atomic_load_n(&v.count, __ATOMIC_RELAXED) == 0) { continue; }     // Cheap pre-check.
+
+        pthread_mutex_lock(&v.lock);
+
+        bool found = v.count > 0;
+        if (found) {
+            *item = v.items[v.head];
+            v.head = (v.head + 1) % AD525X_POOL_QUEUE_LEN;
+            __atomic_store_n(&v.count, v.count - 1, __ATOMIC_RELAXED);
+            __atomic_fetch_sub(&queued, 1, __ATOMIC_RELAXED);
+        }
+
+        pthread_mutex_unlock(&v.lock);
+
+        if (found) {
+            __atomic_fetch_add(&stolen, 1, __ATOMIC_RELAXED);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void AD525xWorkPool::finish() {
+    /** Account for a finished job, waking `wait_idle()` after the last one. */
+    __atomic_fetch_add(&executed, 1, __ATOMIC_RELAXED);
+
+    if (__atomic_sub_fetch(&outstanding, 1, __ATOMIC_ACQ_REL) == 0) {
+        pthread_mutex_lock(&sleep_lock);
+        pthread_cond_broadcast(&idle);
+        pthread_mutex_unlock(&sleep_lock);
+    }
+}
+
+#endif
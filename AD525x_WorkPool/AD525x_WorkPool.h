@@ -0,0 +1,90 @@
+/** @file
+Header file for a work-stealing thread pool for CPU-side work (transition planning, calibration
+tables, waveform decoding) in large device fleets on Linux. Bus I/O can be pinned to one worker per
+bus with `submit_to()`, where it runs in order and is never stolen.
+*/
+#ifndef AD525X_WORKPOOL_H
+#define AD525X_WORKPOOL_H
+
+#if defined(__linux__)
+
+#include <cstdint>
+#include <pthread.h>
+
+#ifndef AD525X_POOL_MAX_WORKERS
+#define AD525X_POOL_MAX_WORKERS 16      /*!< Worker threads in one pool. */
+#endif
+
+#ifndef AD525X_POOL_QUEUE_LEN
+#define AD525X_POOL_QUEUE_LEN 256       /*!< Jobs queued per worker. */
+#endif
+
+#ifndef AD525X_POOL_PINNED_LEN
+#define AD525X_POOL_PINNED_LEN 32       /*!< Pinned jobs queued per worker. */
+#endif
+
+typedef void (*AD525xJob)(void *arg);
+
+class AD525xWorkPool {
+public:
+    AD525xWorkPool();
+    ~AD525xWorkPool();
+
+    uint8_t start(uint8_t n_workers);
+    void stop(void);
+
+    uint8_t submit(AD525xJob job, void *arg);
+    uint8_t submit_to(uint8_t worker, AD525xJob job, void *arg);
+    void wait_idle(void);
+
+    uint8_t get_workers(void);
+    uint32_t get_executed(void);
+    uint32_t get_stolen(void);
+    uint16_t get_high_water(void);
+
+private:
+    struct Item {
+        AD525xJob job;
+        void *arg;
+    };
+
+    struct Worker {
+        AD525xWorkPool *pool;
+        pthread_t thread;
+        pthread_mutex_t lock;           /*!< Guards the deque below. */
+        Item items[AD525X_POOL_QUEUE_LEN];
+        uint16_t head;                  /*!< Oldest job, taken by thieves. */
+        uint16_t count;                 /*!< The owner pushes and pops at `head + count`. */
+        uint16_t high_water;            /*!< Deepest this deque has been. */
+        Item pinned[AD525X_POOL_PINNED_LEN];    /*!< FIFO of jobs only this worker may run. */
+        uint8_t pinned_head;
+        uint8_t pinned_count;
+        uint8_t index;
+    };
+
+    static void *worker_main(void *arg);
+    void run(Worker &w);
+    bool pop(Worker &w, Item *item);
+    bool pop_pinned(Worker &w, Item *item);
+    void finish(void);
+    bool steal(uint8_t thief, Item *item);
+
+    Worker worker[AD525X_POOL_MAX_WORKERS];
+    uint8_t n_workers;                  /*!< Atomic; published once all workers exist. */
+    bool running;
+
+    pthread_mutex_t sleep_lock;
+    pthread_cond_t wake;                /*!< Signalled when a job is queued. */
+    pthread_cond_t idle;                /*!< Signalled when the last outstanding job finishes. */
+
+    uint32_t queued;                    /*!< Stealable jobs sitting in deques. Atomic. */
+    uint32_t outstanding;               /*!< Jobs submitted but not finished. Atomic. */
+    uint32_t next;                      /*!< Round-robin target for external submissions. Atomic. */
+
+    uint32_t executed;                  /*!< Atomic. */
+    uint32_t stolen;                    /*!< Jobs run by a worker other than the one queued to. */
+};
+
+#endif
+
+#endif
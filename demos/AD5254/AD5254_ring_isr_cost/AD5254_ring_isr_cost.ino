@@ -0,0 +1,66 @@
+/*
+Sketchbook demonstrating the ISR command ring of the AD525x_CommandRing.h library.
+
+An external interrupt on pin 2 posts a new setpoint on every edge, and the main loop drains the
+ring through the driver. At startup the cost of one push is measured and printed in CPU cycles.
+*/
+
+#include <Wire.h>
+#include <AD525x.h>
+#include <AD525x_CommandRing.h>
+
+AD5254 ad4;             // The potentiometer object, not initialized.
+AD525xCommandRing ring(ad4);
+
+byte RDAC = 0x00;      // RDAC <= 3
+byte AD_addr = 0b00;    // AD0 = 0, AD1 = 0
+
+volatile byte isr_val = 0;
+
+void on_edge() {
+  ring.push(RDAC, isr_val++);
+}
+
+void measure_push_cost() {
+  const unsigned int n = 1000;
+  unsigned long total = 0;
+
+  for (unsigned int i = 0; i < n; i++) {
+    unsigned long start = micros();
+    for (byte k = 0; k < AD525X_RING_LEN - 1; k++) {
+      ring.push(RDAC, k);
+    }
+    total += micros() - start;
+
+    ring.drain();
+  }
+
+  // Includes the loop overhead, so this is a slight overestimate. Each batch fills the ring
+  // without overflowing it.
+  Serial.print("Cycles per push: ");
+  Serial.println((float)total * clockCyclesPerMicrosecond() / ((float)n * (AD525X_RING_LEN - 1)));
+}
+
+void setup() {
+  Serial.begin(9600);
+
+  ad4.initialize(AD_addr);
+  ad4.reset_device();
+
+  measure_push_cost();
+
+  attachInterrupt(digitalPinToInterrupt(2), on_edge, CHANGE);
+}
+
+void loop() {
+  ring.drain();
+
+  static unsigned long last_report = 0;
+  if (millis() - last_report >= 1000) {
+    last_report = millis();
+    Serial.print("Overflows: ");
+    Serial.print(ring.get_overflows());
+    Serial.print("  Coalesced: ");
+    Serial.println(ring.get_coalesced());
+  }
+}
@@ -0,0 +1,49 @@
+/*
+Sketchbook demonstrating the priority scheduler of the AD525x_Scheduler.h library.
+
+A full EEMEM backup of the user registers is queued as bulk work, while a critical wiper write is
+submitted every few milliseconds. The worst-case latency of the critical writes is printed, and
+should stay around one EEMEM programming time regardless of the backup.
+*/
+
+#include <Wire.h>
+#include <AD525x.h>
+#include <AD525x_Scheduler.h>
+
+AD5254 ad4;             // The potentiometer object, not initialized.
+AD525xScheduler sched;
+
+byte RDAC = 0x00;      // RDAC <= 3
+byte AD_addr = 0b00;    // AD0 = 0, AD1 = 0
+
+byte wiper_val = 0;
+unsigned long last_urgent = 0;
+unsigned long urgent_period = 5;    // How frequently (ms) to issue a critical write.
+
+void setup() {
+  Serial.begin(9600);
+
+  ad4.initialize(AD_addr);
+  ad4.reset_device();
+}
+
+void loop() {
+  // Keep the bulk queue topped up with EEMEM writes to the user registers.
+  for (byte reg = 4; reg < 16 && sched.get_queued(AD525X_PRIO_BULK) < AD525X_SCHED_QUEUE_LEN; reg++) {
+    sched.write_EEMEM(ad4, reg, reg);
+  }
+
+  if (millis() - last_urgent >= urgent_period) {
+    last_urgent = millis();
+    sched.write_RDAC(ad4, RDAC, wiper_val++, AD525X_PRIO_CRITICAL);
+  }
+
+  sched.service();
+
+  static unsigned long last_report = 0;
+  if (millis() - last_report >= 1000) {
+    last_report = millis();
+    Serial.print("Worst-case critical latency (us): ");
+    Serial.println(sched.get_max_latency(AD525X_PRIO_CRITICAL));
+  }
+}
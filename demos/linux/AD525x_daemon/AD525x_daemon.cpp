@@ -0,0 +1,64 @@
+/*
+Pot-control daemon for Linux gateways, built on the AD525x_Protocol.h library.
+
+The daemon is the only process that talks to the AD5254 devices. Other processes connect to its
+Unix socket and send AD525xBatch requests. Batches that arrive together run as one round, so
+wiper writes from different clients are coalesced before they reach the bus. Stop it with SIGINT
+or SIGTERM; it prints its request counters on exit.
+
+Build it with an Arduino core for Linux that provides Wire.h, or with tests/host for the simulated
+bus. Usage: AD525x_daemon [socket path] [device addresses, e.g. 0 1 2 3]
+*/
+
+#include <Wire.h>
+#include <AD525x.h>
+#include <AD525x_Protocol.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static volatile sig_atomic_t running = 1;
+
+static void on_signal(int sig) {
+  (void)sig;
+  running = 0;
+}
+
+int main(int argc, char **argv) {
+  const char *path = (argc > 1) ? argv[1] : "/run/ad525x.sock";
+
+  static AD5254 pot[AD525X_PROTO_MAX_DEVICES];
+  AD525xProtocolServer server;
+
+  uint8_t n = 0;
+  for (int i = 2; i < argc && n < AD525X_PROTO_MAX_DEVICES; i++) {
+    if (pot[n].initialize(atoi(argv[i]))) {
+      fprintf(stderr, "device at address %s: initialize failed\n", argv[i]);
+      return 1;
+    }
+    server.add_device(pot[n++]);
+  }
+
+  if (n == 0) {
+    pot[0].initialize(0);
+    server.add_device(pot[0]);
+  }
+
+  AD525xSocketServer sock(server);
+  if (sock.listen(path)) {
+    fprintf(stderr, "%s: cannot listen\n", path);
+    return 1;
+  }
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+
+  while (running) {
+    sock.poll_once(100);
+  }
+
+  sock.close();
+  printf("requests %u rounds %u bus ops %u coalesced %u\n", server.get_requests(),
+         server.get_rounds(), server.get_ops(), server.get_coalesced());
+  return 0;
+}
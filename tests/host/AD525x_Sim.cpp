@@ -0,0 +1,200 @@
+/** @file
+Host implementation of the Arduino time functions and `TwoWire`, backed by a simulated AD525x.
+*/
+
+#include "AD525x_Sim.h"
+#include <Arduino.h>
+#include <Wire.h>
+#include <pthread.h>
+#include <time.h>
+
+TwoWire Wire;
+AD525xSim sim;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;  // Serializes transactions on `sim`.
+static uint32_t random_state = 1;
+
+unsigned long micros() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+unsigned long millis() {
+    return micros() / 1000;
+}
+
+void delay(unsigned long ms) {
+    timespec ts = {(time_t)(ms / 1000), (long)(ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+void delayMicroseconds(unsigned int us) {
+    unsigned long start = micros();
+    while (micros() - start < us) {}
+}
+
+void noInterrupts() {}
+void interrupts() {}
+
+void sim_reset(uint8_t max_val) {
+    /** Power-on state: wipers at mid-scale, EEMEM clear, 100 kHz, clean bus, untimed. The
+    tolerance of every RDAC reads as +1.5 %. */
+    memset(&sim, 0, sizeof(sim));
+    sim.max_val = max_val;
+    for (uint8_t i = 0; i < 4; i++) {
+        sim.rdac[i] = (max_val + 1) / 2;
+        sim.tolerance[2 * i] = 0x01;
+        sim.tolerance[2 * i + 1] = 0x80;
+    }
+    sim.clock_hz = 100000UL;
+    sim_seed(1);
+}
+
+void sim_seed(uint32_t seed) {
+    random_state = seed ? seed : 1;
+}
+
+uint32_t sim_random() {
+    /** xorshift32, so runs are repeatable across hosts. */
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+double sim_constant_noise(void *context, uint32_t clock_hz) {
+    /** Noise model with a fixed error rate, `*(double *)context`. */
+    (void)clock_hz;
+    return *(double *)context;
+}
+
+static bool corrupted() {
+    if (sim.nack_next) {
+        sim.nack_next--;
+        sim.errors++;
+        return true;
+    }
+
+    if (sim.noise && sim_random() / 4294967296.0 < sim.noise(sim.noise_context, sim.clock_hz)) {
+        sim.errors++;
+        return true;
+    }
+
+    return false;
+}
+
+static void spend(uint8_t bytes) {
+    /** Take as long as `bytes` bytes (9 clocks each, plus start and stop) at the current rate. */
+    if (!sim.timed) { return; }
+    delayMicroseconds((9UL * bytes + 2) * 1000000UL / sim.clock_hz + sim.overhead_us);
+}
+
+static void execute(const uint8_t *data, uint8_t n, uint8_t *pointer) {
+    uint8_t instr = data[0];
+
+    if (!(instr & 0x80)) {
+        *pointer = instr;
+        if (n < 2) { return; }
+        if ((instr & 0xE0) == 0x20) { sim.eemem[instr & 0x0F] = data[1]; }
+        else if ((instr & 0xE0) == 0x00) { sim.rdac[instr & 0x03] = data[1] > sim.max_val ? sim.max_val : data[1]; }
+        return;
+    }
+
+    uint8_t cmd = instr & 0xF8, a = instr & 0x03;
+    for (uint8_t i = 0; i < 4; i++) {
+        bool all = (cmd == 0xB0 || cmd == 0xB8 || cmd == 0xD8 || cmd == 0xA0 || cmd == 0xC8);
+        if (!all && i != a) { continue; }
+
+        uint8_t &w = sim.rdac[i];
+        switch (cmd) {
+            case 0x88: case 0xB8: w = sim.eemem[i]; break;                      // Restore
+            case 0x90: sim.eemem[i] = w; break;                                 // Store
+            case 0x98: case 0xA0: w /= 2; break;                                // -6 dB
+            case 0xA8: case 0xB0: if (w) { w--; } break;                        // Decrement
+            case 0xC0: case 0xC8: w = (w >= sim.max_val / 2) ? sim.max_val : w * 2; break;  // +6 dB
+            case 0xD0: case 0xD8: if (w < sim.max_val) { w++; } break;          // Increment
+        }
+    }
+}
+
+void TwoWire::begin() {}
+
+void TwoWire::setClock(uint32_t clock_hz) {
+    sim.clock_hz = clock_hz;
+    sim.clock_changes++;
+}
+
+void TwoWire::beginTransmission(uint8_t addr) {
+    (void)addr;
+    length = 0;
+}
+
+size_t TwoWire::write(uint8_t b) {
+    if (length >= sizeof(buffer)) { return 0; }
+    buffer[length++] = b;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (!write(data[i])) { return i; }
+    }
+    return n;
+}
+
+uint8_t TwoWire::endTransmission(bool stop) {
+    (void)stop;
+    spend(1 + length);
+
+    pthread_mutex_lock(&lock);
+    sim.transactions++;
+
+    uint8_t err = 0;
+    if (corrupted()) {
+        err = length ? 3 : 2;                       // NACK on data, or on the address.
+    } else if (length) {
+        execute(buffer, length, &pointer);
+    }
+    pthread_mutex_unlock(&lock);
+
+    return err;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t addr, uint8_t n) {
+    (void)addr;
+    spend(1 + n);
+
+    pthread_mutex_lock(&lock);
+    sim.transactions++;
+    pthread_mutex_unlock(&lock);
+
+    pending = n;
+    return n;
+}
+
+int TwoWire::available() {
+    return pending;
+}
+
+int TwoWire::read() {
+    if (!pending) { return -1; }
+    pending--;
+
+    uint8_t reg = pointer++;
+    int value;
+
+    pthread_mutex_lock(&lock);
+    if (corrupted()) {
+        value = 0x5A;                               // A bit error in the data byte.
+    } else if ((reg & 0xE0) == 0x20) {
+        value = sim.eemem[reg & 0x0F];
+    } else if ((reg & 0xF8) == 0x38) {
+        value = sim.tolerance[reg & 0x07];
+    } else {
+        value = sim.rdac[reg & 0x03];
+    }
+    pthread_mutex_unlock(&lock);
+
+    return value;
+}
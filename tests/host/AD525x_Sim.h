@@ -0,0 +1,40 @@
+/** @file
+Simulated AD5253/AD5254 behind the host `TwoWire` stub. Tests set up and inspect the device through
+the global `sim`. Every controller (`Wire`, or any other `TwoWire`) reaches the same device, at any
+address.
+*/
+#ifndef AD525X_SIM_H
+#define AD525X_SIM_H
+
+#include <stdint.h>
+
+/** Probability, 0 to 1, that a transaction at `clock_hz` is corrupted. */
+typedef double (*AD525xSimNoise)(void *context, uint32_t clock_hz);
+
+struct AD525xSim {
+    uint8_t rdac[4];
+    uint8_t eemem[16];
+    uint8_t tolerance[8];       /*!< Factory tolerance bytes, integer then fraction per RDAC. */
+    uint8_t max_val;            /*!< 63 for the AD5253, 255 for the AD5254. */
+
+    uint32_t clock_hz;          /*!< Last rate passed to `setClock()`. */
+    uint32_t clock_changes;
+    uint32_t transactions;      /*!< Transactions seen, including address-only writes. */
+    uint32_t errors;            /*!< Transactions corrupted by `nack_next` or the noise model. */
+
+    uint8_t nack_next;          /*!< NACK the address of this many transactions. */
+    AD525xSimNoise noise;       /*!< Error model, or NULL for a clean bus. */
+    void *noise_context;
+
+    bool timed;                 /*!< Make each transaction take its wire time plus `overhead_us`. */
+    uint16_t overhead_us;
+};
+
+extern AD525xSim sim;
+
+void sim_reset(uint8_t max_val = 255);
+uint32_t sim_random(void);
+void sim_seed(uint32_t seed);
+double sim_constant_noise(void *context, uint32_t clock_hz);
+
+#endif
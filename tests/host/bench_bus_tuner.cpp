@@ -0,0 +1,81 @@
+/** @file
+Goodput of an attached `AD525xBusTuner` against a fixed 400 kHz clock, on a link whose error rate
+rises with the clock, `K * (clock / 400 kHz)^P`, in bursts of 5,000 transactions separated by
+clean periods. The wire time of each 3-byte wiper write is counted at the clock in use.
+
+    bench_bus_tuner [K P [BURST]]      defaults: run the four cases below; BURST 0 = always noisy
+*/
+
+#include "AD525x_Sim.h"
+#include <AD525x_BusTuner.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct Model {
+    double K;
+    double P;
+    bool noisy;                 /*!< Inside a burst. */
+};
+
+static double model_noise(void *context, uint32_t clock_hz) {
+    Model *m = (Model *)context;
+    if (!m->noisy) { return 0; }
+
+    double f = clock_hz / 400000.0;
+    double p = m->K;
+    for (uint8_t k = 0; k < m->P; k++) {
+        p *= f;
+    }
+    return p;
+}
+
+static double goodput(AD5254 &pot, Model &model, bool burst) {
+    /** Bytes per second of successful writes over 60,000 transactions. */
+    double seconds = 0, good = 0;
+    sim_seed(1);
+
+    for (uint32_t i = 0; i < 60000; i++) {
+        model.noisy = !burst || (i / 5000) % 2 == 1;
+        uint8_t err = pot.write_RDAC(i & 3, i & 255);
+        seconds += 3 * 9.0 / sim.clock_hz;
+        if (!err) { good += 2; }
+    }
+
+    return good / seconds;
+}
+
+static void run(double K, double P, bool burst) {
+    sim_reset();
+    AD5254 pot;
+    pot.initialize(0);
+
+    Model model = {K, P, false};
+    sim.noise = model_noise;
+    sim.noise_context = &model;
+
+    AD525xBusTuner tuner;
+    tuner.qualify(pot);
+    double fixed = goodput(pot, model, burst);
+
+    tuner.attach();
+    double adaptive = goodput(pot, model, burst);
+    tuner.detach();
+
+    printf("K=%.2f P=%.0f %-7s fixed %6.0f  adaptive %6.0f B/s  (%+5.1f%%)  down %u up %u\n", K, P,
+           burst ? "bursts" : "steady", fixed, adaptive, 100 * (adaptive / fixed - 1),
+           tuner.get_fallbacks(), tuner.get_upshifts());
+}
+
+int main(int argc, char **argv) {
+    if (argc > 2) {
+        run(atof(argv[1]), atof(argv[2]), argc > 3 ? atoi(argv[3]) != 0 : true);
+        return 0;
+    }
+
+    printf("bench_bus_tuner: goodput of the adaptive clock vs a fixed 400 kHz\n");
+    run(0, 1, true);            // Clean link.
+    run(0.9, 4, true);
+    run(0.9, 2, true);
+    run(0.3, 3, true);
+    return 0;
+}
@@ -0,0 +1,144 @@
+/** @file
+EEMEM backups of several devices, run two ways: from one epoll loop with `AD525xEventSource`, and
+with one thread per device sharing the bus through `AD525xShared`. Reports wall time, CPU time,
+wakeups and context switches on the timed simulated bus.
+*/
+
+#include "AD525x_Sim.h"
+#include <AD525x_EventLoop.h>
+#include <AD525x_ThreadSafe.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#define DEVICES 4
+#define WRITES 8            // EEMEM writes per device.
+
+struct Usage {
+    uint32_t wall_ms;
+    double cpu_ms;
+    long switches;
+};
+
+static Usage usage_now() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    Usage u;
+    u.wall_ms = millis();
+    u.cpu_ms = (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000.0 +
+               (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000.0;
+    u.switches = ru.ru_nvcsw + ru.ru_nivcsw;
+    return u;
+}
+
+static void report(const char *mode, uint32_t threads, uint32_t wakeups, Usage a, Usage b) {
+    printf("%-11s %7u %7u %8u %8.1f %9ld\n", mode, threads, wakeups, b.wall_ms - a.wall_ms,
+           b.cpu_ms - a.cpu_ms, b.switches - a.switches);
+}
+
+static void reset(AD5254 *pot) {
+    sim_reset();
+    sim.timed = true;
+    for (uint8_t d = 0; d < DEVICES; d++) {
+        pot[d].initialize(d);
+    }
+}
+
+static void event_loop() {
+    AD5254 pot[DEVICES];
+    reset(pot);
+
+    AD525xScheduler sched;
+    AD525xEventSource source(sched);
+    source.open();
+
+    int ep = epoll_create1(0);
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    epoll_ctl(ep, EPOLL_CTL_ADD, source.get_fd(), &ev);
+
+    Usage a = usage_now();
+
+    uint8_t next[DEVICES] = {0};
+    uint32_t submitted = 0;
+    while (true) {
+        // Keep the bulk queue topped up, round robin over the devices.
+        uint32_t before = submitted;
+        for (uint8_t d = 0; d < DEVICES && submitted < DEVICES * WRITES; d++) {
+            if (next[d] < WRITES && sched.get_queued(AD525X_PRIO_BULK) < AD525X_SCHED_QUEUE_LEN) {
+                sched.write_EEMEM(pot[d], 4 + next[d], next[d]);
+                next[d]++;
+                submitted++;
+            }
+        }
+        if (submitted != before) { source.notify(); }
+
+        if (submitted == DEVICES * WRITES && sched.get_wait_us() == AD525X_SCHED_IDLE) { break; }
+
+        if (epoll_wait(ep, &ev, 1, 1000) == 1) { source.dispatch(); }
+    }
+
+    Usage b = usage_now();
+    report("event loop", 1, source.get_dispatches(), a, b);
+
+    ::close(ep);
+    source.close();
+}
+
+struct Worker {
+    AD525xShared *dev;
+    uint32_t wakeups;
+};
+
+static void *worker(void *arg) {
+    Worker *w = (Worker *)arg;
+    for (uint8_t i = 0; i < WRITES; i++) {
+        w->dev->write_EEMEM(4 + i, i);
+        delay(AD525X_EEMEM_WRITE_MS);
+        w->wakeups++;
+    }
+    return NULL;
+}
+
+static void threaded() {
+    AD5254 pot[DEVICES];
+    reset(pot);
+
+    AD525xBusLock bus;
+    AD525xShared *shared[DEVICES];
+    Worker w[DEVICES];
+    pthread_t t[DEVICES];
+
+    Usage a = usage_now();
+
+    for (uint8_t d = 0; d < DEVICES; d++) {
+        shared[d] = new AD525xShared(pot[d], bus);
+        w[d].dev = shared[d];
+        w[d].wakeups = 0;
+        pthread_create(&t[d], NULL, worker, &w[d]);
+    }
+
+    uint32_t wakeups = 0;
+    for (uint8_t d = 0; d < DEVICES; d++) {
+        pthread_join(t[d], NULL);
+        wakeups += w[d].wakeups;
+        delete shared[d];
+    }
+
+    Usage b = usage_now();
+    report("threaded", DEVICES, wakeups, a, b);
+}
+
+int main() {
+    printf("bench_event_loop: %d devices x %d EEMEM writes, 100 kHz simulated bus\n", DEVICES, WRITES);
+    printf("mode        threads wakeups  wall ms   cpu ms  switches\n");
+
+    for (uint8_t run = 0; run < 2; run++) {
+        event_loop();
+        threaded();
+    }
+
+    return 0;
+}
@@ -0,0 +1,150 @@
+/** @file
+Requests per second and end-to-end latency of the socket server against the simulated bus. A
+server thread runs `poll_once()` in a loop over four devices; each client thread sends batches of
+wiper writes and waits for the reply before sending the next. The bus is timed at 400 kHz, so
+results reflect wire time rather than host speed.
+*/
+
+#include "AD525x_Sim.h"
+#include <AD525x_Protocol.h>
+#include <algorithm>
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define MAX_SAMPLES 200000
+
+static const char *path = "/tmp/ad525x_bench.sock";
+static volatile bool stop;         // Clients
+static volatile bool stop_server;
+
+static uint32_t latency[MAX_SAMPLES];
+static uint32_t n_latency;         // Under lock
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+struct ClientArgs {
+    uint8_t batch;
+    uint32_t seed;
+    uint32_t requests;
+};
+
+static void *server_thread(void *arg) {
+    AD525xSocketServer *sock = (AD525xSocketServer *)arg;
+    while (!stop_server) {
+        sock->poll_once(10);
+    }
+    return NULL;
+}
+
+static void *client_thread(void *arg) {
+    ClientArgs *c = (ClientArgs *)arg;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) { return NULL; }
+
+    AD525xBatch batch;
+    uint8_t response[AD525X_PROTO_MAX_RESPONSE];
+    uint32_t x = c->seed;
+
+    while (!stop) {
+        batch.clear();
+        for (uint8_t i = 0; i < c->batch; i++) {
+            x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+            batch.add(AD525X_OP_WRITE_RDAC, x % 4, (x >> 4) % 4, x >> 24);
+        }
+
+        uint32_t start = micros();
+        if (send(fd, batch.data(), batch.size(), 0) <= 0 ||
+            recv(fd, response, sizeof(response), 0) <= 0) { break; }
+        uint32_t us = micros() - start;
+
+        c->requests++;
+        pthread_mutex_lock(&lock);
+        if (n_latency < MAX_SAMPLES) { latency[n_latency++] = us; }
+        pthread_mutex_unlock(&lock);
+    }
+
+    ::close(fd);
+    return NULL;
+}
+
+static void run(uint8_t clients, uint8_t batch_ops) {
+    sim_reset();
+    sim.timed = true;
+    sim.clock_hz = 400000UL;
+
+    AD5254 pot[4];
+    AD525xProtocolServer server;
+    for (uint8_t i = 0; i < 4; i++) {
+        pot[i].initialize(i);
+        server.add_device(pot[i]);
+    }
+
+    AD525xSocketServer sock(server);
+    sock.listen(path);
+
+    stop = false;
+    stop_server = false;
+    n_latency = 0;
+    pthread_t st;
+    pthread_create(&st, NULL, server_thread, &sock);
+
+    pthread_t ct[16];
+    ClientArgs args[16];
+    for (uint8_t k = 0; k < clients; k++) {
+        args[k].batch = batch_ops;
+        args[k].seed = 2463534242UL + k * 7919;
+        args[k].requests = 0;
+        pthread_create(&ct[k], NULL, client_thread, &args[k]);
+    }
+
+    const uint32_t duration_ms = 1000;
+    uint32_t t0 = millis();
+    usleep(duration_ms * 1000);
+    stop = true;
+    for (uint8_t k = 0; k < clients; k++) {
+        pthread_join(ct[k], NULL);
+    }
+    stop_server = true;
+    pthread_join(st, NULL);
+    uint32_t elapsed = millis() - t0;
+
+    uint32_t requests = 0;
+    for (uint8_t k = 0; k < clients; k++) {
+        requests += args[k].requests;
+    }
+
+    std::sort(latency, latency + n_latency);
+    uint32_t p50 = n_latency ? latency[n_latency / 2] : 0;
+    uint32_t p99 = n_latency ? latency[n_latency * 99 / 100] : 0;
+    uint32_t ops = requests * batch_ops;
+
+    printf("%7u %5u %9.0f %9.0f %7u %7u %9.2f %9.1f%%\n", clients, batch_ops,
+           requests * 1000.0 / elapsed, ops * 1000.0 / elapsed, p50, p99,
+           server.get_rounds() ? (double)server.get_requests() / server.get_rounds() : 0.0,
+           server.get_requests() ? 100.0 * server.get_coalesced() / (server.get_requests() * batch_ops) : 0.0);
+
+    sock.close();
+}
+
+int main() {
+    printf("bench_protocol: wiper writes over the socket, 4 devices, 400 kHz simulated bus\n");
+    printf("clients batch  req/s     ops/s     p50 us  p99 us  req/round coalesced\n");
+
+    static const uint8_t clients[] = {1, 4, 16};
+    static const uint8_t batches[] = {1, 8, 32};
+    for (uint8_t c = 0; c < 3; c++) {
+        for (uint8_t b = 0; b < 3; b++) {
+            run(clients[c], batches[b]);
+        }
+    }
+
+    return 0;
+}
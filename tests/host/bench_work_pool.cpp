@@ -0,0 +1,115 @@
+/** @file
+Scaling of `AD525xWorkPool` from 1 to 16 workers on fleet planning work: for each of 2,000
+simulated devices, solve a composite (series) resistor for 32 targets. Jobs are uneven, so the
+spread relies on stealing. Speed-up is bounded by the cores of the host, printed first.
+
+Alongside the planning, two simulated 400 kHz buses take wiper updates through jobs pinned with
+`submit_to()`, one worker per bus. Their rate shows how far bus I/O is held up by the stolen CPU
+work sharing its workers.
+*/
+
+#include "AD525x_Sim.h"
+#include <AD525x_Composite.h>
+#include <AD525x_WorkPool.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define DEVICES 2000
+#define BUSES 2
+#define IO_JOBS 12              // Pinned jobs per bus; all fit in AD525X_POOL_PINNED_LEN.
+#define IO_UPDATES 50           // Wiper updates per pinned job.
+
+static AD525xComposite *model;
+static uint32_t checksum[DEVICES];
+
+static AD5254 pot[2 * BUSES];   // Two devices per bus, touched only by that bus's worker.
+static uint32_t updates;        // Atomic.
+static unsigned long io_end;    // When the last pinned job finished. Atomic.
+
+static void plan(void *arg) {
+    uint32_t d = (uint32_t)(uintptr_t)arg;
+    AD525xComposite c = *model;                 // Private copy: solve() keeps an error code.
+    uint32_t sum = 0;
+    uint32_t targets = 16 + (d % 4) * 8;        // 16 to 40 solves: uneven jobs.
+
+    for (uint32_t t = 0; t < targets; t++) {
+        uint8_t a, b;
+        c.solve(1000.0f + 37.0f * ((d * 31 + t * 17) % 500), &a, &b);
+        sum += a * 256 + b;
+    }
+
+    checksum[d] = sum;
+}
+
+static void bus_io(void *arg) {
+    uint32_t bus = (uint32_t)(uintptr_t)arg;
+    uint32_t done = 0;
+
+    for (uint32_t i = 0; i < IO_UPDATES; i++) {
+        AD5254 &p = pot[2 * bus + (i & 1)];
+        if (!p.write_RDAC(i & 3, (uint8_t)i)) { done++; }
+    }
+
+    __atomic_fetch_add(&updates, done, __ATOMIC_RELAXED);
+    unsigned long now = micros();
+    unsigned long end = __atomic_load_n(&io_end, __ATOMIC_RELAXED);
+    while (now > end && !__atomic_compare_exchange_n(&io_end, &end, now, false,
+                                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+
+int main() {
+    sim_reset();
+    static TwoWire second;
+    for (uint8_t k = 0; k < 2 * BUSES; k++) {
+        pot[k].initialize(k & 1, (k < 2) ? Wire : second);
+    }
+    sim.clock_hz = 400000UL;
+    sim.timed = true;
+
+    AD525xComposite composite(pot[0], 0, 1, AD525xComposite::series);
+    composite.calibrate(10000, 75);
+    model = &composite;
+
+    printf("bench_work_pool: %d devices, host has %ld online cores\n", DEVICES,
+           sysconf(_SC_NPROCESSORS_ONLN));
+    printf("workers  wall ms  speed-up  stolen  bus updates/s\n");
+
+    uint32_t base_us = 0, reference = 0;
+    for (uint8_t workers = 1; workers <= 16; workers *= 2) {
+        AD525xWorkPool pool;
+        pool.start(workers);
+
+        updates = 0;
+        unsigned long start = micros();
+        io_end = start;
+        for (uint32_t j = 0; j < IO_JOBS; j++) {
+            for (uint32_t b = 0; b < BUSES; b++) {
+                while (pool.submit_to(b % workers, bus_io, (void *)(uintptr_t)b)) {
+                    pool.wait_idle();
+                }
+            }
+        }
+        for (uint32_t d = 0; d < DEVICES; d++) {
+            while (pool.submit(plan, (void *)(uintptr_t)d)) { pool.wait_idle(); }
+        }
+        pool.wait_idle();
+        uint32_t us = micros() - start;
+
+        uint32_t total = 0;
+        for (uint32_t d = 0; d < DEVICES; d++) {
+            total += checksum[d];
+        }
+        if (workers == 1) {
+            base_us = us;
+            reference = total;
+        }
+
+        double io_s = (io_end - start) / 1e6;
+        printf("%7u %8.1f %9.2f %7u %14.0f%s\n", workers, us / 1000.0, (double)base_us / us,
+               pool.get_stolen(), io_s > 0 ? updates / io_s : 0.0,
+               total == reference ? "" : "  checksum mismatch");
+        pool.stop();
+    }
+
+    return 0;
+}
@@ -0,0 +1,35 @@
+/** @file
+Minimal assertion helpers for the host tests. A test reports every failed `CHECK` and exits with
+`check_result()`, non-zero if any failed.
+*/
+#ifndef AD525X_CHECK_H
+#define AD525X_CHECK_H
+
+#include <stdio.h>
+
+static int check_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            check_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { \
+        long long check_a = (long long)(a), check_b = (long long)(b); \
+        if (check_a != check_b) { \
+            printf("%s:%d: check failed: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #a, #b, \
+                   check_a, check_b); \
+            check_failures++; \
+        } \
+    } while (0)
+
+static inline int check_result(const char *name) {
+    printf("%s: %s\n", name, check_failures ? "FAIL" : "ok");
+    return check_failures ? 1 : 0;
+}
+
+#endif
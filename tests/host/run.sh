@@ -0,0 +1,62 @@
+#!/bin/sh
+# Build and run the host tests against the simulated device in AD525x_Sim.cpp.
+#
+#   tests/host/run.sh            run every test_*.cpp
+#   tests/host/run.sh bench      also run every bench_*.cpp and print its results
+#   tests/host/run.sh NAME...    run only the named tests or benches
+#
+# CXX and CXXFLAGS are honoured. Objects go to $BUILD (default: a temporary directory). Sources
+# that use AD525X_HAS_COROUTINES are built with -std=c++20 against a second set of objects.
+
+set -u
+here=$(cd "$(dirname "$0")" && pwd)
+root=$(cd "$here/../.." && pwd)
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--std=c++17 -O2 -Wall -Wextra}
+BUILD=${BUILD:-$(mktemp -d)}
+mkdir -p "$BUILD" || exit 1
+
+inc="-I$here/stubs -I$here"
+for d in "$root"/AD525x*/; do inc="$inc -I$d"; done
+
+# build_objects DIR FLAGS: compile the libraries and the simulator into DIR, listing them in $objs.
+build_objects() {
+    mkdir -p "$1" || return 1
+    objs=""
+    for f in "$root"/AD525x*/*.cpp "$here"/AD525x_Sim.cpp; do
+        o="$1/$(basename "$f" .cpp).o"
+        $CXX $2 $inc -c "$f" -o "$o" || return 1
+        objs="$objs $o"
+    done
+}
+
+build_objects "$BUILD" "$CXXFLAGS" || exit 1
+objs_default=$objs
+objs_cxx20=""
+CXXFLAGS_20=$(echo "$CXXFLAGS" | sed 's/-std=[^ ]*//g')" -std=c++20"
+
+if [ $# -eq 0 ]; then
+    set -- $(cd "$here" && ls test_*.cpp | sed 's/\.cpp$//')
+elif [ "$1" = bench ]; then
+    set -- $(cd "$here" && ls test_*.cpp bench_*.cpp | sed 's/\.cpp$//')
+fi
+
+failed=0
+for t in "$@"; do
+    flags=$CXXFLAGS
+    objs=$objs_default
+
+    if grep -q AD525X_HAS_COROUTINES "$here/$t.cpp"; then
+        if [ -z "$objs_cxx20" ]; then
+            build_objects "$BUILD/c++20" "$CXXFLAGS_20" || { failed=1; continue; }
+            objs_cxx20=$objs
+        fi
+        flags=$CXXFLAGS_20
+        objs=$objs_cxx20
+    fi
+
+    $CXX $flags $inc "$here/$t.cpp" $objs -o "$BUILD/$t" -lpthread -lrt || { failed=1; continue; }
+    "$BUILD/$t" || failed=1
+done
+
+exit $failed
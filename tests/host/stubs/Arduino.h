@@ -0,0 +1,23 @@
+/** @file
+Minimal Arduino core API for building the libraries on a host. Time comes from the host's
+monotonic clock; interrupts do not exist, so the masking functions do nothing.
+*/
+#ifndef AD525X_HOST_ARDUINO_H
+#define AD525X_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void noInterrupts(void);
+void interrupts(void);
+
+#endif
@@ -0,0 +1,35 @@
+/** @file
+Host stand-in for the Arduino `TwoWire` class. Every controller talks to the simulated AD525x of
+`sim/AD525x_Sim.h`. Each keeps its own register pointer, and transactions are serialized on the
+simulator, so controllers may be driven from different threads.
+*/
+#ifndef AD525X_HOST_WIRE_H
+#define AD525X_HOST_WIRE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class TwoWire {
+public:
+    void begin(void);
+    void setClock(uint32_t clock_hz);
+
+    void beginTransmission(uint8_t addr);
+    size_t write(uint8_t b);
+    size_t write(const uint8_t *data, size_t n);
+    uint8_t endTransmission(bool stop = true);
+
+    uint8_t requestFrom(uint8_t addr, uint8_t n);
+    int available(void);
+    int read(void);
+
+private:
+    uint8_t buffer[8];
+    uint8_t length;
+    uint8_t pending;            /*!< Bytes left from the last `requestFrom()`. */
+    uint8_t pointer;            /*!< Register selected by the last write on this controller. */
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,137 @@
+/** @file
+`AD525xAsyncBus` against the simulator: queued operations complete through the Wire and simulated
+transports, the wiper cache only changes in `service()` (never in `complete()`, which may run in an
+interrupt), devices on another controller are refused, and an EEMEM write holds its device back for
+the programming time while transfers overlap the caller's own work. Transfers reach the bus
+monitor as blocking ones do.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_Async.h>
+#include <AD525x_Errors.h>
+
+struct Monitored {
+    uint32_t transfers;
+    uint32_t errors;
+    uint32_t bytes;
+};
+
+static void monitor(void *context, TwoWire *bus, uint8_t err, uint8_t bytes) {
+    Monitored *m = (Monitored *)context;
+    CHECK(bus == &Wire);
+    m->transfers++;
+    if (err) { m->errors++; }
+    m->bytes += bytes;
+}
+
+int main() {
+    sim_reset();
+    AD5254 pot;
+    pot.initialize(0);
+
+    // Blocking Wire transport: every transfer completes inside the call that queues it.
+    AD525xWireTransport wire_transport;
+    AD525xAsyncBus bus(AD525xWireTransport::start, &wire_transport);
+    volatile uint8_t status = AD525X_ASYNC_PENDING;
+    uint8_t value = 0;
+
+    CHECK_EQ(bus.write_RDAC(pot, 1, 42, &status), 0);
+    CHECK_EQ(status, 0);
+    CHECK_EQ(sim.rdac[1], 42);
+    CHECK(!pot.is_cached(1));           // Deferred to service().
+    CHECK(!bus.idle());
+    bus.service();
+    CHECK(bus.idle());
+    CHECK(pot.is_cached(1));
+    CHECK_EQ(pot.read_RDAC_cached(1), 42);
+
+    sim.rdac[2] = 17;
+    CHECK_EQ(bus.read_RDAC(pot, 2, &value, &status), 0);
+    CHECK_EQ(value, 17);
+    bus.service();
+    CHECK_EQ(pot.read_RDAC_cached(2), 17);
+
+    // A failed write leaves the wiper unknown.
+    sim.nack_next = 1;
+    CHECK_EQ(bus.write_RDAC(pot, 1, 50, &status), 0);
+    CHECK(status != 0 && status != AD525X_ASYNC_PENDING);
+    bus.service();
+    CHECK(!pot.is_cached(1));
+
+    // Pending cache updates count against the queue.
+    for (uint8_t i = 0; i < AD525X_ASYNC_QUEUE_LEN; i++) {
+        CHECK_EQ(bus.write_RDAC(pot, 0, i), 0);
+    }
+    CHECK_EQ(bus.write_RDAC(pot, 0, 99), EC_NO_RESOURCES);
+    bus.service();
+    CHECK_EQ(pot.read_RDAC_cached(0), AD525X_ASYNC_QUEUE_LEN - 1);
+
+    // A device on another controller is refused.
+    TwoWire other;
+    AD5254 elsewhere;
+    elsewhere.initialize(1, other);
+    CHECK_EQ(bus.write_RDAC(elsewhere, 0, 1), EC_BAD_DEVICE_ADDR);
+    AD525xAsyncBus other_bus(AD525xWireTransport::start, &wire_transport, other);
+    CHECK_EQ(other_bus.write_RDAC(elsewhere, 0, 1), 0);
+    CHECK_EQ(other_bus.write_RDAC(pot, 0, 1), EC_BAD_DEVICE_ADDR);
+
+    // Simulated transport: 64 transfers overlap a busy loop, and none completes early.
+    AD525xSimTransport sim_transport(400000UL);
+    AD525xAsyncBus async(AD525xSimTransport::start, &sim_transport);
+    uint32_t start = micros();
+    uint32_t queued = 0, work = 0;
+
+    while (queued < 64 || !async.idle()) {
+        if (queued < 64 && async.write_RDAC(pot, queued & 3, queued) == 0) { queued++; }
+        work++;                         // The caller's own work between interrupts.
+        sim_transport.poll();
+        async.service();
+    }
+    uint32_t elapsed = micros() - start;
+
+    CHECK_EQ(async.get_completed(), 64);
+    CHECK(elapsed >= sim_transport.get_wire_us());
+    CHECK(work > 64);
+    CHECK_EQ(sim.rdac[3], 63);
+    CHECK_EQ(pot.read_RDAC_cached(3), 63);
+
+    // A read queued behind an EEMEM write of the same device waits out the programming time.
+    volatile uint8_t read_status = AD525X_ASYNC_PENDING;
+    CHECK_EQ(async.write_EEMEM(pot, 5, 0x33), 0);
+    CHECK_EQ(async.read_EEMEM(pot, 5, &value, &read_status), 0);
+
+    uint32_t written = 0;
+    start = millis();
+    while (!async.idle() && millis() - start < 200) {
+        sim_transport.poll();
+        async.service();
+        if (written == 0 && async.get_completed() == 65) { written = millis(); }
+    }
+
+    CHECK_EQ(read_status, 0);
+    CHECK_EQ(value, 0x33);
+    CHECK(millis() - written >= AD525X_EEMEM_WRITE_MS);
+
+    // Transfers are reported to the bus monitor like blocking ones, with the same byte counts.
+    Monitored seen = {0, 0, 0};
+    AD525x::set_bus_monitor(monitor, &seen);
+    CHECK_EQ(bus.write_RDAC(pot, 0, 3), 0);         // Register and data.
+    CHECK_EQ(bus.read_EEMEM(pot, 7, &value), 0);    // Register, then one byte back.
+    sim.nack_next = 1;
+    CHECK_EQ(bus.store_RDAC(pot, 0), 0);            // Command only, and it fails.
+    bus.service();
+    CHECK_EQ(seen.transfers, 3);
+    CHECK_EQ(seen.errors, 1);
+    CHECK_EQ(seen.bytes, 2 + 2 + 1);
+
+    Monitored blocking = {0, 0, 0};
+    AD525x::set_bus_monitor(monitor, &blocking);
+    pot.write_RDAC(0, 4);
+    pot.read_EEMEM(7);
+    pot.store_RDAC(0);
+    CHECK_EQ(blocking.bytes, seen.bytes);
+    AD525x::set_bus_monitor(NULL);
+
+    return check_result("test_async");
+}
@@ -0,0 +1,89 @@
+/** @file
+Check the bandwidth budgets: updates are charged what actually goes on the wire, a failing queued
+update is not retried on every pass, and under an `AD525xScheduler` a device over its budget holds
+up neither another device nor its own critical traffic.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_Budget.h>
+#include <AD525x_Scheduler.h>
+#include <AD525x_Errors.h>
+
+int main() {
+    sim_reset();
+    AD5254 a, b;
+    a.initialize(0);
+    b.initialize(1);
+
+    // Charged by bytes sent: a step is two bytes, a move to the cached value nothing.
+    {
+        AD525xRateLimiter limiter;
+        CHECK_EQ(a.write_RDAC(0, 10), EC_NO_ERR);
+        limiter.set_device_budget(a, 1, 3);
+
+        CHECK_EQ(limiter.submit_RDAC(a, 0, 11), EC_NO_ERR);
+        CHECK_EQ(limiter.submit_RDAC(a, 0, 11), EC_NO_ERR);
+        CHECK_EQ(limiter.get_deferred(), 0);
+        CHECK_EQ(limiter.submit_RDAC(a, 0, 12), EC_NO_ERR);
+        CHECK_EQ(limiter.get_deferred(), 1);
+        CHECK_EQ(sim.rdac[0], 11);
+    }
+
+    // A queued update that fails is dropped, not sent and charged again on every pass.
+    {
+        AD525xRateLimiter limiter;
+        limiter.set_device_budget(b, 1000, 3);
+        CHECK_EQ(limiter.submit_RDAC(b, 1, 5), EC_NO_ERR);
+        CHECK_EQ(limiter.submit_RDAC(b, 1, 9), EC_NO_ERR);
+        CHECK_EQ(limiter.get_pending(), 1);
+
+        delay(5);
+        sim.nack_next = 1;
+        CHECK(limiter.service() != EC_NO_ERR);
+        CHECK_EQ(limiter.get_pending(), 0);
+        CHECK_EQ(limiter.get_dropped(), 1);
+
+        uint32_t tx = sim.transactions;
+        delay(5);
+        CHECK_EQ(limiter.service(), EC_NO_ERR);
+        CHECK_EQ(sim.transactions, tx);
+    }
+
+    // Latency isolation: a bulk read-back of `a` spends its budget; `b` is not held up behind it.
+    {
+        AD525xRateLimiter limiter;
+        AD525xScheduler sched;
+        sched.set_budget(&limiter);
+        limiter.set_device_budget(a, 100, 8);
+
+        uint8_t value[4];
+        for (uint8_t i = 0; i < 4; i++) {
+            CHECK_EQ(sched.read_EEMEM(a, 4 + i, &value[i], AD525X_PRIO_NORMAL), EC_NO_ERR);
+        }
+
+        volatile uint8_t done_b = AD525X_SCHED_PENDING, done_critical = AD525X_SCHED_PENDING;
+        CHECK_EQ(sched.write_RDAC(b, 2, 77, AD525X_PRIO_NORMAL, &done_b), EC_NO_ERR);
+
+        uint32_t tx = sim.transactions;
+        CHECK_EQ(sched.service(), EC_NO_ERR);
+        CHECK_EQ(done_b, EC_NO_ERR);
+        CHECK_EQ(sim.rdac[2], 77);
+        CHECK_EQ(sim.transactions - tx, 2 * 3 + 1);     // Two reads of `a` (4 bytes each), then `b`.
+        CHECK_EQ(sched.get_queued(AD525X_PRIO_NORMAL), 2);
+
+        // The next read of `a` waits for 4 bytes of budget at 100 bytes/s.
+        uint32_t wait = sched.get_wait_us();
+        CHECK(wait > 30000UL && wait <= 40000UL);
+
+        // Critical traffic to `a` goes straight out, over budget.
+        CHECK_EQ(sched.write_RDAC(a, 3, 33, AD525X_PRIO_CRITICAL, &done_critical), EC_NO_ERR);
+        CHECK_EQ(sched.run_one(), EC_NO_ERR);
+        CHECK_EQ(done_critical, EC_NO_ERR);
+        CHECK_EQ(sim.rdac[3], 33);
+        CHECK_EQ(sched.get_queued(AD525X_PRIO_NORMAL), 2);
+        CHECK(sched.get_wait_us() > 40000UL);           // And pushes `a`'s own backlog back.
+    }
+
+    return check_result("test_budget");
+}
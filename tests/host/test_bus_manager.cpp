@@ -0,0 +1,90 @@
+/** @file
+`AD525xBusManager` over several host controllers: a controller beyond `AD525X_MAX_BUSES` is
+refused, turns rotate between buses, and a device programming EEMEM on one bus does not hold up
+the others.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_BusManager.h>
+#include <AD525x_Errors.h>
+
+static TwoWire wire1, wire2, wire3, wire4;
+
+static TwoWire *order[32];      // Controller of each transaction, in order.
+static uint8_t n_order;
+
+static void monitor(void *context, TwoWire *bus, uint8_t err, uint8_t bytes) {
+    (void)context;
+    (void)err;
+    (void)bytes;
+    if (n_order < 32) { order[n_order++] = bus; }
+}
+
+int main() {
+    sim_reset();
+
+    // Wire is always controller 0, so three more fit and a fifth is refused.
+    AD5254 a, b, c, d, e;
+    CHECK_EQ(a.initialize(0, Wire), EC_NO_ERR);
+    CHECK_EQ(b.initialize(1, wire1), EC_NO_ERR);
+    CHECK_EQ(c.initialize(2, wire2), EC_NO_ERR);
+    CHECK_EQ(d.initialize(3, wire3), EC_NO_ERR);
+    CHECK_EQ(e.initialize(0, wire4), EC_NO_RESOURCES);
+
+    AD525xScheduler queue[AD525X_MAX_BUSES + 1];
+    AD525xBusManager manager;
+    uint8_t index = 0xFF;
+    for (uint8_t i = 0; i < AD525X_MAX_BUSES; i++) {
+        CHECK_EQ(manager.add_bus(queue[i], &index), EC_NO_ERR);
+        CHECK_EQ(index, i);
+    }
+    CHECK_EQ(manager.add_bus(queue[AD525X_MAX_BUSES]), EC_NO_RESOURCES);
+    CHECK_EQ(manager.get_buses(), AD525X_MAX_BUSES);
+
+    // Turns rotate: three writes queued on each of two buses go out alternately.
+    AD525x::set_bus_monitor(monitor);
+    for (uint8_t i = 0; i < 3; i++) {
+        queue[0].write_RDAC(a, 0, 10 + i);
+        queue[1].write_RDAC(b, 1, 20 + i);
+    }
+    n_order = 0;
+    CHECK_EQ(manager.service(), EC_NO_ERR);
+    CHECK_EQ(n_order, 6);
+    for (uint8_t i = 0; i < n_order; i++) {
+        CHECK(order[i] == ((i % 2) ? &wire1 : &Wire));
+    }
+    CHECK_EQ(manager.get_transactions(0), 3);
+    CHECK_EQ(manager.get_transactions(1), 3);
+
+    // An EEMEM write on bus 0 holds back only that device; bus 1 carries on meanwhile.
+    queue[0].write_EEMEM(a, 5, 55);
+    CHECK_EQ(manager.run_one(), EC_NO_ERR);
+    queue[0].write_RDAC(a, 2, 30);
+    for (uint8_t i = 0; i < 3; i++) {
+        queue[1].write_RDAC(b, 3, 40 + i);
+    }
+    unsigned long start = micros();
+    n_order = 0;
+    CHECK_EQ(manager.service(), EC_NO_ERR);
+    CHECK(micros() - start < AD525X_EEMEM_WRITE_MS * 1000UL);
+    CHECK_EQ(n_order, 3);
+    for (uint8_t i = 0; i < n_order; i++) {
+        CHECK(order[i] == &wire1);
+    }
+    CHECK_EQ(sim.eemem[5], 55);
+    CHECK_EQ(sim.rdac[3], 42);
+    CHECK_EQ(queue[0].get_queued(AD525X_PRIO_NORMAL), 1);
+
+    uint32_t wait = manager.get_wait_us();
+    CHECK(wait > 0 && wait <= AD525X_EEMEM_WRITE_MS * 1000UL);
+
+    delay(AD525X_EEMEM_WRITE_MS + 1);
+    CHECK_EQ(manager.get_wait_us(), 0);
+    CHECK_EQ(manager.service(), EC_NO_ERR);
+    CHECK_EQ(sim.rdac[2], 30);
+    CHECK_EQ(manager.get_wait_us(), AD525X_SCHED_IDLE);
+
+    AD525x::set_bus_monitor(NULL);
+    return check_result("test_bus_manager");
+}
@@ -0,0 +1,96 @@
+/** @file
+Qualify the bus clock of a simulated AD5254 whose error rate depends on the clock: clean up to a
+limit, 2 % of transactions corrupted above it. `qualify()` must settle on the fastest candidate at
+or below the limit, and an attached tuner must shift down when errors burst at the qualified rate
+without cutting off the bus monitor it replaced.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_BusTuner.h>
+#include <AD525x_Errors.h>
+
+struct Limit {
+    uint32_t clock_hz;          /*!< Fastest clean clock. */
+    double above;               /*!< Error probability above it. */
+};
+
+static uint32_t monitored = 0;
+
+static void count(void *context, TwoWire *bus, uint8_t err, uint8_t bytes) {
+    (void)bus, (void)err, (void)bytes;
+    monitored += (uintptr_t)context;
+}
+
+static double limited(void *context, uint32_t clock_hz) {
+    Limit *l = (Limit *)context;
+    return clock_hz > l->clock_hz ? l->above : 0;
+}
+
+int main() {
+    sim_reset();
+    sim_seed(1);
+    AD5254 pot;
+    pot.initialize(0);
+
+    Limit limit = {1000000UL, 0.02};
+    sim.noise = limited;
+    sim.noise_context = &limit;
+
+    // No limit within the candidates: the rated maximum.
+    AD525xBusTuner tuner;
+    CHECK_EQ(tuner.qualify(pot), 0);
+    CHECK_EQ(tuner.get_max_passing(), 400000UL);
+    CHECK_EQ(tuner.get_rate(), 400000UL);
+    CHECK_EQ(sim.clock_hz, 400000UL);
+
+    // A 250 kHz limit: 300 kHz fails its rounds or the soak.
+    limit.clock_hz = 250000UL;
+    CHECK_EQ(tuner.qualify(pot), 0);
+    CHECK_EQ(tuner.get_max_passing(), 200000UL);
+    CHECK_EQ(sim.clock_hz, 200000UL);
+
+    // Candidates are sorted, and an empty list is refused.
+    const uint32_t rates[] = {300000UL, 100000UL, 200000UL};
+    CHECK_EQ(tuner.qualify(pot, rates, 3), 0);
+    CHECK_EQ(tuner.get_max_passing(), 200000UL);
+    CHECK_EQ(tuner.qualify(pot, rates, 0), EC_BAD_REGISTER);
+
+    // Errors burst at the qualified rate: the attached tuner moves down, and back up when clean.
+    // A monitor installed before keeps seeing every transaction, and comes back on detach().
+    AD525x::set_bus_monitor(count, (void *)1);
+    limit.clock_hz = 1000000UL;
+    CHECK_EQ(tuner.qualify(pot), 0);
+    uint32_t seen = monitored;
+    pot.read_EEMEM(0);
+    uint32_t per_read = monitored - seen;
+    CHECK(per_read > 0);
+
+    tuner.attach();
+    seen = monitored;
+    uint32_t reads = 0;
+
+    limit.clock_hz = 250000UL;
+    limit.above = 0.5;
+    for (uint16_t i = 0; i < 200; i++, reads++) {
+        pot.read_EEMEM(i & 15);
+    }
+    CHECK(tuner.get_fallbacks() > 0);
+    CHECK(tuner.get_rate() <= 200000UL);
+
+    limit.clock_hz = 1000000UL;
+    for (uint16_t i = 0; i < 20000 && tuner.get_rate() < 400000UL; i++, reads++) {
+        pot.read_EEMEM(i & 15);
+    }
+    CHECK(tuner.get_upshifts() > 0);
+    CHECK_EQ(tuner.get_rate(), 400000UL);
+
+    CHECK_EQ(monitored - seen, reads * per_read);
+
+    tuner.detach();
+    void *context = NULL;
+    CHECK(AD525x::get_bus_monitor(&context) == count);
+    CHECK(context == (void *)1);
+
+    return check_result("test_bus_tuner");
+}
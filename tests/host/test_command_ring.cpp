@@ -0,0 +1,64 @@
+/** @file
+Check `AD525xCommandRing`: pushes are coalesced per RDAC when drained, a full ring counts its
+overflows, a value the device refuses is dropped rather than retried forever, and a write that
+fails on the bus is retried.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_CommandRing.h>
+#include <AD525x_Errors.h>
+
+int main() {
+    sim_reset(63);
+    AD5253 pot;
+    pot.initialize(0);
+    AD525xCommandRing ring(pot);
+
+    // Three setpoints for RDAC 0 and two for RDAC 1 make one write each, to the latest value.
+    CHECK_EQ(ring.push(0, 10), EC_NO_ERR);
+    CHECK_EQ(ring.push(1, 20), EC_NO_ERR);
+    CHECK_EQ(ring.push(0, 11), EC_NO_ERR);
+    CHECK_EQ(ring.push(1, 21), EC_NO_ERR);
+    CHECK_EQ(ring.push(0, 12), EC_NO_ERR);
+    CHECK_EQ(ring.get_pending(), 5);
+
+    uint32_t before = sim.transactions;
+    CHECK_EQ(ring.drain(), EC_NO_ERR);
+    CHECK_EQ(sim.transactions - before, 2);
+    CHECK_EQ(sim.rdac[0], 12);
+    CHECK_EQ(sim.rdac[1], 21);
+    CHECK_EQ(ring.get_coalesced(), 3);
+    CHECK_EQ(ring.get_pending(), 0);
+    CHECK_EQ(ring.get_high_water(), 5);
+
+    // The ring holds AD525X_RING_LEN - 1 entries; the rest are dropped and counted.
+    for (uint8_t i = 0; i < AD525X_RING_LEN + 2; i++) {
+        uint8_t expect = (i < AD525X_RING_LEN - 1) ? EC_NO_ERR : EC_NO_RESOURCES;
+        CHECK_EQ(ring.push(2, i), expect);
+    }
+    CHECK_EQ(ring.get_overflows(), 3);
+    CHECK_EQ(ring.get_pending(), AD525X_RING_LEN - 1);
+    CHECK_EQ(ring.drain(), EC_NO_ERR);
+    CHECK_EQ(sim.rdac[2], AD525X_RING_LEN - 2);
+    CHECK_EQ(ring.get_coalesced(), 3 + AD525X_RING_LEN - 2);
+    CHECK_EQ(ring.get_high_water(), AD525X_RING_LEN - 1);
+
+    // Bad entries are reported once and then forgotten.
+    CHECK_EQ(ring.push(4, 1), EC_NO_ERR);
+    CHECK_EQ(ring.push(3, 64), EC_NO_ERR);
+    CHECK_EQ(ring.drain(), EC_BAD_WIPER_SETTING);
+    before = sim.transactions;
+    CHECK_EQ(ring.drain(), EC_NO_ERR);
+    CHECK_EQ(sim.transactions - before, 0);
+
+    // A write that fails on the bus is kept and goes out on the next drain.
+    CHECK_EQ(ring.push(3, 40), EC_NO_ERR);
+    sim.nack_next = 1;
+    CHECK(ring.drain() != EC_NO_ERR);
+    CHECK(sim.rdac[3] != 40);
+    CHECK_EQ(ring.drain(), EC_NO_ERR);
+    CHECK_EQ(sim.rdac[3], 40);
+
+    return check_result("test_command_ring");
+}
@@ -0,0 +1,93 @@
+/** @file
+Check `AD525xComposite::solve()` against an exhaustive search of every code pair, in series and in
+parallel, on both the AD5253 and the AD5254, with the two RDACs at different tolerances. Also
+checks that an unknown topology is refused, and prints the time of one solve.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_Composite.h>
+#include <AD525x_Errors.h>
+#include <stdio.h>
+
+#define TARGETS 41
+
+static float target(uint8_t t) {
+    // From below the smallest setting to above the largest, for either topology.
+    return 50.0f + t * (21000.0f / (TARGETS - 1));
+}
+
+static float distance(AD525xComposite &c, uint8_t a, uint8_t b, float R) {
+    float err = c.resistance(a, b) - R;
+    return (err < 0) ? -err : err;
+}
+
+static uint32_t check_exhaustive(AD525xComposite &c, uint8_t max_val) {
+    /** Number of targets for which solve() is further from the target than the best pair. */
+    uint32_t worse = 0;
+
+    for (uint8_t t = 0; t < TARGETS; t++) {
+        float R = target(t);
+        float best = -1;
+        for (uint16_t a = 0; a <= max_val; a++) {
+            for (uint16_t b = 0; b <= max_val; b++) {
+                float err = distance(c, a, b, R);
+                if (best < 0 || err < best) { best = err; }
+            }
+        }
+
+        uint8_t a = 0, b = 0;
+        if (c.solve(R, &a, &b)) { worse++; continue; }
+        if (distance(c, a, b, R) > best * 1.0001f + 1e-3f) { worse++; }
+    }
+
+    return worse;
+}
+
+int main() {
+    const uint8_t topologies[2] = {AD525xComposite::series, AD525xComposite::parallel};
+
+    for (uint8_t part = 0; part < 2; part++) {
+        uint8_t max_val = part ? 255 : 63;
+        sim_reset(max_val);
+        sim.tolerance[2] = 0xFC;                // RDAC 1 reads -4.25 %, RDAC 0 +1.5 %.
+        sim.tolerance[3] = 0x40;
+
+        AD5253 pot_3;
+        AD5254 pot_4;
+        AD525x *pot = &pot_3;
+        if (part) { pot = &pot_4; }
+        CHECK_EQ(pot->initialize(0), EC_NO_ERR);
+        CHECK_EQ(pot->get_max_val(), max_val);
+
+        for (uint8_t k = 0; k < 2; k++) {
+            AD525xComposite c(*pot, 0, 1, topologies[k]);
+            CHECK_EQ(c.calibrate(10000, 75), EC_NO_ERR);
+            CHECK_EQ(check_exhaustive(c, max_val), 0);
+
+            uint32_t solves = 0;
+            unsigned long start = micros();
+            for (uint8_t t = 0; t < TARGETS; t++) {
+                uint8_t a, b;
+                c.solve(target(t), &a, &b);
+                solves++;
+            }
+            double us = double(micros() - start) / solves;
+            printf("test_composite: %s, %u codes: %.2f us per solve\n",
+                   k ? "parallel" : "series", max_val + 1, us);
+        }
+    }
+
+    // Anything but series or parallel is refused rather than taken for series.
+    sim_reset();
+    AD5254 pot;
+    pot.initialize(0);
+    AD525xComposite bad(pot, 0, 1, 2);
+    CHECK_EQ(bad.get_err_code(), EC_BAD_REGISTER);
+    CHECK_EQ(bad.calibrate(10000, 75), EC_BAD_REGISTER);
+
+    uint8_t a, b;
+    CHECK_EQ(bad.solve(5000, &a, &b), EC_NOT_INITIALIZED);
+
+    return check_result("test_composite");
+}
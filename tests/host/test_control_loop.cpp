@@ -0,0 +1,95 @@
+/** @file
+Drive `AD525xControlLoop` against a simulated first-order plant: the process value lags the wiper
+with a time constant of `tau` ticks, `y += (gain * wiper - y) / tau`. Checks that the loop settles
+on a reachable setpoint, and that after a long stretch of saturation on an unreachable one it comes
+out of saturation at once instead of unwinding an integral, and that the integral stays bounded
+while the output is in range.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_ControlLoop.h>
+
+struct Plant {
+    int32_t gain;   /*!< Process units per wiper step at steady state. */
+    int32_t tau;    /*!< Time constant, ticks. */
+    int32_t y;
+};
+
+static int32_t feedback(void *context) {
+    Plant *p = (Plant *)context;
+    p->y += (p->gain * sim.rdac[0] - p->y) / p->tau;
+    return p->y;
+}
+
+static int32_t constant(void *context) {
+    return *(int32_t *)context;
+}
+
+static int32_t abs32(int32_t v) {
+    return v < 0 ? -v : v;
+}
+
+int main() {
+    sim_reset();
+    sim.rdac[0] = 0;
+
+    AD5254 pot;
+    CHECK_EQ(pot.initialize(0), 0);
+
+    Plant plant = {4, 4, 0};                // Reaches 0 to 1020.
+    AD525xControlLoop loop(pot, 0, 1000, feedback, &plant);
+    loop.set_gains(1 << 14, 1 << 13, 0);    // kp = 0.25, ki = 0.125 wiper steps per unit.
+
+    // Convergence
+    loop.set_setpoint(600);
+    for (int i = 0; i < 200; i++) {
+        CHECK_EQ(loop.tick(), 0);
+    }
+    CHECK(abs32(plant.y - 600) <= 8);
+    CHECK(abs32(sim.rdac[0] - 150) <= 2);
+    CHECK_EQ(loop.get_output(), sim.rdac[0]);
+    CHECK_EQ(loop.get_ticks(), 200);
+
+    // Saturation on an unreachable setpoint
+    loop.set_setpoint(4000);
+    for (int i = 0; i < 500; i++) {
+        loop.tick();
+    }
+    CHECK_EQ(sim.rdac[0], 255);
+    CHECK(plant.y >= 1000);
+
+    // Anti-windup: 500 ticks at an error of about 3000 would wind an unbounded integral up by
+    // 1.5 million, keeping the wiper pinned for thousands of ticks once the setpoint is reachable.
+    loop.set_setpoint(400);
+    int leave = -1;
+    int32_t lowest = plant.y;
+    for (int i = 0; i < 300; i++) {
+        loop.tick();
+        if (leave < 0 && sim.rdac[0] < 255) { leave = i; }
+        if (plant.y < lowest) { lowest = plant.y; }
+    }
+    CHECK(leave >= 0 && leave <= 2);
+    CHECK(abs32(plant.y - 400) <= 8);
+    CHECK(lowest >= 400 - 100);            // No deep undershoot from a wound-down integral either.
+
+    // A proportional term that holds the output in range while the error stays large must not let
+    // the integral grow without bound: here it would pass 32 bits on the third tick.
+    int32_t input = 0;
+    AD525xControlLoop bound(pot, 1, 1000, constant, &input);
+    bound.set_gains(-2, 1, 0);
+    bound.set_setpoint(1000000000L);
+    for (int i = 0; i < 10; i++) {
+        CHECK_EQ(bound.tick(), 0);
+    }
+
+    // The integral stopped where it alone drives the wiper full scale, so an error of that size
+    // in the other direction cancels it.
+    bound.set_gains(0, 1, 0);
+    bound.set_setpoint(0);
+    input = 255L << 16;
+    CHECK_EQ(bound.tick(), 0);
+    CHECK_EQ(sim.rdac[1], 0);
+
+    return check_result("test_control_loop");
+}
@@ -0,0 +1,112 @@
+/** @file
+`AD525xCoScheduler` against the simulator: a task waiting out EEMEM programming on one device lets
+tasks on other devices run, status slots report `co_return` values, and a full frame pool refuses
+tasks without touching the heap. Built with -std=c++20 by run.sh.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_Coroutine.h>
+#include <AD525x_Errors.h>
+
+#if defined(AD525X_HAS_COROUTINES)
+
+static AD525xCoScheduler sched;
+static uint32_t sweeps_while_busy;      // Wiper moves done while `backup()` was waiting.
+static bool backup_waiting;
+
+static AD525xTask backup(AD525x &pot) {
+    for (uint8_t reg = 0; reg < 3; reg++) {
+        AD525xResult r = co_await sched.write_EEMEM(pot, 4 + reg, 10 + reg);
+        if (!r.ok()) { co_return r.err; }
+        backup_waiting = true;
+    }
+
+    AD525xResult r = co_await sched.read_EEMEM(pot, 6);     // Waits out the last write.
+    backup_waiting = false;
+    co_return r.ok() ? r.value : 0;
+}
+
+static AD525xTask sweep(AD525x &pot, uint8_t steps) {
+    for (uint8_t i = 0; i < steps; i++) {
+        AD525xResult r = co_await sched.move_RDAC(pot, 1, i);
+        if (!r.ok()) { co_return r.err; }
+        if (backup_waiting) { sweeps_while_busy++; }
+        co_await sched.yield();
+    }
+
+    co_return EC_NO_ERR;
+}
+
+static AD525xTask idle(uint32_t ms) {
+    co_await sched.sleep_ms(ms);
+    co_return 7;
+}
+
+int main() {
+    sim_reset();
+    AD5254 a, b;
+    a.initialize(0);
+    b.initialize(1);
+
+    // EEMEM programming on `a` overlaps the sweep on `b`: three writes take about three
+    // programming times, not three plus the sweep.
+    volatile uint8_t backup_status = 0, sweep_status = 0;
+    uint32_t start = micros();
+    CHECK_EQ(sched.spawn(backup(a), &backup_status), EC_NO_ERR);
+    CHECK_EQ(sched.spawn(sweep(b, 40), &sweep_status), EC_NO_ERR);
+    CHECK_EQ(backup_status, AD525X_CORO_PENDING);
+    CHECK_EQ(sweep_status, AD525X_CORO_PENDING);
+    CHECK_EQ(sched.get_active(), 2);
+
+    sched.run();
+    uint32_t elapsed = micros() - start;
+
+    CHECK_EQ(backup_status, 12);
+    CHECK_EQ(sweep_status, EC_NO_ERR);
+    CHECK_EQ(sim.eemem[4], 10);
+    CHECK_EQ(sim.eemem[6], 12);
+    CHECK_EQ(sim.rdac[1], 39);
+    CHECK(sweeps_while_busy >= 39);
+    CHECK(elapsed >= 3 * AD525X_EEMEM_WRITE_MS * 1000UL);
+    CHECK(elapsed < 4 * AD525X_EEMEM_WRITE_MS * 1000UL);
+    CHECK_EQ(sched.get_busy_high_water(), 1);
+    CHECK_EQ(sched.get_active(), 0);
+
+    // A full pool: tasks beyond AD525X_CORO_MAX_TASKS get no frame, and spawn() refuses them.
+    volatile uint8_t status[AD525X_CORO_MAX_TASKS + 1];
+    for (uint8_t i = 0; i < AD525X_CORO_MAX_TASKS; i++) {
+        CHECK_EQ(sched.spawn(idle(1), &status[i]), EC_NO_ERR);
+    }
+    CHECK_EQ(AD525xCoScheduler::get_frame_high_water(), AD525X_CORO_MAX_TASKS);
+
+    status[AD525X_CORO_MAX_TASKS] = 0;
+    AD525xTask extra = idle(1);
+    CHECK(!extra.valid());
+    CHECK_EQ(sched.spawn(static_cast<AD525xTask &&>(extra), &status[AD525X_CORO_MAX_TASKS]),
+             EC_NO_RESOURCES);
+    CHECK_EQ(status[AD525X_CORO_MAX_TASKS], 0);        // Untouched when refused.
+    CHECK(AD525xCoScheduler::get_largest_frame() <= AD525X_CORO_FRAME_SIZE);
+
+    sched.run();
+    for (uint8_t i = 0; i < AD525X_CORO_MAX_TASKS; i++) {
+        CHECK_EQ(status[i], 7);
+    }
+
+    // Frames return to the pool as tasks finish.
+    volatile uint8_t again = 0;
+    CHECK_EQ(sched.spawn(idle(0), &again), EC_NO_ERR);
+    sched.run();
+    CHECK_EQ(again, 7);
+
+    return check_result("test_coroutine");
+}
+
+#else
+
+int main() {
+    printf("test_coroutine: needs -std=c++20\n");
+    return 1;
+}
+
+#endif
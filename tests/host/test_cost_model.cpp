@@ -0,0 +1,93 @@
+/** @file
+Validate `AD525xCostModel` against a timed simulator that charges 9 clocks per byte plus a hidden
+15 us per transaction: `calibrate()` must recover the hidden overhead, and batch predictions must
+match measured times. Pricing a move must never touch the device.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_CostModel.h>
+#include <AD525x_Errors.h>
+#include <stdio.h>
+
+static uint32_t measure_batch(AD5254 &pot) {
+    /** Time the batch priced by `predict_batch()`. The fastest of 5 runs is kept, since preemption
+    only ever adds time. */
+    uint32_t best = 0xFFFFFFFFUL;
+
+    for (uint8_t run = 0; run < 5; run++) {
+        uint32_t start = micros();
+        for (uint8_t i = 0; i < 8; i++) {
+            pot.write_RDAC(i & 3, 100 + i);
+            pot.read_EEMEM(i);
+        }
+        uint32_t us = micros() - start;
+        if (us < best) { best = us; }
+    }
+
+    return best;
+}
+
+static AD525xCost predict_batch(AD525xCostModel &model) {
+    AD525xCost c = model.none();
+    for (uint8_t i = 0; i < 8; i++) {
+        c.add(model.write_RDAC());
+        c.add(model.read_EEMEM());
+    }
+    return c;
+}
+
+int main() {
+    sim_reset();
+    AD5254 pot;
+    pot.initialize(0);
+
+    // Pricing is side-effect free: no transaction, and the device's error code is kept.
+    AD525xCostModel model;
+    pot.write_RDAC(1, 20);
+    sim.nack_next = 1;
+    pot.write_RDAC(0, 10);
+    uint8_t err = pot.get_err_code();
+    CHECK(err != 0);
+    uint32_t transactions = sim.transactions;
+    CHECK_EQ(model.move_RDAC(pot, 0, 20).transactions, 1);      // Not cached: a write.
+    CHECK_EQ(model.move_RDAC(pot, 1, 20).transactions, 0);      // Cached, and already there.
+    CHECK_EQ(sim.transactions, transactions);
+    CHECK_EQ(pot.get_err_code(), err);
+
+    CHECK_EQ(model.move_RDAC(pot, 1, 21).bytes, 2);             // A one-byte step command.
+    CHECK_EQ(model.move_RDAC(pot, 1, 30).bytes, 3);
+
+    // Moves the driver refuses before the bus cost nothing.
+    AD5253 narrow;
+    narrow.initialize(1);
+    CHECK_EQ(model.move_RDAC(narrow, 0, 64).transactions, 0);   // Above the AD5253's 63.
+    CHECK_EQ(model.move_RDAC(pot, 4, 0).transactions, 0);
+    AD5254 uninitialized;
+    CHECK_EQ(model.move_RDAC(uninitialized, 0, 1).transactions, 0);
+
+    // Calibration against the hidden overhead.
+    sim.timed = true;
+    sim.overhead_us = 15;
+    const uint32_t clocks[] = {100000UL, 400000UL};
+
+    for (uint8_t k = 0; k < 2; k++) {
+        Wire.setClock(clocks[k]);
+        model.set_clock(clocks[k]);
+        CHECK_EQ(model.calibrate(pot), 0);
+
+        uint16_t overhead = model.get_overhead_us();
+        CHECK(overhead >= 13 && overhead <= 17);
+        CHECK(model.get_error_pct() <= 10);
+
+        AD525xCost predicted = predict_batch(model);
+        uint32_t measured = measure_batch(pot);
+        int32_t diff = (int32_t)measured - (int32_t)predicted.wire_us;
+        printf("%6lu Hz: overhead %u us, batch predicted %lu us, measured %lu us (%+.1f%%)\n",
+               (unsigned long)clocks[k], overhead, (unsigned long)predicted.wire_us,
+               (unsigned long)measured, 100.0 * diff / predicted.wire_us);
+        CHECK(diff > -(int32_t)predicted.wire_us / 10 && diff < (int32_t)predicted.wire_us / 10);
+    }
+
+    return check_result("test_cost_model");
+}
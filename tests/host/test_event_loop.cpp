@@ -0,0 +1,59 @@
+/** @file
+Run `AD525xEventSource` in an epoll loop: four EEMEM writes to one device must complete with one
+wakeup each, sleeping through every programming window instead of polling.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_EventLoop.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+int main() {
+    sim_reset();
+    AD5254 pot;
+    pot.initialize(0);
+
+    AD525xScheduler sched;
+    AD525xEventSource source(sched);
+    CHECK_EQ(source.open(), 0);
+
+    int ep = epoll_create1(0);
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    CHECK_EQ(epoll_ctl(ep, EPOLL_CTL_ADD, source.get_fd(), &ev), 0);
+
+    volatile uint8_t status[4];
+    for (uint8_t i = 0; i < 4; i++) {
+        CHECK_EQ(sched.write_EEMEM(pot, 4 + i, 10 + i, AD525X_PRIO_BULK, &status[i]), 0);
+    }
+    CHECK_EQ(source.notify(), 0);
+
+    uint32_t start = millis();
+    uint32_t wakeups = 0;
+    while (sched.get_wait_us() != AD525X_SCHED_IDLE && millis() - start < 1000) {
+        if (epoll_wait(ep, &ev, 1, 1000) == 1) {
+            wakeups++;
+            CHECK_EQ(source.dispatch(), 0);
+        }
+    }
+    uint32_t elapsed = millis() - start;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        CHECK_EQ(status[i], 0);
+        CHECK_EQ(sim.eemem[4 + i], 10 + i);
+    }
+
+    CHECK_EQ(wakeups, 4);
+    CHECK_EQ(source.get_dispatches(), 4);
+    CHECK(elapsed >= 3 * AD525X_EEMEM_WRITE_MS);    // The device was never addressed early.
+    CHECK(elapsed < 4 * AD525X_EEMEM_WRITE_MS + 50);
+
+    // Idle: the fd stays quiet.
+    CHECK_EQ(epoll_wait(ep, &ev, 1, 50), 0);
+
+    ::close(ep);
+    source.close();
+
+    return check_result("test_event_loop");
+}
@@ -0,0 +1,117 @@
+/** @file
+Tear an `AD525xJournal` the way a crash can: a record whose page never reached storage, followed
+by later records that did. Restarting must stop at the gap and erase what follows, so that after
+one more append and a second restart the stale records are not replayed as current state. Run on
+plain memory and on a memory-mapped file.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_Errors.h>
+#include <AD525x_Journal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define RECORD 20
+#define SIZE 4096
+
+static uint8_t buffer[SIZE];
+
+static void commit_wipers(AD525xJournal &journal, AD5254 &pot, uint8_t first, uint8_t n) {
+    /** Append `n` records: wiper 0 set to first, first + 1, ... */
+    for (uint8_t i = 0; i < n; i++) {
+        pot.write_RDAC(0, first + i);
+        CHECK_EQ(journal.commit(pot), 0);
+    }
+}
+
+static uint8_t restored_wiper(AD525xJournal &journal, AD5254 &pot) {
+    pot.invalidate_cache();
+    journal.restore(pot, 0, 0);
+    return pot.is_cached(0) ? pot.read_RDAC_cached(0) : 0xFF;
+}
+
+static void tear_and_restart(uint8_t *storage, const char *path) {
+    AD5254 pot;
+    pot.initialize(0);
+
+    {
+        AD525xJournal journal;
+        CHECK_EQ(path ? journal.open(path, SIZE) : journal.attach(storage, SIZE), 0);
+        commit_wipers(journal, pot, 10, 5);             // Records 0-4: 10 ... 14.
+        CHECK_EQ(journal.get_records(), 5);
+        journal.close();
+    }
+
+    // Record 2 was lost; 3 and 4 made it to storage.
+    if (path) {
+        FILE *f = fopen(path, "r+b");
+        uint8_t zero[RECORD] = {0};
+        fseek(f, 2 * RECORD, SEEK_SET);
+        fwrite(zero, 1, RECORD, f);
+        fclose(f);
+    } else {
+        memset(storage + 2 * RECORD, 0, RECORD);
+    }
+
+    {
+        AD525xJournal journal;
+        CHECK_EQ(path ? journal.open(path, SIZE) : journal.attach(storage, SIZE), 0);
+        CHECK(journal.was_torn());
+        CHECK_EQ(journal.get_records(), 2);
+        CHECK_EQ(restored_wiper(journal, pot), 11);
+
+        commit_wipers(journal, pot, 40, 1);             // New record 2.
+        journal.close();
+    }
+
+    {
+        AD525xJournal journal;
+        CHECK_EQ(path ? journal.open(path, SIZE) : journal.attach(storage, SIZE), 0);
+        CHECK(!journal.was_torn());
+        CHECK_EQ(journal.get_records(), 3);             // Not the stale records 3 and 4.
+        CHECK_EQ(restored_wiper(journal, pot), 40);
+        journal.close();
+    }
+}
+
+int main() {
+    sim_reset();
+
+    tear_and_restart(buffer, NULL);
+
+    // A half-written record is damage too.
+    memset(buffer, 0, sizeof(buffer));
+    AD5254 pot;
+    pot.initialize(0);
+    {
+        AD525xJournal journal;
+        journal.attach(buffer, SIZE);
+        commit_wipers(journal, pot, 10, 3);
+    }
+    buffer[2 * RECORD + 9] ^= 0x40;
+    {
+        AD525xJournal journal;
+        journal.attach(buffer, SIZE);
+        CHECK(journal.was_torn());
+        CHECK_EQ(journal.get_records(), 2);
+        for (uint32_t i = 2 * RECORD; i < SIZE; i++) {
+            if (buffer[i]) {
+                CHECK_EQ(buffer[i], 0);
+                break;
+            }
+        }
+    }
+
+    char path[] = "/tmp/test_journal_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    ::close(fd);
+    unlink(path);
+    tear_and_restart(NULL, path);
+    unlink(path);
+
+    return check_result("test_journal");
+}
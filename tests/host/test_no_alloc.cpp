@@ -0,0 +1,157 @@
+/** @file
+No queued or asynchronous API may touch the heap. `malloc()`, `calloc()`, `realloc()` and the
+global `operator new` are replaced here and count every call made while armed; the workload below
+(scheduler, async bus, command ring, protocol round and scene, plus a coroutine sequence when built
+with `-std=c++20`) runs armed and must count zero.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_Async.h>
+#include <AD525x_CommandRing.h>
+#include <AD525x_Coroutine.h>
+#include <AD525x_Protocol.h>
+#include <AD525x_Scene.h>
+#include <AD525x_Scheduler.h>
+#include <new>
+#include <stdlib.h>
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+extern "C" void __libc_free(void *p);
+
+static volatile bool armed = false;
+static uint32_t allocations = 0;
+
+extern "C" void *malloc(size_t size) {
+    if (armed) { allocations++; }
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size) {
+    if (armed) { allocations++; }
+    return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *p, size_t size) {
+    if (armed) { allocations++; }
+    return __libc_realloc(p, size);
+}
+
+extern "C" void free(void *p) {
+    __libc_free(p);
+}
+
+void *operator new(size_t size) {
+    if (armed) { allocations++; }
+    void *p = __libc_malloc(size ? size : 1);
+    if (p == NULL) { throw std::bad_alloc(); }
+    return p;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept { __libc_free(p); }
+void operator delete[](void *p) noexcept { __libc_free(p); }
+void operator delete(void *p, size_t) noexcept { __libc_free(p); }
+void operator delete[](void *p, size_t) noexcept { __libc_free(p); }
+
+#if AD525X_HAS_COROUTINES
+static AD525xTask sequence(AD525xCoScheduler &co, AD525x &pot) {
+    AD525xResult r = co_await co.write_EEMEM(pot, 8, 0x42);
+    if (!r.ok()) { co_return r.err; }
+    r = co_await co.move_RDAC(pot, 1, 99);
+    co_return r.err;
+}
+#endif
+
+int main() {
+    sim_reset();
+    AD5254 pot;
+    pot.initialize(0);
+
+    // The hooks see allocations made while armed.
+    armed = true;
+    free(malloc(16));
+    delete new uint32_t(1);
+    armed = false;
+    CHECK_EQ(allocations, 2);
+    allocations = 0;
+
+    AD525xScheduler sched;
+    AD525xSimTransport transport(400000UL);
+    AD525xAsyncBus async(AD525xSimTransport::start, &transport);
+    AD525xCommandRing ring(pot);
+    AD525xProtocolServer server;
+    CHECK_EQ(server.add_device(pot), 0);
+    AD525xScene scene(pot);
+    AD525xBatch batch;
+    uint8_t response[AD525X_PROTO_MAX_RESPONSE];
+    uint8_t value = 0;
+
+    armed = true;
+
+    volatile uint8_t status[4];
+    for (uint8_t i = 0; i < 4; i++) {
+        sched.write_EEMEM(pot, 4 + i, 10 + i, AD525X_PRIO_BULK, &status[i]);
+    }
+    sched.write_RDAC(pot, 0, 77, AD525X_PRIO_CRITICAL);
+    sched.read_RDAC(pot, 0, &value);
+    while (sched.get_wait_us() != AD525X_SCHED_IDLE) {
+        sched.service();
+    }
+
+    volatile uint8_t async_status = AD525X_ASYNC_PENDING;
+    async.write_RDAC(pot, 2, 33);
+    async.write_EEMEM(pot, 12, 0x5A);
+    async.read_EEMEM(pot, 12, &value, &async_status);
+    while (!async.idle()) {
+        transport.poll();
+        async.service();
+    }
+
+    for (uint8_t i = 0; i < 40; i++) {
+        ring.push(1, i);
+    }
+    ring.drain();
+
+    batch.add(AD525X_OP_WRITE_RDAC, 0, 3, 200);
+    batch.add(AD525X_OP_READ_EEMEM, 0, 4);
+    uint16_t response_length = server.handle(batch.data(), batch.size(), response);
+
+    scene.set(0, 10);
+    scene.set(1, 20);
+    uint8_t scene_err = scene.apply();
+
+#if AD525X_HAS_COROUTINES
+    AD525xCoScheduler co;
+    volatile uint8_t co_status = AD525X_ASYNC_PENDING;
+    co.spawn(sequence(co, pot), &co_status);
+    co.run();
+#endif
+
+    armed = false;
+
+    CHECK_EQ(allocations, 0);
+    for (uint8_t i = 0; i < 4; i++) {
+        CHECK_EQ(status[i], 0);
+    }
+    CHECK_EQ(sim.eemem[7], 13);
+    CHECK_EQ(async_status, 0);
+    CHECK_EQ(value, 0x5A);
+    CHECK_EQ(sim.rdac[2], 33);
+    CHECK_EQ(response_length, AD525X_PROTO_HEADER_LEN + 2 * AD525X_PROTO_RESULT_LEN);
+    CHECK_EQ(sim.rdac[3], 200);
+    CHECK_EQ(scene_err, 0);
+    CHECK_EQ(sim.rdac[0], 10);
+#if AD525X_HAS_COROUTINES
+    CHECK_EQ(co_status, 0);
+    CHECK_EQ(sim.eemem[8], 0x42);
+    CHECK_EQ(sim.rdac[1], 99);
+#endif
+
+    return check_result("test_no_alloc");
+}
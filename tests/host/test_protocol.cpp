@@ -0,0 +1,173 @@
+/** @file
+Check the request protocol: coalescing of wiper writes within a batch and across the requests of a
+round, the outcome reported for skipped writes, waiting out EEMEM programming per device, and a
+round served over the Unix socket.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_Protocol.h>
+#include <AD525x_Errors.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static uint8_t response[AD525X_PROTO_MAX_RESPONSE];
+
+static uint8_t result(uint8_t i) {
+    return response[AD525X_PROTO_HEADER_LEN + i * AD525X_PROTO_RESULT_LEN];
+}
+
+static int connect_to(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) { return -1; }
+    return fd;
+}
+
+int main() {
+    AD525xBatch batch;
+
+    // A later write that is invalid replaces nothing: the first one must still run.
+    {
+        sim_reset(63);
+        AD5253 pot;
+        pot.initialize(0);
+        AD525xProtocolServer server;
+        server.add_device(pot);
+
+        batch.clear();
+        batch.add(AD525X_OP_WRITE_RDAC, 0, 0, 10);
+        batch.add(AD525X_OP_WRITE_RDAC, 0, 0, 200);
+        CHECK_EQ(server.handle(batch.data(), batch.size(), response), 2 + 2 * 2);
+        CHECK_EQ(result(0), EC_NO_ERR);
+        CHECK_EQ(result(1), EC_BAD_WIPER_SETTING);
+        CHECK_EQ(sim.rdac[0], 10);
+        CHECK_EQ(server.get_coalesced(), 0);
+    }
+
+    sim_reset();
+    AD5254 pot;
+    pot.initialize(0);
+    AD525xProtocolServer server;
+    server.add_device(pot);
+
+    // A replaced write is skipped and reports the outcome of its replacement.
+    batch.clear();
+    batch.add(AD525X_OP_WRITE_RDAC, 0, 1, 10);
+    batch.add(AD525X_OP_WRITE_EEMEM, 0, 5, 1);     // Does not observe the wiper.
+    batch.add(AD525X_OP_WRITE_RDAC, 0, 1, 20);
+    uint32_t tx = sim.transactions;
+    server.handle(batch.data(), batch.size(), response);
+    CHECK_EQ(sim.transactions - tx, 2);
+    CHECK_EQ(result(0), EC_NO_ERR);
+    CHECK_EQ(result(2), EC_NO_ERR);
+    CHECK_EQ(sim.rdac[1], 20);
+    CHECK_EQ(server.get_coalesced(), 1);
+
+    batch.clear();
+    batch.add(AD525X_OP_WRITE_RDAC, 0, 2, 10);
+    batch.add(AD525X_OP_WRITE_RDAC, 0, 2, 30);
+    sim.nack_next = 1;
+    server.handle(batch.data(), batch.size(), response);
+    CHECK(result(1) != EC_NO_ERR);
+    CHECK_EQ(result(0), result(1));
+
+    // A read in between must see the first write.
+    batch.clear();
+    batch.add(AD525X_OP_WRITE_RDAC, 0, 3, 5);
+    batch.add(AD525X_OP_SYNC_RDAC, 0, 3);
+    batch.add(AD525X_OP_WRITE_RDAC, 0, 3, 50);
+    server.handle(batch.data(), batch.size(), response);
+    CHECK_EQ(response[AD525X_PROTO_HEADER_LEN + 1 * AD525X_PROTO_RESULT_LEN + 1], 5);
+    CHECK_EQ(sim.rdac[3], 50);
+    CHECK_EQ(server.get_coalesced(), 2);
+
+    // Requests of one round coalesce with each other.
+    AD525xBatch other;
+    uint8_t other_response[AD525X_PROTO_MAX_RESPONSE];
+    uint16_t len_a, len_b;
+    batch.clear();
+    batch.add(AD525X_OP_WRITE_RDAC, 0, 0, 100);
+    other.add(AD525X_OP_WRITE_RDAC, 0, 0, 110);
+    server.begin_round();
+    CHECK_EQ(server.add_request(batch.data(), batch.size(), response, &len_a), 0);
+    CHECK_EQ(server.add_request(other.data(), other.size(), other_response, &len_b), 0);
+    CHECK_EQ(server.add_request(batch.data(), 3, response, &len_a), EC_BAD_READ_SIZE);
+    tx = sim.transactions;
+    server.run_round();
+    CHECK_EQ(sim.transactions - tx, 1);
+    CHECK_EQ(result(0), EC_NO_ERR);
+    CHECK_EQ(sim.rdac[0], 110);
+    CHECK_EQ(server.get_coalesced(), 3);
+
+    // The device is left alone while it programs EEMEM; other devices are not held up.
+    AD5254 second;
+    second.initialize(1);
+    server.add_device(second);
+    batch.clear();
+    batch.add(AD525X_OP_STORE_RDAC, 0, 0);
+    batch.add(AD525X_OP_WRITE_RDAC, 1, 1, 7);
+    unsigned long start = micros();
+    server.handle(batch.data(), batch.size(), response);
+    CHECK(micros() - start < AD525X_EEMEM_WRITE_MS * 1000UL);
+
+    batch.clear();
+    batch.add(AD525X_OP_WRITE_RDAC, 0, 1, 8);
+    server.handle(batch.data(), batch.size(), response);
+    CHECK(micros() - start >= AD525X_EEMEM_WRITE_MS * 1000UL);
+    CHECK_EQ(result(0), EC_NO_ERR);
+
+    batch.clear();
+    batch.add(AD525X_OP_WRITE_EEMEM, 0, 5, 2);
+    batch.add(AD525X_OP_SYNC_RDAC, 0, 1);
+    start = micros();
+    server.handle(batch.data(), batch.size(), response);
+    CHECK(micros() - start >= AD525X_EEMEM_WRITE_MS * 1000UL);
+    CHECK_EQ(sim.eemem[5], 2);
+
+    // Over the socket: batches waiting from two clients run as one round.
+    const char *path = "/tmp/ad525x_test.sock";
+    AD525xSocketServer sock(server);
+    CHECK_EQ(sock.listen(path), 0);
+
+    int a = connect_to(path), b = connect_to(path);
+    CHECK(a >= 0 && b >= 0);
+    sock.poll_once(100);
+    sock.poll_once(100);
+
+    batch.clear();
+    batch.add(AD525X_OP_WRITE_RDAC, 0, 0, 1);
+    other.clear();
+    other.add(AD525X_OP_WRITE_RDAC, 0, 0, 2);
+    send(a, batch.data(), batch.size(), 0);
+    send(b, other.data(), other.size(), 0);
+    usleep(10000);
+
+    uint32_t rounds = server.get_rounds();
+    CHECK_EQ(sock.poll_once(100), 0);
+    CHECK_EQ(server.get_rounds() - rounds, 1);
+    CHECK_EQ(server.get_coalesced(), 4);
+    CHECK_EQ(recv(a, response, sizeof(response), 0), 4);
+    CHECK_EQ(result(0), EC_NO_ERR);
+    CHECK_EQ(recv(b, response, sizeof(response), 0), 4);
+    CHECK_EQ(sim.rdac[0], 2);
+
+    // A malformed request drops only its client.
+    send(a, "x", 1, 0);
+    send(b, batch.data(), batch.size(), 0);
+    usleep(10000);
+    sock.poll_once(100);
+    CHECK_EQ(recv(b, response, sizeof(response), 0), 4);
+    CHECK_EQ(recv(a, response, sizeof(response), 0), 0);
+
+    ::close(a);
+    ::close(b);
+    sock.close();
+
+    return check_result("test_protocol");
+}
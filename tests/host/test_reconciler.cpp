@@ -0,0 +1,41 @@
+/** @file
+Check `AD525xReconciler`: an out-of-range RDAC value for EEMEM is refused when it is declared, and
+an EEMEM write that fails on the bus does not hold up the other registers of the device.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_Reconciler.h>
+#include <AD525x_Errors.h>
+
+int main() {
+    sim_reset(63);
+    AD5253 pot;
+    pot.initialize(0);
+    AD525xReconciler rec;
+
+    CHECK_EQ(rec.set_EEMEM(pot, 0, 64), EC_BAD_WIPER_SETTING);
+    CHECK_EQ(rec.set_EEMEM(pot, 4, 200), EC_NO_ERR);
+    CHECK_EQ(rec.set_EEMEM(pot, 16, 1), EC_BAD_REGISTER);
+    CHECK_EQ(rec.reconcile(), EC_NO_ERR);
+    CHECK_EQ(sim.eemem[4], 200);
+    delay(AD525X_EEMEM_WRITE_MS + 1);
+
+    // Register 1 fails; the same pass goes on to register 2.
+    CHECK_EQ(rec.set_EEMEM(pot, 1, 10), EC_NO_ERR);
+    CHECK_EQ(rec.set_EEMEM(pot, 2, 20), EC_NO_ERR);
+    sim.nack_next = 1;
+    CHECK(rec.reconcile() != EC_NO_ERR);
+    CHECK_EQ(sim.eemem[1], 0);
+    CHECK_EQ(sim.eemem[2], 20);
+    CHECK(!rec.converged());
+
+    // The failed register is retried once the device has finished programming.
+    delay(AD525X_EEMEM_WRITE_MS + 1);
+    CHECK_EQ(rec.reconcile(), EC_NO_ERR);
+    CHECK_EQ(sim.eemem[1], 10);
+    CHECK(rec.converged());
+    CHECK_EQ(rec.get_retries(), 1);
+
+    return check_result("test_reconciler");
+}
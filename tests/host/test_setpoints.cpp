@@ -0,0 +1,86 @@
+/** @file
+Check the shared setpoint table: initialization only of zero-filled memory, layout checks, the
+bounded snapshot read, and a round trip through POSIX shared memory.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_Setpoints.h>
+#include <AD525x_Errors.h>
+#include <sys/mman.h>
+
+static AD525xSetpointTable table;
+
+int main() {
+    sim_reset();
+    AD5254 pot;
+    pot.initialize(0);
+
+    uint8_t hw[AD525X_SETPOINT_MAX_DEVICES][4];
+    uint8_t known[AD525X_SETPOINT_MAX_DEVICES];
+
+    // A zero-filled table is initialized once; attaching again keeps its contents.
+    AD525xSetpoints owner, client;
+    CHECK_EQ(owner.attach(&table), 0);
+    CHECK_EQ(table.magic, AD525X_SETPOINT_MAGIC);
+    CHECK_EQ(table.size, sizeof(table));
+    CHECK_EQ(owner.add_device(pot), 0);
+    CHECK_EQ(owner.set(0, 3, 55), 0);
+    CHECK_EQ(client.attach(&table), 0);
+    CHECK_EQ(client.set(0, 2, 77), 0);
+    CHECK_EQ(owner.sync(), 0);
+    CHECK_EQ(sim.rdac[2], 77);
+    CHECK_EQ(sim.rdac[3], 55);
+
+    CHECK_EQ(client.snapshot(hw, known), 0);
+    CHECK_EQ(hw[0][2], 77);
+    CHECK(known[0] & (1 << 2));
+
+    // A stuck writer makes the snapshot fail instead of spinning for ever.
+    table.hw_seq++;
+    CHECK_EQ(client.snapshot(hw, known), EC_STORAGE);
+    table.hw_seq++;
+    CHECK_EQ(client.snapshot(hw, known), 0);
+
+    // An owner that died mid-publish leaves the counter odd. Its successor keeps the table, and
+    // its first publish must restore the parity: even once done, so snapshots succeed again.
+    table.hw_seq++;
+    AD525xSetpoints successor;
+    CHECK_EQ(successor.attach(&table), 0);
+    CHECK_EQ(successor.add_device(pot), 0);
+    CHECK_EQ(client.set(0, 2, 78), 0);
+    CHECK_EQ(successor.sync(), 0);
+    CHECK_EQ(table.hw_seq & 1, 0);
+    CHECK_EQ(client.snapshot(hw, known), 0);
+    CHECK_EQ(hw[0][2], 78);
+    CHECK_EQ(successor.sync(), 0);
+    CHECK_EQ(table.hw_seq & 1, 0);
+
+    // Tables of another layout, or foreign data, are refused rather than wiped.
+    static AD525xSetpointTable other;
+    AD525xSetpoints third;
+    other.magic = AD525X_SETPOINT_MAGIC;
+    other.size = sizeof(other) - 4;
+    CHECK_EQ(third.attach(&other), EC_BAD_CHECKSUM);
+    other.magic = 0x12345678;
+    CHECK_EQ(third.attach(&other), EC_BAD_CHECKSUM);
+    CHECK_EQ(other.magic, 0x12345678);
+    CHECK_EQ(third.set(0, 0, 1), EC_NOT_INITIALIZED);
+
+    // Shared memory: clients wait for the owner, then see its table.
+    const char *name = "/ad525x_test_setpoints";
+    shm_unlink(name);
+    AD525xSetpoints shm_owner, shm_client;
+    CHECK_EQ(shm_client.open(name, false), EC_STORAGE);
+    CHECK_EQ(shm_owner.open(name, true), 0);
+    CHECK_EQ(shm_client.open(name, false), 0);
+    CHECK_EQ(shm_owner.add_device(pot), 0);
+    CHECK_EQ(shm_client.set(0, 1, 9), 0);
+    CHECK_EQ(shm_owner.sync(), 0);
+    CHECK_EQ(sim.rdac[1], 9);
+    shm_client.close();
+    shm_owner.close();
+    shm_unlink(name);
+
+    return check_result("test_setpoints");
+}
@@ -0,0 +1,117 @@
+/** @file
+`AD525xShared` from several threads: two devices on each of two buses, each with a writer thread
+that owns one wiper, while reader threads poll every wiper through `read_cached()`. Writers check
+their own wiper on the bus now and then, so a transaction interleaved on a bus shows up as a wrong
+value. Build with `CXXFLAGS=-fsanitize=thread` to check for data races as well.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_ThreadSafe.h>
+#include <AD525x_Errors.h>
+#include <pthread.h>
+
+#define N_DEVICES 4
+#define N_READERS 2
+#define N_WRITES 5000
+
+struct Writer {
+    AD525xShared *dev;
+    uint8_t RDAC;               /*!< Wiper written only by this thread (the simulator has one). */
+    uint32_t errors;
+};
+
+struct Reader {
+    AD525xShared **dev;
+    uint32_t reads;
+    uint32_t errors;
+};
+
+static bool writers_done;
+
+static void *write_loop(void *arg) {
+    Writer *w = (Writer *)arg;
+
+    for (uint32_t i = 0; i < N_WRITES; i++) {
+        uint8_t value = (i * 2) & 0xFF;                 // Always even; readers check that.
+
+        if (i & 1) {
+            if (w->dev->move_RDAC(w->RDAC, value)) { w->errors++; }
+        } else if (w->dev->write_RDAC(w->RDAC, value)) {
+            w->errors++;
+        }
+
+        if (i % 64 == 0) {
+            uint8_t read = 0;
+            if (w->dev->read_RDAC(w->RDAC, &read) || read != value) { w->errors++; }
+        }
+    }
+
+    return NULL;
+}
+
+static void *read_loop(void *arg) {
+    Reader *r = (Reader *)arg;
+
+    while (!__atomic_load_n(&writers_done, __ATOMIC_ACQUIRE)) {
+        for (uint8_t k = 0; k < N_DEVICES; k++) {
+            uint8_t value = 1;
+            if (r->dev[k]->read_cached(k, &value) || (value & 1)) { r->errors++; }
+            r->reads++;
+        }
+    }
+
+    return NULL;
+}
+
+int main() {
+    sim_reset();
+
+    TwoWire second;
+    AD525xBusLock lock_a, lock_b;
+    AD5254 pot[N_DEVICES];
+
+    for (uint8_t k = 0; k < N_DEVICES; k++) {
+        CHECK_EQ(pot[k].initialize(k, (k < 2) ? Wire : second), EC_NO_ERR);
+        CHECK_EQ(pot[k].write_RDAC(k, 0), EC_NO_ERR);   // Start cached, so reads stay lock-free.
+    }
+
+    AD525xShared a0(pot[0], lock_a), a1(pot[1], lock_a), b0(pot[2], lock_b), b1(pot[3], lock_b);
+    AD525xShared *dev[N_DEVICES] = {&a0, &a1, &b0, &b1};
+
+    pthread_t writer_thread[N_DEVICES], reader_thread[N_READERS];
+    Writer writer[N_DEVICES];
+    Reader reader[N_READERS];
+
+    for (uint8_t k = 0; k < N_READERS; k++) {
+        reader[k] = {dev, 0, 0};
+        pthread_create(&reader_thread[k], NULL, read_loop, &reader[k]);
+    }
+    for (uint8_t k = 0; k < N_DEVICES; k++) {
+        writer[k] = {dev[k], k, 0};
+        pthread_create(&writer_thread[k], NULL, write_loop, &writer[k]);
+    }
+
+    for (uint8_t k = 0; k < N_DEVICES; k++) {
+        pthread_join(writer_thread[k], NULL);
+    }
+    __atomic_store_n(&writers_done, true, __ATOMIC_RELEASE);
+    for (uint8_t k = 0; k < N_READERS; k++) {
+        pthread_join(reader_thread[k], NULL);
+    }
+
+    for (uint8_t k = 0; k < N_DEVICES; k++) {
+        CHECK_EQ(writer[k].errors, 0);
+        CHECK_EQ(sim.rdac[k], ((N_WRITES - 1) * 2) & 0xFF);
+
+        uint8_t value = 0;
+        CHECK_EQ(dev[k]->read_cached(k, &value), EC_NO_ERR);
+        CHECK_EQ(value, sim.rdac[k]);
+    }
+    for (uint8_t k = 0; k < N_READERS; k++) {
+        CHECK_EQ(reader[k].errors, 0);
+        CHECK(reader[k].reads > 0);
+    }
+
+    return check_result("test_thread_safe");
+}
@@ -0,0 +1,58 @@
+/** @file
+Check `AD525xWearManager`: an out-of-range RDAC value is refused when it is requested, and a
+register that fails on the bus does not hold up the registers after it.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_Wear.h>
+#include <AD525x_Errors.h>
+
+static void wait_programmed() {
+    delay(AD525X_EEMEM_WRITE_MS + 1);
+}
+
+int main() {
+    sim_reset(63);
+    AD5253 pot;
+    pot.initialize(0);
+    AD525xWearManager wear(pot, 0);
+
+    // RDAC registers hold wiper settings; user registers take any byte.
+    CHECK_EQ(wear.write_EEMEM(0, 64), EC_BAD_WIPER_SETTING);
+    CHECK_EQ(wear.write_EEMEM(3, 200), EC_BAD_WIPER_SETTING);
+    CHECK_EQ(wear.write_EEMEM(4, 200), EC_NO_ERR);
+    CHECK_EQ(wear.write_EEMEM(16, 1), EC_BAD_REGISTER);
+    CHECK_EQ(wear.flush(), EC_NO_ERR);
+    CHECK_EQ(sim.eemem[4], 200);
+    CHECK_EQ(wear.get_write_count(0), 0);
+
+    // After register 1 fails, the next service moves on to register 2 instead of retrying it.
+    CHECK_EQ(wear.write_EEMEM(1, 10), EC_NO_ERR);
+    CHECK_EQ(wear.write_EEMEM(2, 20), EC_NO_ERR);
+    CHECK_EQ(wear.write_EEMEM(5, 50), EC_NO_ERR);
+
+    sim.nack_next = 1;
+    CHECK(wear.service() != EC_NO_ERR);
+    CHECK_EQ(sim.eemem[1], 0);
+
+    CHECK_EQ(wear.service(), EC_NO_ERR);
+    CHECK_EQ(sim.eemem[2], 20);
+    CHECK_EQ(sim.eemem[1], 0);
+
+    // A failure on register 5 also passes the turn back round to register 1.
+    wait_programmed();
+    sim.nack_next = 1;
+    CHECK(wear.service() != EC_NO_ERR);
+    CHECK_EQ(sim.eemem[5], 0);
+
+    CHECK_EQ(wear.service(), EC_NO_ERR);
+    CHECK_EQ(sim.eemem[1], 10);
+    CHECK_EQ(wear.get_write_count(1), 1);
+
+    wait_programmed();
+    CHECK_EQ(wear.service(), EC_NO_ERR);
+    CHECK_EQ(sim.eemem[5], 50);
+
+    return check_result("test_wear");
+}
@@ -0,0 +1,92 @@
+/** @file
+Check the work-stealing pool: every job runs once, jobs submitted by jobs are waited for, and jobs
+pinned to a worker run on that worker's thread, in submission order.
+*/
+
+#include "AD525x_Sim.h"
+#include "check.h"
+#include <AD525x_WorkPool.h>
+#include <AD525x_Errors.h>
+#include <string.h>
+
+static AD525xWorkPool pool;
+static uint32_t runs[200];
+static uint32_t children;
+
+static void spin(uint32_t n) {
+    volatile uint32_t x = 0;
+    for (uint32_t i = 0; i < n; i++) { x = x + i; }
+}
+
+static void child(void *arg) {
+    (void)arg;
+    __atomic_fetch_add(&children, 1, __ATOMIC_RELAXED);
+}
+
+static void job(void *arg) {
+    uint32_t i = (uint32_t)(uintptr_t)arg;
+    spin((i % 7) * 2000);                   // Uneven, so stealing has work to do.
+    __atomic_fetch_add(&runs[i], 1, __ATOMIC_RELAXED);
+    if (i % 10 == 0) { pool.submit(child, NULL); }
+}
+
+static pthread_t pinned_thread[64];
+static uint32_t pinned_order[64];
+static uint32_t pinned_next;
+
+static void pinned(void *arg) {
+    uint32_t i = (uint32_t)(uintptr_t)arg;
+    pinned_thread[i] = pthread_self();
+    pinned_order[i] = pinned_next++;        // Only ever touched by the one pinned worker.
+}
+
+int main() {
+    CHECK_EQ(pool.submit(job, NULL), EC_NOT_INITIALIZED);
+    CHECK_EQ(pool.start(0), EC_BAD_REGISTER);
+
+    for (uint8_t workers = 1; workers <= 8; workers *= 2) {
+        memset(runs, 0, sizeof(runs));
+        children = 0;
+
+        uint32_t executed = pool.get_executed();
+        CHECK_EQ(pool.start(workers), 0);
+        CHECK_EQ(pool.get_workers(), workers);
+
+        // Fewer jobs than one deque holds, so a job's own submission can never find it full.
+        for (uint32_t i = 0; i < 200; i++) {
+            CHECK_EQ(pool.submit(job, (void *)(uintptr_t)i), 0);
+        }
+        pool.wait_idle();
+
+        uint32_t wrong = 0;
+        for (uint32_t i = 0; i < 200; i++) {
+            if (runs[i] != 1) { wrong++; }
+        }
+        CHECK_EQ(wrong, 0);
+        CHECK_EQ(children, 20);
+        CHECK_EQ(pool.get_executed() - executed, 220);
+
+        pool.stop();
+    }
+
+    // Pinned jobs
+    CHECK_EQ(pool.start(4), 0);
+    CHECK_EQ(pool.submit_to(4, pinned, NULL), EC_BAD_REGISTER);
+
+    for (uint32_t i = 0; i < 200; i++) {
+        pool.submit(job, (void *)(uintptr_t)i);     // Background work to steal.
+    }
+    for (uint32_t i = 0; i < 32; i++) {
+        CHECK_EQ(pool.submit_to(2, pinned, (void *)(uintptr_t)i), 0);
+    }
+    pool.wait_idle();
+
+    for (uint32_t i = 0; i < 32; i++) {
+        CHECK(pthread_equal(pinned_thread[i], pinned_thread[0]));
+        CHECK_EQ(pinned_order[i], i);
+    }
+
+    pool.stop();
+
+    return check_result("test_work_pool");
+}